@@ -13,10 +13,46 @@
 // Include ESP32 logging utilities (not used in this code but included for completeness)
 #include "esp_log.h"
 
+// Include cycle counters (shared component in ../components)
+#include "perf_counter.h"
+
 // Define a constant for the GPIO pin number connected to the LED
 // GPIO 2 is commonly connected to the onboard LED on most ESP32 development boards
 #define BLINK_GPIO 2
 
+// GPIO toggle rate measurement at startup: batches of back-to-back toggles
+#define TOGGLE_BATCH 1000
+#define TOGGLE_BATCHES 20
+
+// Cycle counter for one batch of TOGGLE_BATCH level changes
+static perf_counter_t toggle_perf = PERF_COUNTER_INIT("gpio_toggle_x1000");
+
+// Toggle the pin as fast as gpio_set_level() allows and report the rate
+// (a few milliseconds of fast flicker before the first blink)
+static void measure_toggle_rate(void)
+{
+    for (int batch = 0; batch < TOGGLE_BATCHES; batch++)
+    {
+        uint32_t start = PERF_COUNTER_START();
+        for (int i = 0; i < TOGGLE_BATCH; i += 2)
+        {
+            gpio_set_level(BLINK_GPIO, 1);
+            gpio_set_level(BLINK_GPIO, 0);
+        }
+        PERF_COUNTER_STOP(&toggle_perf, start);
+    }
+
+    // One "PERF {...}" JSON line plus the rate derived from the mean batch
+    perf_counter_print_json();
+    if (toggle_perf.count > 0)
+    {
+        uint64_t cycles = toggle_perf.total / toggle_perf.count;
+        printf("GPIO toggle rate: %llu toggles/s (%llu cycles per toggle)\n",
+               (unsigned long long)perf_counter_ticks_per_second() * TOGGLE_BATCH / cycles,
+               (unsigned long long)cycles / TOGGLE_BATCH);
+    }
+}
+
 // Main application function - this is the entry point for ESP32 programs
 // Unlike standard C programs with main(), ESP32 uses app_main() as the starting point
 void app_main(void)
@@ -33,6 +69,9 @@ void app_main(void)
     // This appears in the serial monitor when you connect to the ESP32
     printf("ESP32 Blink Started!\n");
 
+    // Measure how fast the pin can be toggled before blinking slowly
+    measure_toggle_rate();
+
     // Infinite loop - ESP32 programs typically run forever
     // This keeps the program running continuously until power is removed
     while (1)
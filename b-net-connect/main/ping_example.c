@@ -4,11 +4,8 @@
 // Include ESP32 networking headers for WiFi functionality
 #include "esp_wifi.h"
 
-// Include ESP32 networking headers for TCP/IP stack
-#include "esp_netif.h"
-
-// Include ESP32 event handling system
-#include "esp_event.h"
+// Include the shared WiFi link (cached AP, fast reconnect, retries forever)
+#include "wifi_link.h"
 
 // Include FreeRTOS headers for real-time operating system functions
 #include "freertos/FreeRTOS.h"
@@ -22,9 +19,6 @@
 // Include standard string library for string manipulation functions
 #include "string.h"
 
-// Include standard library for malloc/free
-#include "stdlib.h"
-
 // Include LwIP headers for Lightweight IP stack (network protocols)
 #include "lwip/err.h"
 
@@ -34,18 +28,24 @@
 // Include LwIP DNS resolver for hostname to IP address conversion
 #include "lwip/netdb.h"
 
-// Include ICMP protocol headers for ping functionality
-#include "lwip/icmp.h"
-
-// Include IP protocol headers for IP packet handling
-#include "lwip/inet_chksum.h"
-
 // Include IP address handling utilities
 #include "lwip/inet.h"
 
 // Include non-volatile storage for WiFi configuration
 #include "nvs_flash.h"
 
+// Include the shared echo request builder and reply matcher
+#include "icmp_probe.h"
+
+// Include cycle counters to measure the packet build cost
+#include "perf_counter.h"
+
+// Include the binary event trace
+#include "trace_ring.h"
+
+// Include deferred logging (formatting happens in a low-priority task)
+#include "dlog.h"
+
 // Define a tag for logging - appears in serial monitor output
 static const char *TAG = "PING_EXAMPLE";
 
@@ -59,9 +59,6 @@ static const char *TAG = "PING_EXAMPLE";
 // Define ping interval in milliseconds
 #define PING_INTERVAL 2000 // Ping every 2 seconds
 
-// Define ping packet size in bytes
-#define PING_DATA_SIZE 32 // 32 bytes of data in ping packet
-
 // Define ping timeout in milliseconds
 #define PING_TIMEOUT 1000 // Wait 1 second for ping response
 
@@ -71,108 +68,44 @@ static ip_addr_t target_addr;
 // Global counter for ping sequence numbers
 static uint16_t ping_seq = 0;
 
-// Function to handle WiFi events (connection, disconnection, etc.)
-static void wifi_event_handler(void *arg, esp_event_base_t event_base,
-                               int32_t event_id, void *event_data)
-{
-    // Check if this is a WiFi station (client) event
-    if (event_base == WIFI_EVENT)
-    {
-        // Handle specific WiFi events
-        if (event_id == WIFI_EVENT_STA_START)
-        {
-            // Event: WiFi station started successfully
-            ESP_LOGI(TAG, "WiFi station started");
+// ICMP socket, opened by the first ping and kept open (-1 = not open)
+static int ping_sock = -1;
 
-            // Connect to the configured WiFi network
-            esp_wifi_connect();
-        }
-        else if (event_id == WIFI_EVENT_STA_DISCONNECTED)
-        {
-            // Event: WiFi disconnected
-            ESP_LOGW(TAG, "WiFi disconnected, trying to reconnect...");
-
-            // Try to reconnect after 5 second delay
-            vTaskDelay(5000 / portTICK_PERIOD_MS);
+// ICMP echo request (8-byte header + 32 bytes of data), reused by every ping
+static uint8_t ping_packet[ICMP_PROBE_PACKET_SIZE];
 
-            // Attempt to reconnect to WiFi
-            esp_wifi_connect();
-        }
-    }
-    // Check if this is an IP event
-    else if (event_base == IP_EVENT)
-    {
-        // Handle specific IP events
-        if (event_id == IP_EVENT_STA_GOT_IP)
-        {
-            // Event: Got IP address from DHCP server
-            ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
+// Print the cycle counters after this many pings
+#define PERF_REPORT_PINGS 10
 
-            // Log the obtained IP address
-            ESP_LOGI(TAG, "Got IP address: " IPSTR, IP2STR(&event->ip_info.ip));
+// Cycle counter for building the ICMP packet including its checksum
+static perf_counter_t icmp_build_perf = PERF_COUNTER_INIT("icmp_build_checksum");
 
-            // Convert string IP to binary format and store in target_addr
-            // ipaddr_addr() converts dotted-decimal string to 32-bit IP address
-            ip4_addr_set_u32(&target_addr.u_addr.ip4, ipaddr_addr(PING_TARGET));
+// Cycle counter for recording one trace event (the cost the trace adds per event)
+static perf_counter_t trace_event_perf = PERF_COUNTER_INIT("trace_event");
 
-            // Log the target IP
-            ESP_LOGI(TAG, "Ping target: %s", PING_TARGET);
-        }
-    }
-}
+// Dump the event trace to the serial port after this many pings (0 = never)
+#define TRACE_DUMP_PINGS CONFIG_PING_TRACE_DUMP_PINGS
 
-// Function to initialize WiFi connection
-static void wifi_init_sta(void)
+// Trace event IDs (names are registered in app_main)
+enum
 {
-    // Initialize the underlying TCP/IP stack
-    ESP_ERROR_CHECK(esp_netif_init());
-
-    // Create the default event loop for handling system events
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
-
-    // Create default WiFi station (client) network interface
-    esp_netif_create_default_wifi_sta();
-
-    // Initialize WiFi with default configuration
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
-
-    // Create event handler for WiFi and IP events
-    ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT,
-                                                        ESP_EVENT_ANY_ID,
-                                                        &wifi_event_handler,
-                                                        NULL,
-                                                        NULL));
-    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT,
-                                                        IP_EVENT_STA_GOT_IP,
-                                                        &wifi_event_handler,
-                                                        NULL,
-                                                        NULL));
-
-    // Configure WiFi as station (client) mode
-    wifi_config_t wifi_config = {
-        .sta = {
-            .ssid = WIFI_SSID,                        // Set WiFi SSID from macro
-            .password = WIFI_PASSWORD,                // Set WiFi password from macro
-            .threshold.authmode = WIFI_AUTH_WPA2_PSK, // Minimum auth mode required
-        },
-    };
-
-    // Set WiFi mode to station (client) only (not access point)
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-
-    // Apply the WiFi configuration
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
-
-    // Start WiFi
-    ESP_ERROR_CHECK(esp_wifi_start());
-
-    // Log that WiFi initialization is complete
-    ESP_LOGI(TAG, "WiFi initialization finished");
+    TRACE_ID_PING = 1, // ping_target(), arg = sequence number
+    TRACE_ID_BUILD,    // ICMP packet build and checksum
+    TRACE_ID_SEND,     // Echo request sent, arg = sequence number
+    TRACE_ID_REPLY,    // Echo reply received, arg = RTT in ticks
+    TRACE_ID_TIMEOUT,  // No reply within PING_TIMEOUT
+};
+
+#if TRACE_DUMP_PINGS > 0
+// Function to write trace dump lines to the serial port
+static void trace_uart_write(void *ctx, const char *data, size_t len)
+{
+    fwrite(data, 1, len, stdout);
 }
+#endif
 
-// Function to send a ping (ICMP echo request) and wait for response
-static void ping_target(void)
+// Function to open the ICMP socket used by every ping
+static int ping_open_socket(void)
 {
     // Create a raw socket for ICMP protocol
     // AF_INET = IPv4, SOCK_RAW = raw socket, IPPROTO_ICMP = ICMP protocol
@@ -183,7 +116,7 @@ static void ping_target(void)
     {
         // Socket creation failed
         ESP_LOGE(TAG, "Failed to create socket: error %d", errno);
-        return;
+        return -1;
     }
 
     // Set socket timeout for receive operations
@@ -196,41 +129,43 @@ static void ping_target(void)
     {
         ESP_LOGE(TAG, "Failed to set socket timeout");
         close(sock);
-        return;
+        return -1;
     }
+    return sock;
+}
 
-    // Create ICMP packet (ping) structure
-    struct icmp_echo_hdr *icmp_pkt;
-
-    // Allocate memory for ICMP packet + data
-    icmp_pkt = (struct icmp_echo_hdr *)malloc(sizeof(struct icmp_echo_hdr) + PING_DATA_SIZE);
-
-    // Check if memory allocation failed
-    if (icmp_pkt == NULL)
+// Function to send a ping (ICMP echo request) and wait for response
+static void ping_target(void)
+{
+    // The socket and packet buffer are reused: no allocation per ping
+    if (ping_sock < 0)
     {
-        // Memory allocation failed
-        ESP_LOGE(TAG, "Failed to allocate memory for ICMP packet");
-        close(sock);
-        return;
+        ping_sock = ping_open_socket();
+        if (ping_sock < 0)
+        {
+            return;
+        }
     }
+    int sock = ping_sock;
 
-    // Initialize ICMP packet
-    ICMPH_TYPE_SET(icmp_pkt, ICMP_ECHO); // Set type to Echo Request (8)
-    ICMPH_CODE_SET(icmp_pkt, 0);         // Set code to 0
-    icmp_pkt->chksum = 0;                // Initialize checksum to 0 (calculated later)
-    icmp_pkt->id = 0xABCD;               // Set ICMP identifier (arbitrary value)
-    icmp_pkt->seqno = htons(ping_seq);   // Set sequence number (converted to network byte order)
-    ping_seq++;                          // Increment sequence for next ping
-
-    // Fill packet data with incrementing numbers (0, 1, 2, 3...)
-    char *data_ptr = (char *)icmp_pkt + sizeof(struct icmp_echo_hdr);
-    for (int i = 0; i < PING_DATA_SIZE; i++)
+    // Discard replies that arrived after an earlier ping timed out
+    char stale[64];
+    while (recv(sock, stale, sizeof(stale), MSG_DONTWAIT) > 0)
     {
-        data_ptr[i] = (char)i; // Fill with pattern 0, 1, 2, 3...
     }
 
-    // Calculate ICMP checksum (error detection for packet)
-    icmp_pkt->chksum = inet_chksum(icmp_pkt, sizeof(struct icmp_echo_hdr) + PING_DATA_SIZE);
+    // Start measuring the packet build (header, payload, checksum)
+    uint32_t build_start = PERF_COUNTER_START();
+    TRACE_BEGIN(TRACE_ID_BUILD, 0);
+
+    // Build the echo request (same builder as the icmp_probe engine)
+    uint16_t seq = ping_seq;
+    size_t packet_len = icmp_probe_build_request(ping_packet, seq);
+    ping_seq++; // Increment sequence for next ping
+
+    // Packet is complete: record the build cost
+    PERF_COUNTER_STOP(&icmp_build_perf, build_start);
+    TRACE_END(TRACE_ID_BUILD, 0);
 
     // Prepare destination address structure
     struct sockaddr_in dest_addr;
@@ -243,19 +178,24 @@ static void ping_target(void)
     dest_addr.sin_addr.s_addr = target_addr.u_addr.ip4.addr;
 
     // Send the ICMP packet (ping request)
-    int sent = sendto(sock, icmp_pkt, sizeof(struct icmp_echo_hdr) + PING_DATA_SIZE,
+    int sent = sendto(sock, ping_packet, packet_len,
                       0, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
 
     // Check if send was successful
     if (sent < 0)
     {
-        // Send failed
+        // Send failed; reopen the socket for the next ping
         ESP_LOGE(TAG, "Failed to send ping: error %d", errno);
+        close(sock);
+        ping_sock = -1;
     }
     else
     {
         // Send successful, now wait for response
-        ESP_LOGI(TAG, "Ping #%d sent to %s", ping_seq, PING_TARGET);
+        uint32_t trace_start = PERF_COUNTER_START();
+        TRACE_INSTANT(TRACE_ID_SEND, ping_seq);
+        PERF_COUNTER_STOP(&trace_event_perf, trace_start);
+        DLOGI(TAG, "Ping #%d sent to %s", ping_seq, PING_TARGET);
 
         // Buffer for receiving response
         char recv_buf[256];
@@ -265,21 +205,31 @@ static void ping_target(void)
         // Get current tick count for timing (simpler alternative to esp_timer_get_time)
         TickType_t start_ticks = xTaskGetTickCount();
 
-        // Receive response (blocking call with timeout)
-        int received = recvfrom(sock, recv_buf, sizeof(recv_buf), 0,
+        // Receive until the reply to this request arrives (blocking call with
+        // timeout); other ICMP traffic on the raw socket is skipped
+        int received;
+        bool replied;
+        TickType_t end_ticks;
+        do
+        {
+            addr_len = sizeof(src_addr);
+            received = recvfrom(sock, recv_buf, sizeof(recv_buf), 0,
                                 (struct sockaddr *)&src_addr, &addr_len);
+            replied = received > 0 && icmp_probe_is_reply((const uint8_t *)recv_buf, received, seq);
 
-        // Get tick count after receive attempt
-        TickType_t end_ticks = xTaskGetTickCount();
+            // Get tick count after receive attempt
+            end_ticks = xTaskGetTickCount();
+        } while (received >= 0 && !replied && end_ticks - start_ticks < pdMS_TO_TICKS(PING_TIMEOUT));
 
         // Check if receive was successful
-        if (received < 0)
+        if (!replied)
         {
-            // Receive failed (timeout or error)
-            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            // Receive failed (timeout, only other ICMP traffic, or error)
+            if (received >= 0 || errno == EAGAIN || errno == EWOULDBLOCK)
             {
                 // Timeout occurred
-                ESP_LOGW(TAG, "No response from %s (timeout)", PING_TARGET);
+                TRACE_INSTANT(TRACE_ID_TIMEOUT, 0);
+                DLOGW(TAG, "No response from %s (timeout)", PING_TARGET);
             }
             else
             {
@@ -294,22 +244,17 @@ static void ping_target(void)
             // Calculate Round Trip Time in milliseconds
             // portTICK_PERIOD_MS = milliseconds per tick (usually 1ms)
             TickType_t rtt_ticks = end_ticks - start_ticks;
+            TRACE_INSTANT(TRACE_ID_REPLY, rtt_ticks);
             float rtt_ms = (float)rtt_ticks * portTICK_PERIOD_MS;
 
-            // Convert source IP to human-readable string
-            char src_ip[INET_ADDRSTRLEN];
-            inet_ntop(AF_INET, &src_addr.sin_addr, src_ip, sizeof(src_ip));
+            // Source IP bytes (a deferred log cannot keep a pointer to a stack string)
+            const uint8_t *src_ip = (const uint8_t *)&src_addr.sin_addr.s_addr;
 
             // Log successful ping with RTT
-            ESP_LOGI(TAG, "Ping reply from %s: time=%.1f ms", src_ip, rtt_ms);
+            DLOGI(TAG, "Ping reply from %d.%d.%d.%d: time=%.1f ms",
+                  src_ip[0], src_ip[1], src_ip[2], src_ip[3], rtt_ms);
         }
     }
-
-    // Free allocated memory for ICMP packet
-    free(icmp_pkt);
-
-    // Close the socket
-    close(sock);
 }
 
 // Main application function - entry point for ESP32 program
@@ -329,24 +274,57 @@ void app_main(void)
     // Check final NVS initialization result
     ESP_ERROR_CHECK(ret);
 
-    // Initialize WiFi connection
-    wifi_init_sta();
+    // Start the task that prints deferred log messages
+    ESP_ERROR_CHECK(dlog_start());
+
+    // Start WiFi; the link keeps reconnecting on its own after any drop
+    ESP_ERROR_CHECK(wifi_link_start(WIFI_SSID, WIFI_PASSWORD));
+
+    // Wait until the link has an IP address
+    wifi_link_wait_up(portMAX_DELAY);
+
+    // Convert string IP to binary format and store in target_addr
+    // ipaddr_addr() converts dotted-decimal string to 32-bit IP address
+    ip4_addr_set_u32(&target_addr.u_addr.ip4, ipaddr_addr(PING_TARGET));
+
+    // Log the target IP
+    ESP_LOGI(TAG, "Ping target: %s", PING_TARGET);
 
-    // Wait a moment for WiFi connection to establish
-    vTaskDelay(5000 / portTICK_PERIOD_MS);
+    // Name the trace events for the dump
+    trace_name(TRACE_ID_PING, "ping_target");
+    trace_name(TRACE_ID_BUILD, "icmp_build");
+    trace_name(TRACE_ID_SEND, "echo_sent");
+    trace_name(TRACE_ID_REPLY, "echo_reply");
+    trace_name(TRACE_ID_TIMEOUT, "echo_timeout");
 
     // Infinite loop for continuous pinging
     while (1)
     {
-        // Check if we have a valid target IP address (not zero)
-        if (target_addr.u_addr.ip4.addr != 0)
+        // Only ping while the link has an IP address
+        if (wifi_link_is_up())
         {
             // We have an IP address, send ping
+            TRACE_BEGIN(TRACE_ID_PING, ping_seq);
             ping_target();
+            TRACE_END(TRACE_ID_PING, ping_seq);
+
+            // Report the cycle counters as JSON every few pings
+            if (ping_seq % PERF_REPORT_PINGS == 0)
+            {
+                perf_counter_print_json();
+            }
+
+#if TRACE_DUMP_PINGS > 0
+            // Dump the trace for tools/trace2perfetto.py (enabled in menuconfig)
+            if (ping_seq % TRACE_DUMP_PINGS == 0)
+            {
+                trace_dump(trace_uart_write, NULL);
+            }
+#endif
         }
         else
         {
-            // No IP address yet (WiFi not connected or IP not assigned)
+            // Link dropped; wifi_link is already reconnecting
             ESP_LOGW(TAG, "Waiting for WiFi connection and IP address...");
 
             // Check WiFi connection status
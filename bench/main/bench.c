@@ -0,0 +1,41 @@
+// Include the runner interface
+#include "bench.h"
+
+// Include standard input/output library for printf()
+#include <stdio.h>
+
+// Include the perf counter clock
+#include "perf_counter.h"
+
+// Include sdkconfig for the target name
+#include "sdkconfig.h"
+
+double bench_run(const char *name, bench_op_t op, uint32_t batch, uint32_t batches)
+{
+    uint32_t best = UINT32_MAX;
+    uint64_t total = 0;
+    uint32_t i = 0;
+
+    for (uint32_t b = 0; b < batches; b++)
+    {
+        uint32_t start = perf_counter_now();
+        for (uint32_t n = 0; n < batch; n++)
+        {
+            op(i++);
+        }
+        uint32_t elapsed = perf_counter_now() - start; // Unsigned subtraction handles wrap-around
+
+        total += elapsed;
+        if (elapsed < best)
+        {
+            best = elapsed;
+        }
+    }
+
+    double avg = (double)total / ((double)batch * batches);
+    printf("BENCH {\"name\":\"%s\",\"target\":\"%s\",\"unit\":\"%s\",\"batch\":%lu,\"batches\":%lu,"
+           "\"best\":%.1f,\"avg\":%.1f,\"ops_per_s\":%.0f}\n",
+           name, CONFIG_IDF_TARGET, perf_counter_unit(), (unsigned long)batch, (unsigned long)batches,
+           (double)best / batch, avg, avg > 0 ? perf_counter_ticks_per_second() / avg : 0.0);
+    return avg;
+}
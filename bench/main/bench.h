@@ -0,0 +1,24 @@
+// Benchmark runner for the Unity benchmark cases
+//
+// bench_run() calls op() in batches, times every batch with the perf
+// counter clock (CPU cycles; nanoseconds on the Linux target) and prints
+// one JSON line per benchmark:
+//
+//   BENCH {"name":"parse_command","target":"esp32","unit":"cycles","batch":1000,
+//          "batches":20,"best":812.4,"avg":845.0,"ops_per_s":189349}
+//
+// best and avg are the cost of one operation (fastest batch, mean of all
+// batches) including one indirect call; ops_per_s follows from avg.
+// tools/bench_check.py compares ops_per_s with bench_thresholds.json.
+
+#pragma once
+
+// Include standard integer types
+#include <stdint.h>
+
+// One operation; i counts from 0 across all batches
+typedef void (*bench_op_t)(uint32_t i);
+
+// Run batches * batch operations and print the BENCH line
+// Returns the mean cost of one operation in perf counter units.
+double bench_run(const char *name, bench_op_t op, uint32_t batch, uint32_t batches);
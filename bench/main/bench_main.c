@@ -0,0 +1,29 @@
+// Unity benchmark suite: GPIO toggle rate, command parsing, ICMP build and
+// checksum, LED scheduling
+//
+// Runs every "[bench]" case once and prints a BENCH line per benchmark and
+// the Unity summary; tools/bench_check.py turns that log into pass/fail.
+
+// Include standard input/output and library functions
+#include <stdio.h>
+#include <stdlib.h>
+
+// Include the Unity test runner
+#include "unity.h"
+#include "unity_test_runner.h"
+
+// Include sdkconfig for the target
+#include "sdkconfig.h"
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    unity_run_tests_by_tag("[bench]", false);
+    int failures = UNITY_END();
+
+    printf("BENCH_DONE %d\n", failures);
+#if CONFIG_IDF_TARGET_LINUX
+    // The Linux target is a process: report through its exit status
+    exit(failures == 0 ? 0 : 1);
+#endif
+}
@@ -0,0 +1,41 @@
+// GPIO toggle rate: gpio_set_level() alternating high and low
+
+// Include Unity and the runner
+#include "unity.h"
+#include "bench.h"
+
+// Include sdkconfig for the target
+#include "sdkconfig.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+
+TEST_CASE("GPIO toggle rate", "[bench]")
+{
+    TEST_IGNORE_MESSAGE("No GPIO on the Linux target");
+}
+
+#else
+
+// Include the GPIO driver
+#include "driver/gpio.h"
+
+// Onboard LED on most ESP32 boards (same pin as the projects)
+#define BENCH_GPIO 2
+
+// One toggle: every call changes the level
+static void toggle_one(uint32_t i)
+{
+    gpio_set_level(BENCH_GPIO, i & 1);
+}
+
+TEST_CASE("GPIO toggle rate", "[bench]")
+{
+    gpio_reset_pin(BENCH_GPIO);
+    gpio_set_direction(BENCH_GPIO, GPIO_MODE_OUTPUT);
+
+    bench_run("gpio_toggle", toggle_one, 1000, 20);
+
+    gpio_set_level(BENCH_GPIO, 0);
+}
+
+#endif
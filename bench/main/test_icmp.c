@@ -0,0 +1,45 @@
+// ICMP echo request build and checksum (components/icmp_probe)
+
+// Include Unity and the runner
+#include "unity.h"
+#include "bench.h"
+
+// Include the request builder and lwIP's checksum
+#include "icmp_probe.h"
+#include "lwip/inet_chksum.h"
+
+// Largest payload of one Ethernet frame (MTU minus IPv4 header)
+#define FRAME_PAYLOAD 1480
+
+static uint8_t packet[ICMP_PROBE_PACKET_SIZE];
+static uint8_t frame[FRAME_PAYLOAD] __attribute__((aligned(4)));
+static volatile uint16_t checksum;
+
+// Header, payload pattern and checksum of one probe request
+static void build_one(uint32_t i)
+{
+    icmp_probe_build_request(packet, (uint16_t)i);
+}
+
+// Checksum of a full-size frame, for comparing with the build cost
+static void checksum_frame(uint32_t i)
+{
+    checksum = inet_chksum(frame, sizeof(frame));
+}
+
+TEST_CASE("ICMP build and checksum", "[bench]")
+{
+    bench_run("icmp_build_checksum", build_one, 1000, 20);
+
+    // A correct checksum makes the whole packet sum to zero
+    TEST_ASSERT_EQUAL_HEX16(0, inet_chksum(packet, sizeof(packet)));
+}
+
+TEST_CASE("inet_chksum 1480 bytes", "[bench]")
+{
+    for (int i = 0; i < FRAME_PAYLOAD; i++)
+    {
+        frame[i] = (uint8_t)(i * 7);
+    }
+    bench_run("inet_chksum_1480", checksum_frame, 100, 20);
+}
@@ -0,0 +1,76 @@
+// LED scheduling: d-microros-wifi's LED worker from submit to GPIO write
+//
+// Each operation is a TOGGLE submitted to the worker queue; the benchmark
+// waits until the worker has written the GPIO, so one operation covers the
+// queue, the switch to the worker task and the write itself.
+
+// Include Unity and the runner
+#include "unity.h"
+#include "bench.h"
+
+// Include sdkconfig for the target
+#include "sdkconfig.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+
+TEST_CASE("LED scheduling", "[bench]")
+{
+    TEST_IGNORE_MESSAGE("The LED worker needs the GPIO driver and the trace ring");
+}
+
+#else
+
+// Include the high resolution timer for the wait limit
+#include "esp_timer.h"
+
+// Include the LED worker and its latency stamps
+#include "led_worker.h"
+#include "latency.h"
+
+// Longest wait for one transition before it counts as lost
+#define TRANSITION_TIMEOUT_US 100000
+
+static uint32_t timeouts;
+
+static void schedule_one(uint32_t i)
+{
+    led_op_t op = {.code = LED_OP_TOGGLE};
+    uint32_t changes = led_worker_change_count();
+
+    op.dispatch = op.callback = latency_now();
+    TEST_ASSERT_TRUE(led_worker_submit(&op));
+
+    // The worker has a higher priority (or its own core): this rarely spins
+    int64_t deadline = esp_timer_get_time() + TRANSITION_TIMEOUT_US;
+    while (led_worker_change_count() == changes)
+    {
+        if (esp_timer_get_time() > deadline)
+        {
+            timeouts++;
+            return;
+        }
+    }
+}
+
+TEST_CASE("LED scheduling", "[bench]")
+{
+    static int started;
+    led_transition_t transition;
+
+    if (!started)
+    {
+        led_worker_init();
+        started = 1;
+    }
+
+    timeouts = 0;
+    bench_run("led_schedule", schedule_one, 100, 20);
+    TEST_ASSERT_EQUAL(0, timeouts);
+
+    // Drain the transition log the publisher would normally take
+    while (led_worker_take_transition(&transition))
+    {
+    }
+}
+
+#endif
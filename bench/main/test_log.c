@@ -0,0 +1,53 @@
+// Cost of one log call: DLOGI (components/dlog, deferred) against ESP_LOGI
+// on the per-ping message of b-net-connect. ESP_LOGI includes waiting for
+// the UART; DLOGI only stores the record, the log task prints it later.
+
+// Include Unity and the runner
+#include "unity.h"
+#include "bench.h"
+
+// Include sdkconfig for the target
+#include "sdkconfig.h"
+
+#if CONFIG_IDF_TARGET_LINUX || !CONFIG_DLOG_ENABLE
+
+TEST_CASE("log call", "[bench]")
+{
+    TEST_IGNORE_MESSAGE("Deferred logging is built for esp32 and QEMU with CONFIG_DLOG_ENABLE");
+}
+
+#else
+
+// Include deferred and stock logging
+#include "dlog.h"
+#include "esp_log.h"
+
+static const char *TAG = "PING";
+
+// 200 calls: the records of one run fit the ring (sdkconfig.defaults)
+#define LOG_BATCH 10
+#define LOG_BATCHES 20
+
+static void dlogi_one(uint32_t i)
+{
+    DLOGI(TAG, "Ping #%d: %d bytes from %s time=%d us", (int)i, 64, "192.168.1.1", 1234);
+}
+
+static void esp_logi_one(uint32_t i)
+{
+    ESP_LOGI(TAG, "Ping #%d: %d bytes from %s time=%d us", (int)i, 64, "192.168.1.1", 1234);
+}
+
+TEST_CASE("log call", "[bench]")
+{
+    uint32_t dropped = dlog_dropped();
+
+    TEST_ASSERT_EQUAL(ESP_OK, dlog_start());
+    double deferred = bench_run("log_dlogi", dlogi_one, LOG_BATCH, LOG_BATCHES);
+    double stock = bench_run("log_esp_logi", esp_logi_one, LOG_BATCH, LOG_BATCHES);
+
+    TEST_ASSERT_EQUAL_UINT32(dropped, dlog_dropped());
+    TEST_ASSERT_TRUE_MESSAGE(deferred < stock, "DLOGI is not cheaper than ESP_LOGI");
+}
+
+#endif
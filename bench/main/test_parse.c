@@ -0,0 +1,63 @@
+// Command parse benchmarks (c-serial-connect/main/command_parser.c)
+//
+// Dispatch needs the console in serial_led.c (UART, GPIO, NVS) and is
+// measured on the host by c-serial-connect/host_test/bench_console.
+
+// Include standard string functions
+#include <string.h>
+
+// Include Unity and the runner
+#include "unity.h"
+#include "bench.h"
+
+// Include the parser under test
+#include "command_parser.h"
+
+// A mix of console lines: plain keywords, lowercase, arguments, text commands, a miss
+static const char *const lines[] = {
+    "ON", "off", "TOGGLE", "BLINK 3", "STATUS", "RUN SOS 10", "DEFINE X ON;WAIT 10;OFF", "NOPE",
+};
+#define LINE_COUNT (sizeof(lines) / sizeof(lines[0]))
+
+static char line[64];
+static command_t command;
+static line_editor_t editor;
+
+// parse_command() on a copy (it uppercases in place)
+static void parse_one(uint32_t i)
+{
+    strcpy(line, lines[i % LINE_COUNT]);
+    parse_command(line, &command);
+}
+
+// Every character through the line editor, then the parser
+static void edit_and_parse_one(uint32_t i)
+{
+    for (const char *ch = lines[i % LINE_COUNT]; *ch; ch++)
+    {
+        line_editor_feed(&editor, *ch);
+    }
+    if (line_editor_feed(&editor, '\n') == LINE_EDIT_COMPLETE)
+    {
+        parse_command(line, &command);
+    }
+}
+
+TEST_CASE("command parse", "[bench]")
+{
+    bench_run("parse_command", parse_one, 1000, 20);
+
+    strcpy(line, "blink 3");
+    parse_command(line, &command);
+    TEST_ASSERT_EQUAL(CMD_ID_BLINK, command.id);
+    TEST_ASSERT_EQUAL(3, command.arg);
+}
+
+TEST_CASE("line edit and parse", "[bench]")
+{
+    line_editor_init(&editor, line, sizeof(line));
+    bench_run("line_edit_parse", edit_and_parse_one, 1000, 20);
+
+    // The last line of the run was "NOPE"
+    TEST_ASSERT_EQUAL(CMD_ID_UNKNOWN, command.id);
+}
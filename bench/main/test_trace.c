@@ -0,0 +1,36 @@
+// Cost of one trace event (components/trace_ring), the price every
+// TRACE_INSTANT/BEGIN/END in the projects pays while recording
+
+// Include Unity and the runner
+#include "unity.h"
+#include "bench.h"
+
+// Include sdkconfig for the target
+#include "sdkconfig.h"
+
+#if CONFIG_IDF_TARGET_LINUX || !CONFIG_TRACE_RING_ENABLE
+
+TEST_CASE("trace event", "[bench]")
+{
+    TEST_IGNORE_MESSAGE("The trace ring needs the cycle counter and CONFIG_TRACE_RING_ENABLE");
+}
+
+#else
+
+// Include the trace recorder
+#include "trace_ring.h"
+
+// Event ID used only by the benchmark
+#define TRACE_ID_BENCH 1
+
+static void record_one(uint32_t i)
+{
+    TRACE_INSTANT(TRACE_ID_BENCH, i);
+}
+
+TEST_CASE("trace event", "[bench]")
+{
+    bench_run("trace_event", record_one, 1000, 20);
+}
+
+#endif
@@ -0,0 +1,125 @@
+// Command throughput benchmark for the serial console
+//
+//   bench_console [commands]
+//
+// Measures commands per second for parse_command() alone and for the whole
+// console path (line editor, parser, dispatch, GPIO write, reply) in human
+// and in tagged mode, on pipelined LED commands. Prints one line per case,
+//
+//   BENCH {"name":"parse","target":"host","cmds":200000,"seconds":0.031,"ops_per_s":6451612}
+//
+// followed by the firmware's own PERF counters (nanoseconds on the host).
+// Host numbers are for comparing revisions, not for predicting the ESP32;
+// tools/bench_check.py checks them against the "host" section of
+// bench/bench_thresholds.json.
+
+// Include standard input/output, library, string and clock functions
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Include the parser, the harness, the counters and the mock controls
+#include "command_parser.h"
+#include "console_harness.h"
+#include "perf_counter.h"
+#include "host_mock.h"
+
+// Commands cycled through by every case
+static const char *const commands[] = {"ON", "OFF", "TOGGLE", "STATUS", "toggle", "BLINK 99", "NOPE"};
+#define COMMAND_COUNT (sizeof(commands) / sizeof(commands[0]))
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, long cmds, double seconds)
+{
+    fprintf(stderr, "BENCH {\"name\":\"%s\",\"target\":\"host\",\"cmds\":%ld,\"seconds\":%.3f,\"ops_per_s\":%.0f}\n",
+            name, cmds, seconds, seconds > 0 ? cmds / seconds : 0.0);
+}
+
+// parse_command() on its own
+static void bench_parse(long cmds)
+{
+    char line[32];
+    command_t command;
+    volatile int sink = 0;
+
+    double start = now_seconds();
+    for (long i = 0; i < cmds; i++)
+    {
+        strcpy(line, commands[i % COMMAND_COUNT]); // The parser uppercases in place
+        parse_command(line, &command);
+        sink += command.id;
+    }
+    report("parse", cmds, now_seconds() - start);
+}
+
+// The whole console on one UART stream of cmds lines
+static void bench_console(const char *name, long cmds, int tagged)
+{
+    size_t size = cmds * 24 + 64;
+    char *input = malloc(size);
+    size_t len = 0;
+
+    if (input == NULL)
+    {
+        abort();
+    }
+    if (tagged)
+    {
+        len += snprintf(input + len, size - len, "TAGGED ON\n");
+    }
+    for (long i = 0; i < cmds; i++)
+    {
+        // BLINK would wait (on the virtual clock); keep to the instant commands
+        const char *command = commands[i % COMMAND_COUNT];
+        if (strncmp(command, "BLINK", 5) == 0)
+        {
+            command = "OFF";
+        }
+        len += tagged ? snprintf(input + len, size - len, "%ld %s\n", i + 1, command)
+                      : snprintf(input + len, size - len, "%s\n", command);
+    }
+    if (tagged)
+    {
+        len += snprintf(input + len, size - len, "0 TAGGED OFF\n");
+    }
+
+    double start = now_seconds();
+    console_harness_run((const uint8_t *)input, len, 0);
+    report(name, cmds, now_seconds() - start);
+    free(input);
+}
+
+int main(int argc, char **argv)
+{
+    long cmds = argc > 1 ? atol(argv[1]) : 100000;
+
+    if (cmds <= 0)
+    {
+        fprintf(stderr, "usage: %s [commands]\n", argv[0]);
+        return 2;
+    }
+
+    // Replies go nowhere; results are printed on stderr
+    if (freopen("/dev/null", "w", stdout) == NULL)
+    {
+        return 2;
+    }
+
+    bench_parse(cmds * 10);
+    perf_counter_reset();
+    bench_console("console", cmds, 0);
+    bench_console("console_tagged", cmds, 1);
+
+    static char counters[1024];
+    perf_counter_format_json(counters, sizeof(counters));
+    fprintf(stderr, "PERF %s\n", counters);
+    return 0;
+}
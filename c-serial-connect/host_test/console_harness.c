@@ -0,0 +1,36 @@
+// Include the harness interface
+#include "console_harness.h"
+
+// Include non-local jumps
+#include <setjmp.h>
+
+// Include the mock controls
+#include "esp_timer.h"
+#include "host_mock.h"
+
+// Firmware entry point (serial_led.c)
+void app_main(void);
+
+// Where to return to once the input is used up
+static jmp_buf input_done;
+
+// UART hook: app_main() asked for more input than there is
+static void input_exhausted(void)
+{
+    longjmp(input_done, 1);
+}
+
+void console_harness_run(const uint8_t *data, size_t len, int64_t time_limit_us)
+{
+    host_mock_uart_set_input(data, len);
+    host_mock_uart_set_exhausted_hook(input_exhausted);
+    host_mock_uart_set_deadline(time_limit_us > 0 ? esp_timer_get_time() + time_limit_us : 0);
+
+    if (setjmp(input_done) == 0)
+    {
+        app_main(); // Never returns on its own
+    }
+
+    host_mock_uart_set_deadline(0);
+    host_mock_uart_set_exhausted_hook(NULL);
+}
@@ -0,0 +1,12 @@
+// Runs the firmware's app_main() on a recorded UART byte stream
+#pragma once
+
+// Include standard integer and size types
+#include <stddef.h>
+#include <stdint.h>
+
+// Run app_main() until it has read all of data, then return
+// Every call starts app_main() again: NVS, LED and console mode keep their
+// state from the previous call, as after a soft restart. A macro RUN still
+// going after time_limit_us (virtual time, 0 = none) is stopped with Ctrl-C.
+void console_harness_run(const uint8_t *data, size_t len, int64_t time_limit_us);
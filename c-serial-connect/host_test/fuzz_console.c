@@ -0,0 +1,53 @@
+// Fuzz target for the whole serial console
+//
+// Runs app_main() on the input as UART bytes: line editing, parsing,
+// dispatch, tagged mode and macros (compile, store, run) on the host
+// stand-ins. Each input starts in human mode with the LED off and no
+// macros stored; a macro still running after 200 ms of virtual time is
+// stopped with Ctrl-C so slow inputs do not time out.
+
+// Include standard input/output, integer and string functions
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Include the harness and the mock controls
+#include "console_harness.h"
+#include "host_mock.h"
+
+// Virtual time an input may run for
+#define FUZZ_TIME_LIMIT_US (200 * 1000)
+
+// Puts the console back into human mode whatever mode it was left in:
+// in tagged mode the first line switches back, otherwise the second does
+static const char preamble[] = "\x03" "0 TAGGED OFF\nTAGGED OFF\nOFF\n";
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    static int initialized;
+
+    if (!initialized)
+    {
+        // The console writes a lot; keep it out of the fuzzer's output
+        if (freopen("/dev/null", "w", stdout) == NULL)
+        {
+            abort();
+        }
+        initialized = 1;
+    }
+
+    uint8_t *input = malloc(sizeof(preamble) - 1 + size);
+    if (input == NULL)
+    {
+        return 0;
+    }
+    memcpy(input, preamble, sizeof(preamble) - 1);
+    memcpy(input + sizeof(preamble) - 1, data, size);
+
+    host_mock_nvs_reset();
+    console_harness_run(input, sizeof(preamble) - 1 + size, FUZZ_TIME_LIMIT_US);
+
+    free(input);
+    return 0;
+}
@@ -0,0 +1,70 @@
+// Fuzz target for the line editor and command parser
+//
+// Feeds the input byte by byte through line_editor_feed() into a buffer of
+// the console's size and parses every line it hands over, checking that
+// lines stay inside the buffer and parsed arguments stay in range.
+
+// Include standard library, integer and string functions
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Include the parser
+#include "command_parser.h"
+
+// Same line length as the serial console (CMD_LINE_MAX)
+#define FUZZ_LINE_MAX 256
+
+// Check one parsed line
+static void check_command(const char *line, size_t len, const command_t *command)
+{
+    if (command->id == CMD_ID_BLINK && (command->arg < BLINK_MIN_TIMES || command->arg > BLINK_MAX_TIMES))
+    {
+        abort(); // Out-of-range counts must fall back to the default
+    }
+    bool has_text = command->id == CMD_ID_DEFINE || command->id == CMD_ID_RUN ||
+                    command->id == CMD_ID_UNDEF || command->id == CMD_ID_TAGGED;
+    if (has_text && (command->text < line || command->text > line + len))
+    {
+        abort(); // Text arguments point into the line
+    }
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    // Guard bytes after the line catch writes past max_len
+    char buffer[FUZZ_LINE_MAX + 8];
+    line_editor_t editor;
+
+    memset(buffer + FUZZ_LINE_MAX, 0x5a, 8);
+    line_editor_init(&editor, buffer, FUZZ_LINE_MAX);
+
+    for (size_t i = 0; i < size; i++)
+    {
+        line_edit_result_t result = line_editor_feed(&editor, (char)data[i]);
+        if (editor.length < 0 || editor.length >= FUZZ_LINE_MAX)
+        {
+            abort();
+        }
+        if (result == LINE_EDIT_COMPLETE || result == LINE_EDIT_FULL)
+        {
+            size_t len = strlen(buffer);
+            if (len >= FUZZ_LINE_MAX)
+            {
+                abort();
+            }
+            command_t command;
+            parse_command(buffer, &command);
+            check_command(buffer, len, &command);
+        }
+    }
+
+    for (int i = 0; i < 8; i++)
+    {
+        if (buffer[FUZZ_LINE_MAX + i] != 0x5a)
+        {
+            abort();
+        }
+    }
+    return 0;
+}
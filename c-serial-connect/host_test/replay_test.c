@@ -0,0 +1,107 @@
+// Replay test for the serial console
+//
+//   replay_test <input> <expected> [--update]
+//
+// Feeds <input> to app_main() as UART bytes and compares everything the
+// console printed after its first prompt (the banner and help come before
+// it) with <expected>. --update rewrites <expected> instead.
+
+// Include standard library, input/output and string functions
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Include the harness
+#include "console_harness.h"
+
+// Longest fixture or transcript
+#define REPLAY_MAX (64 * 1024)
+
+// Read a whole file into buffer; returns the length or -1
+static long read_file(const char *path, char *buffer, size_t size)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return -1;
+    }
+    size_t len = fread(buffer, 1, size, file);
+    fclose(file);
+    return len < size ? (long)len : -1;
+}
+
+// Run input through the console; returns the transcript length
+static size_t run_console(const char *input, size_t input_len, char *transcript, size_t size)
+{
+    FILE *capture = tmpfile();
+    int saved_stdout = dup(STDOUT_FILENO);
+
+    fflush(stdout);
+    dup2(fileno(capture), STDOUT_FILENO);
+
+    console_harness_run((const uint8_t *)input, input_len, 0);
+
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+
+    rewind(capture);
+    size_t len = fread(transcript, 1, size - 1, capture);
+    fclose(capture);
+    transcript[len] = '\0';
+    return len;
+}
+
+int main(int argc, char **argv)
+{
+    static char input[REPLAY_MAX];
+    static char transcript[REPLAY_MAX];
+    static char expected[REPLAY_MAX];
+
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s <input> <expected> [--update]\n", argv[0]);
+        return 2;
+    }
+
+    long input_len = read_file(argv[1], input, sizeof(input));
+    if (input_len < 0)
+    {
+        fprintf(stderr, "Cannot read %s\n", argv[1]);
+        return 2;
+    }
+
+    size_t len = run_console(input, input_len, transcript, sizeof(transcript));
+
+    // Skip the banner and help: the session starts at the first prompt
+    const char *session = strstr(transcript, "\n> ");
+    session = session != NULL ? session + 1 : transcript + len;
+    size_t session_len = transcript + len - session;
+
+    if (argc > 3 && strcmp(argv[3], "--update") == 0)
+    {
+        FILE *file = fopen(argv[2], "wb");
+        if (file == NULL || fwrite(session, 1, session_len, file) != session_len)
+        {
+            fprintf(stderr, "Cannot write %s\n", argv[2]);
+            return 2;
+        }
+        fclose(file);
+        return 0;
+    }
+
+    long expected_len = read_file(argv[2], expected, sizeof(expected));
+    if (expected_len < 0)
+    {
+        fprintf(stderr, "Cannot read %s\n", argv[2]);
+        return 2;
+    }
+    if ((size_t)expected_len != session_len || memcmp(expected, session, session_len) != 0)
+    {
+        fprintf(stderr, "Transcript differs from %s\n--- got ---\n%.*s\n--- end ---\n",
+                argv[2], (int)session_len, session);
+        return 1;
+    }
+    return 0;
+}
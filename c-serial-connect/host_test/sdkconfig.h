@@ -0,0 +1,24 @@
+// Configuration for the host build of the serial console
+// (the values the firmware gets from sdkconfig.defaults and Kconfig)
+#pragma once
+
+#define CONFIG_IDF_TARGET "linux"
+#define CONFIG_IDF_TARGET_LINUX 1
+#define CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ 160
+#define CONFIG_PERF_COUNTER_ENABLE 1
+#define CONFIG_TRACE_RING_ENABLE 0
+#define CONFIG_TRACE_RING_MAX_NAMES 32
+#define CONFIG_TELEMETRY_PERIOD_MS 1000
+#define CONFIG_TELEMETRY_MAX_TASKS 16
+#define CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS 1
+
+// The TCP server is built only into tcp_standin (-DCONFIG_SERIAL_LED_TCP_SERVER=1)
+#ifndef CONFIG_SERIAL_LED_TCP_SERVER
+#define CONFIG_SERIAL_LED_TCP_SERVER 0
+#endif
+#define CONFIG_SERIAL_LED_WIFI_SSID "host"
+#define CONFIG_SERIAL_LED_WIFI_PASSWORD "host"
+#define CONFIG_SERIAL_LED_TCP_PORT 3333
+#define CONFIG_SERIAL_LED_TCP_MAX_CLIENTS 32
+#define CONFIG_SERIAL_LED_TCP_RUN_MAX_MS 2000
+#define CONFIG_LWIP_MAX_SOCKETS 33
@@ -0,0 +1,61 @@
+// Stand-ins for the components the console tests do not exercise
+
+// Include the replaced interfaces
+#include "telemetry.h"
+#include "trace_ring.h"
+#include "wifi_link.h"
+
+esp_err_t telemetry_start(void)
+{
+    return ESP_OK;
+}
+
+bool telemetry_get(telemetry_sample_t *sample)
+{
+    return false; // STATS answers "Telemetry not available"
+}
+
+size_t telemetry_format(char *buffer, size_t size)
+{
+    if (size > 0)
+    {
+        buffer[0] = '\0';
+    }
+    return 0;
+}
+
+void trace_name(uint16_t id, const char *name)
+{
+}
+
+// Same output as the firmware with CONFIG_TRACE_RING_ENABLE off
+void trace_dump(trace_write_t write, void *ctx)
+{
+    write(ctx, "TRACE BEGIN 0 0 0\nTRACE END\n", 28);
+}
+
+esp_err_t trace_dump_udp(const char *ip, uint16_t port)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+// The host network is always up
+esp_err_t wifi_link_start(const char *ssid, const char *password)
+{
+    return ESP_OK;
+}
+
+bool wifi_link_wait_up(TickType_t timeout)
+{
+    return true;
+}
+
+bool wifi_link_is_up(void)
+{
+    return true;
+}
+
+void wifi_link_get_stats(wifi_link_stats_t *stats)
+{
+    *stats = (wifi_link_stats_t){0};
+}
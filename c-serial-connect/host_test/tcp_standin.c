@@ -0,0 +1,29 @@
+// Local stand-in for the board with the TCP server enabled
+//
+//   tcp_standin [seconds]
+//
+// Runs app_main() with the TCP command server on the host's sockets
+// (port CONFIG_SERIAL_LED_TCP_PORT, up to CONFIG_SERIAL_LED_TCP_MAX_CLIENTS
+// clients) for tools/tcp_load.py and manual testing with nc. The serial
+// console has no input. Exits after the given time (default: never).
+
+// Include standard library and signal handling
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Firmware entry point (serial_led.c)
+void app_main(void);
+
+int main(int argc, char **argv)
+{
+    // lwIP reports a closed peer through send()'s return value only
+    signal(SIGPIPE, SIG_IGN);
+
+    if (argc > 1)
+    {
+        alarm(atoi(argv[1]));
+    }
+    app_main();
+    return 0;
+}
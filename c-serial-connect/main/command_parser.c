@@ -0,0 +1,162 @@
+// Include the parser interface
+#include "command_parser.h"
+
+// Include standard library for sscanf()
+#include <stdio.h>
+
+// Include standard string library for strcmp()/strncmp()
+#include <string.h>
+
+// Command keywords that take no argument, in the order they are checked
+static const struct
+{
+    const char *name; // Keyword as typed by the user (uppercase)
+    command_id_t id;  // Command ID returned by the parser
+} simple_commands[] = {
+    {"ON", CMD_ID_ON},
+    {"OFF", CMD_ID_OFF},
+    {"TOGGLE", CMD_ID_TOGGLE},
+    {"STATUS", CMD_ID_STATUS},
+    {"HELP", CMD_ID_HELP},
+    {"EXIT", CMD_ID_EXIT},
+    {"PERF", CMD_ID_PERF},
+    {"STATS", CMD_ID_STATS},
+    {"TRACE", CMD_ID_TRACE},
+};
+
+// Command keywords followed by free-form text
+static const struct
+{
+    const char *name; // Keyword as typed by the user (uppercase)
+    command_id_t id;  // Command ID returned by the parser
+} text_commands[] = {
+    {"DEFINE", CMD_ID_DEFINE},
+    {"RUN", CMD_ID_RUN},
+    {"UNDEF", CMD_ID_UNDEF},
+    {"TAGGED", CMD_ID_TAGGED},
+};
+
+// Prepare an editor to collect a new line into buffer
+void line_editor_init(line_editor_t *editor, char *buffer, int max_len)
+{
+    editor->buffer = buffer;
+    editor->max_len = max_len;
+    editor->length = 0;
+    buffer[0] = '\0';
+}
+
+// Feed one received character into the editor
+line_edit_result_t line_editor_feed(line_editor_t *editor, char ch)
+{
+    // Check for carriage return or newline (end of command)
+    if (ch == '\r' || ch == '\n')
+    {
+        editor->buffer[editor->length] = '\0'; // Null-terminate string
+        editor->length = 0;                    // Start a new line next time
+        return LINE_EDIT_COMPLETE;
+    }
+
+    // Ctrl-C discards the whole line
+    if (ch == LINE_EDIT_INTERRUPT)
+    {
+        editor->length = 0;
+        editor->buffer[0] = '\0';
+        return LINE_EDIT_CANCELLED;
+    }
+
+    // Handle backspace (delete character)
+    if (ch == '\b' || ch == 127)
+    {
+        if (editor->length == 0)
+        {
+            return LINE_EDIT_IGNORED; // Nothing to delete
+        }
+        editor->length--; // Remove last character
+        return LINE_EDIT_ERASED;
+    }
+
+    // Regular character
+    editor->buffer[editor->length] = ch; // Add to buffer
+    editor->length++;                    // Increment length
+
+    // Buffer full: hand the line over without waiting for Enter
+    if (editor->length >= editor->max_len - 1)
+    {
+        editor->buffer[editor->length] = '\0';
+        editor->length = 0;
+        return LINE_EDIT_FULL;
+    }
+
+    return LINE_EDIT_APPENDED;
+}
+
+// Parse a command line (converted to uppercase in place)
+void parse_command(char *cmd, command_t *out)
+{
+    out->id = CMD_ID_UNKNOWN;
+    out->arg = 0;
+    out->arg_invalid = false;
+    out->text = "";
+
+    // Convert command to uppercase for case-insensitive comparison
+    for (int i = 0; cmd[i]; i++)
+    {
+        if (cmd[i] >= 'a' && cmd[i] <= 'z')
+        {
+            cmd[i] = cmd[i] - 'a' + 'A';
+        }
+    }
+
+    // Empty line: nothing to do
+    if (cmd[0] == '\0')
+    {
+        out->id = CMD_ID_NONE;
+        return;
+    }
+
+    // Commands without arguments
+    for (size_t i = 0; i < sizeof(simple_commands) / sizeof(simple_commands[0]); i++)
+    {
+        if (strcmp(cmd, simple_commands[i].name) == 0)
+        {
+            out->id = simple_commands[i].id;
+            return;
+        }
+    }
+
+    // Commands with text arguments: keyword, space, then the rest of the line
+    for (size_t i = 0; i < sizeof(text_commands) / sizeof(text_commands[0]); i++)
+    {
+        size_t len = strlen(text_commands[i].name);
+        if (strncmp(cmd, text_commands[i].name, len) == 0 && (cmd[len] == ' ' || cmd[len] == '\0'))
+        {
+            out->id = text_commands[i].id;
+            out->text = cmd + len;
+            while (*out->text == ' ')
+            {
+                out->text++; // Skip spaces before the arguments
+            }
+            return;
+        }
+    }
+
+    // BLINK with optional number argument (e.g., "BLINK 3")
+    if (strncmp(cmd, "BLINK", 5) == 0)
+    {
+        out->id = CMD_ID_BLINK;
+        out->arg = BLINK_DEFAULT_TIMES;
+
+        if (cmd[5] != '\0')
+        {
+            // Try to extract number from command
+            sscanf(cmd + 5, "%d", &out->arg);
+
+            // Validate number
+            if (out->arg < BLINK_MIN_TIMES || out->arg > BLINK_MAX_TIMES)
+            {
+                out->arg_invalid = true;
+                out->arg = BLINK_DEFAULT_TIMES; // Use default
+            }
+        }
+    }
+}
@@ -0,0 +1,80 @@
+// Command parser for the serial LED console
+//
+// This module holds the parts of the console that do not touch any
+// hardware: the line editor that turns raw UART bytes into a command line,
+// and the parser that turns a command line into a command ID + argument.
+// Keeping it free of UART/GPIO calls lets it be compiled for the ESP-IDF
+// Linux target and driven from recorded byte streams.
+
+#pragma once
+
+// Include standard boolean type
+#include <stdbool.h>
+
+// Default and allowed range for the BLINK command
+#define BLINK_DEFAULT_TIMES 5 // Blink count when no number is given
+#define BLINK_MIN_TIMES 1     // Smallest accepted blink count
+#define BLINK_MAX_TIMES 20    // Largest accepted blink count
+
+// Ctrl-C: cancels the line being typed and interrupts a running macro
+#define LINE_EDIT_INTERRUPT 0x03
+
+// Result of feeding one character into the line editor
+typedef enum
+{
+    LINE_EDIT_IGNORED,   // Character did not change the line
+    LINE_EDIT_APPENDED,  // Character was added (echo it)
+    LINE_EDIT_ERASED,    // Last character was removed (erase it on the terminal)
+    LINE_EDIT_COMPLETE,  // CR or LF received, line is ready
+    LINE_EDIT_FULL,      // Character was added and the buffer is now full, line is ready
+    LINE_EDIT_CANCELLED, // Ctrl-C received, line was discarded
+} line_edit_result_t;
+
+// Line editor state
+typedef struct
+{
+    char *buffer; // Destination buffer (owned by the caller)
+    int max_len;  // Size of buffer, including the '\0'
+    int length;   // Number of characters currently in the line
+} line_editor_t;
+
+// Command IDs recognised by the console
+typedef enum
+{
+    CMD_ID_NONE,    // Empty line
+    CMD_ID_ON,      // ON
+    CMD_ID_OFF,     // OFF
+    CMD_ID_TOGGLE,  // TOGGLE
+    CMD_ID_BLINK,   // BLINK [N]
+    CMD_ID_STATUS,  // STATUS
+    CMD_ID_HELP,    // HELP
+    CMD_ID_EXIT,    // EXIT
+    CMD_ID_DEFINE,  // DEFINE <name> <steps>
+    CMD_ID_RUN,     // RUN <name> [N]
+    CMD_ID_UNDEF,   // UNDEF <name>
+    CMD_ID_TAGGED,  // TAGGED ON|OFF
+    CMD_ID_PERF,    // PERF
+    CMD_ID_STATS,   // STATS
+    CMD_ID_TRACE,   // TRACE
+    CMD_ID_UNKNOWN, // Anything else
+} command_id_t;
+
+// Parsed command
+typedef struct
+{
+    command_id_t id;  // Which command was given
+    int arg;          // Numeric argument (blink count for BLINK)
+    bool arg_invalid; // True if a number was given but was out of range
+    const char *text; // Rest of the line after the keyword (DEFINE/RUN/UNDEF/TAGGED)
+} command_t;
+
+// Prepare an editor to collect a new line into buffer
+void line_editor_init(line_editor_t *editor, char *buffer, int max_len);
+
+// Feed one received character into the editor
+// When COMPLETE or FULL is returned, the buffer holds a '\0'-terminated line
+// and the editor is reset for the next line.
+line_edit_result_t line_editor_feed(line_editor_t *editor, char ch);
+
+// Parse a command line (converted to uppercase in place)
+void parse_command(char *cmd, command_t *out);
@@ -0,0 +1,26 @@
+// Command console shared by the UART loop and the TCP server
+//
+// Every place that accepts commands (UART0, each TCP connection) owns a
+// console_t describing where replies go. Commands from all consoles are
+// executed one at a time, so the LED state and NVS macros stay consistent.
+// A waiting command (BLINK, RUN) holds every other console for its whole
+// duration; run_max_ms bounds that wait for consoles that share the board.
+
+#pragma once
+
+// Include standard size type
+#include <stddef.h>
+
+// One command source and the sink for its replies
+typedef struct
+{
+    void (*write)(void *ctx, const char *data, size_t len); // Send reply bytes
+    void *ctx;                                              // Passed to write()
+    int tagged;                                             // Tagged (ACK/NACK) mode on this console
+    int (*interrupted)(void *ctx);                          // Ctrl-C pending or peer gone (may be NULL)
+    int run_max_ms;                                         // Longest BLINK or RUN (0 = MACRO_RUN_TIME_MAX_MS)
+} console_t;
+
+// Execute one complete command line received on a console
+// Replies are written to that console only.
+void console_execute_line(console_t *console, char *line);
@@ -0,0 +1,465 @@
+// Include the macro interface
+#include "macro.h"
+
+// Include standard libraries for strtoull(), errno and string handling
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+
+// Include ESP32 FreeRTOS headers for delays
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Include ESP32 high resolution timer for microsecond timing
+#include "esp_timer.h"
+
+// Include non-volatile storage for persisting macros
+#include "nvs.h"
+
+// NVS namespace holding one blob per macro
+#define MACRO_NVS_NAMESPACE "macros"
+
+// Delay used by the BLINK step, same as the BLINK command
+#define MACRO_BLINK_DELAY_US (200 * 1000)
+
+// Last part of a wait that is spun instead of blocked (covers the esp_timer
+// dispatch latency, so steps still land on the microsecond)
+#define MACRO_SPIN_US 100
+
+// Longest time a run may go without blocking (steps with only short waits)
+#define MACRO_YIELD_US 10000
+
+// Shortest time between two stop checks
+#define MACRO_CHECK_US 1000
+
+// Longest single block of a wait, so long waits still notice a stop request
+#define MACRO_WAIT_SLICE_US (100 * 1000)
+
+// Bytecode operations
+// WAIT_US is followed by a 32-bit little-endian duration,
+// LOOP by a 16-bit little-endian count.
+enum
+{
+    MACRO_OP_HALT = 0, // End of macro
+    MACRO_OP_ON,       // LED on
+    MACRO_OP_OFF,      // LED off
+    MACRO_OP_TOGGLE,   // Invert LED
+    MACRO_OP_WAIT_US,  // Wait until previous deadline + duration
+    MACRO_OP_LOOP,     // Start of a repeated block
+    MACRO_OP_NEXT,     // End of a repeated block
+};
+
+// Append bytes to the macro, failing if it does not fit
+static int emit(macro_t *out, const uint8_t *bytes, int count)
+{
+    if (out->length + count > MACRO_CODE_MAX - 1) // Keep room for HALT
+    {
+        return 0;
+    }
+    memcpy(&out->code[out->length], bytes, count);
+    out->length += count;
+    return 1;
+}
+
+static int emit_op(macro_t *out, uint8_t op)
+{
+    return emit(out, &op, 1);
+}
+
+static int emit_wait(macro_t *out, uint32_t us)
+{
+    uint8_t bytes[5] = {MACRO_OP_WAIT_US, us & 0xFF, (us >> 8) & 0xFF, (us >> 16) & 0xFF, us >> 24};
+    return emit(out, bytes, sizeof(bytes));
+}
+
+static int emit_loop(macro_t *out, uint16_t count)
+{
+    uint8_t bytes[3] = {MACRO_OP_LOOP, count & 0xFF, count >> 8};
+    return emit(out, bytes, sizeof(bytes));
+}
+
+// Parse "<keyword>" or "<keyword> <number>"; returns 1 on a match
+// The number is unsigned and 64-bit, so range checks work the same whatever
+// the size of long; signs and values that overflow it do not match.
+static int match_step(const char *step, const char *keyword, unsigned long long *number, int needs_number)
+{
+    size_t len = strlen(keyword);
+    if (strncmp(step, keyword, len) != 0)
+    {
+        return 0;
+    }
+
+    const char *rest = step + len;
+    if (*rest == '\0')
+    {
+        return !needs_number;
+    }
+    if (*rest != ' ')
+    {
+        return 0; // Keyword is only a prefix of another word
+    }
+
+    while (*rest == ' ')
+    {
+        rest++;
+    }
+    if (!isdigit((unsigned char)*rest))
+    {
+        return 0;
+    }
+
+    char *end;
+    errno = 0;
+    *number = strtoull(rest, &end, 10);
+    while (*end == ' ')
+    {
+        end++;
+    }
+    return errno == 0 && *end == '\0';
+}
+
+// Compile macro source into bytecode
+esp_err_t macro_compile(const char *source, macro_t *out, int *bad_step)
+{
+    char step[32];  // Current step, trimmed
+    int depth = 0;  // Open REPEAT blocks
+    int index = 0;  // 1-based step number for error reporting
+    const char *p = source;
+
+    out->length = 0;
+    *bad_step = 0;
+
+    while (*p != '\0')
+    {
+        // Cut the next step at ';' and trim surrounding spaces
+        const char *end = strchr(p, ';');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        while (len > 0 && *p == ' ')
+        {
+            p++;
+            len--;
+        }
+        while (len > 0 && p[len - 1] == ' ')
+        {
+            len--;
+        }
+        index++;
+        *bad_step = index;
+
+        if (len >= sizeof(step))
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+        memcpy(step, p, len);
+        step[len] = '\0';
+        p = end ? end + 1 : p + len;
+
+        unsigned long long n = 0;
+        int ok;
+        if (len == 0)
+        {
+            ok = 1; // Empty step (e.g. trailing ';')
+        }
+        else if (strcmp(step, "ON") == 0)
+        {
+            ok = emit_op(out, MACRO_OP_ON);
+        }
+        else if (strcmp(step, "OFF") == 0)
+        {
+            ok = emit_op(out, MACRO_OP_OFF);
+        }
+        else if (strcmp(step, "TOGGLE") == 0)
+        {
+            ok = emit_op(out, MACRO_OP_TOGGLE);
+        }
+        else if (match_step(step, "WAITUS", &n, 1))
+        {
+            ok = n <= UINT32_MAX && emit_wait(out, (uint32_t)n);
+        }
+        else if (match_step(step, "WAIT", &n, 1))
+        {
+            ok = n <= UINT32_MAX / 1000 && emit_wait(out, (uint32_t)n * 1000);
+        }
+        else if (match_step(step, "BLINK", &n, 0))
+        {
+            // Expand to REPEAT N;ON;WAIT 200;OFF;WAIT 200;END, which takes
+            // a loop level like any REPEAT
+            if (len == 5)
+            {
+                n = 5;
+            }
+            ok = n >= 1 && n <= 20 && depth < MACRO_LOOP_DEPTH &&
+                 emit_loop(out, (uint16_t)n) &&
+                 emit_op(out, MACRO_OP_ON) && emit_wait(out, MACRO_BLINK_DELAY_US) &&
+                 emit_op(out, MACRO_OP_OFF) && emit_wait(out, MACRO_BLINK_DELAY_US) &&
+                 emit_op(out, MACRO_OP_NEXT);
+        }
+        else if (match_step(step, "REPEAT", &n, 1))
+        {
+            ok = n >= 1 && n <= UINT16_MAX && depth < MACRO_LOOP_DEPTH && emit_loop(out, (uint16_t)n);
+            depth++;
+        }
+        else if (strcmp(step, "END") == 0)
+        {
+            ok = depth > 0 && emit_op(out, MACRO_OP_NEXT);
+            depth--;
+        }
+        else
+        {
+            ok = 0; // Unknown step
+        }
+
+        if (!ok)
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    // Every REPEAT needs its END, and an empty macro is not useful
+    if (depth != 0 || out->length == 0)
+    {
+        *bad_step = index;
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    out->code[out->length++] = MACRO_OP_HALT;
+    *bad_step = 0;
+    return ESP_OK;
+}
+
+// Store a compiled macro in NVS
+esp_err_t macro_save(const char *name, const macro_t *macro)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(MACRO_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    err = nvs_set_blob(handle, name, macro->code, macro->length);
+    if (err == ESP_OK)
+    {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return err;
+}
+
+// Load a compiled macro from NVS
+esp_err_t macro_load(const char *name, macro_t *macro)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(MACRO_NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    size_t length = sizeof(macro->code);
+    err = nvs_get_blob(handle, name, macro->code, &length);
+    nvs_close(handle);
+
+    // A blob without a final HALT was not written by macro_save()
+    if (err == ESP_OK && (length == 0 || macro->code[length - 1] != MACRO_OP_HALT))
+    {
+        err = ESP_ERR_INVALID_SIZE;
+    }
+    macro->length = (err == ESP_OK) ? length : 0;
+    return err;
+}
+
+// Delete a macro from NVS
+esp_err_t macro_delete(const char *name)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(MACRO_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    err = nvs_erase_key(handle, name);
+    if (err == ESP_OK)
+    {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return err;
+}
+
+// State of the run in progress (runs are serialized by the caller)
+typedef struct
+{
+    int64_t start_us;           // When the run started
+    int64_t last_block_us;      // When the task last blocked
+    int64_t last_check_us;      // When stop_requested() was last called
+    int64_t time_max_us;        // Longest run before it is stopped
+    int (*stop_requested)(void);
+} macro_run_state_t;
+
+// One-shot timer that wakes the running task near the end of each wait
+static esp_timer_handle_t wait_timer;
+static TaskHandle_t waiting_task;
+
+// Wait timer callback (esp_timer task)
+static void wait_timer_callback(void *arg)
+{
+    xTaskNotifyGive(waiting_task);
+}
+
+// Stop, time limit and fairness checks, run at every wait and loop end
+static esp_err_t check_run(macro_run_state_t *run)
+{
+    int64_t now = esp_timer_get_time();
+
+    if (now - run->last_check_us < MACRO_CHECK_US)
+    {
+        return ESP_OK;
+    }
+    run->last_check_us = now;
+
+    if (now - run->start_us > run->time_max_us)
+    {
+        return ESP_ERR_TIMEOUT;
+    }
+    if (run->stop_requested != NULL && run->stop_requested())
+    {
+        return ESP_FAIL;
+    }
+
+    // Only very short waits (or none) for a while: let lower priority tasks
+    // and IDLE run; absolute deadlines catch up afterwards
+    if (now - run->last_block_us > MACRO_YIELD_US)
+    {
+        vTaskDelay(1);
+        run->last_block_us = esp_timer_get_time();
+    }
+    return ESP_OK;
+}
+
+// Wait until an absolute time (microseconds since boot)
+// Blocks on the one-shot timer until shortly before the deadline, then spins
+// the last MACRO_SPIN_US so steps land on the microsecond instead of on the
+// next tick. Every wait longer than that yields the CPU.
+static esp_err_t wait_until(macro_run_state_t *run, int64_t deadline_us)
+{
+    int64_t remaining = deadline_us - esp_timer_get_time();
+
+    while (remaining > MACRO_SPIN_US)
+    {
+        int64_t block = remaining - MACRO_SPIN_US;
+        esp_timer_stop(wait_timer); // Only running if an earlier wait woke early
+        esp_timer_start_once(wait_timer, block < MACRO_WAIT_SLICE_US ? block : MACRO_WAIT_SLICE_US);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        run->last_block_us = esp_timer_get_time();
+
+        esp_err_t err = check_run(run);
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+        remaining = deadline_us - esp_timer_get_time();
+    }
+    while (esp_timer_get_time() < deadline_us)
+    {
+        // Spin the rest
+    }
+    return check_run(run);
+}
+
+// Execute a macro repeat times
+esp_err_t macro_run(const macro_t *macro, int repeat, int time_max_ms, int level,
+                    void (*set_level)(int level), int (*stop_requested)(void))
+{
+    struct
+    {
+        uint16_t start;     // Offset of the first step inside the loop
+        uint16_t remaining; // Iterations left, including the current one
+    } loops[MACRO_LOOP_DEPTH];
+    int depth = 0;
+    esp_err_t err = ESP_OK;
+
+    if (wait_timer == NULL)
+    {
+        const esp_timer_create_args_t args = {
+            .callback = wait_timer_callback,
+            .name = "macro_wait",
+        };
+        err = esp_timer_create(&args, &wait_timer);
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+    }
+    waiting_task = xTaskGetCurrentTaskHandle();
+
+    // Deadlines are absolute so time spent on GPIO writes does not accumulate
+    int64_t deadline = esp_timer_get_time();
+    macro_run_state_t run = {
+        .start_us = deadline,
+        .last_block_us = deadline,
+        .last_check_us = deadline,
+        .time_max_us = time_max_ms * 1000LL,
+        .stop_requested = stop_requested,
+    };
+
+    for (int r = 0; r < repeat && err == ESP_OK; r++)
+    {
+        uint16_t pc = 0;
+        while (err == ESP_OK && pc < macro->length && macro->code[pc] != MACRO_OP_HALT)
+        {
+            const uint8_t *code = macro->code;
+            switch (code[pc++])
+            {
+            case MACRO_OP_ON:
+                level = 1;
+                set_level(level);
+                break;
+            case MACRO_OP_OFF:
+                level = 0;
+                set_level(level);
+                break;
+            case MACRO_OP_TOGGLE:
+                level = !level;
+                set_level(level);
+                break;
+            case MACRO_OP_WAIT_US:
+                deadline += (uint32_t)code[pc] | ((uint32_t)code[pc + 1] << 8) |
+                            ((uint32_t)code[pc + 2] << 16) | ((uint32_t)code[pc + 3] << 24);
+                pc += 4;
+                err = wait_until(&run, deadline);
+                break;
+            case MACRO_OP_LOOP:
+                if (depth == MACRO_LOOP_DEPTH)
+                {
+                    return ESP_ERR_INVALID_STATE; // Corrupt bytecode
+                }
+                loops[depth].remaining = code[pc] | (code[pc + 1] << 8);
+                pc += 2;
+                loops[depth].start = pc;
+                depth++;
+                break;
+            case MACRO_OP_NEXT:
+                if (depth == 0)
+                {
+                    return ESP_ERR_INVALID_STATE; // Corrupt bytecode
+                }
+                if (--loops[depth - 1].remaining > 0)
+                {
+                    pc = loops[depth - 1].start;
+                }
+                else
+                {
+                    depth--;
+                }
+                err = check_run(&run);
+                break;
+            default:
+                return ESP_ERR_INVALID_STATE; // Corrupt bytecode
+            }
+        }
+    }
+    return err;
+}
@@ -0,0 +1,56 @@
+// LED command macros
+//
+// A macro is a named list of LED steps that is compiled once into a compact
+// bytecode, stored in NVS and executed locally, so a long light sequence
+// costs one serial command instead of one command per step.
+//
+// Source syntax (steps separated by ';'):
+//   ON | OFF | TOGGLE       - set the LED
+//   WAIT <ms> | WAITUS <us> - wait, measured from the previous step's deadline
+//   BLINK [N]               - same as the BLINK command (200 ms on / 200 ms off)
+//   REPEAT <N> ... END      - repeat the enclosed steps N times (nestable)
+//
+// Example: DEFINE SOS REPEAT 3;ON;WAIT 100;OFF;WAIT 100;END
+//
+// A running macro is stopped by Ctrl-C on its console (or by the client
+// disconnecting) and after its console's time limit (at most
+// MACRO_RUN_TIME_MAX_MS).
+
+#pragma once
+
+// Include standard integer types
+#include <stdint.h>
+
+// Include ESP32 error codes
+#include "esp_err.h"
+
+#define MACRO_NAME_MAX 15                      // Longest macro name (NVS key limit)
+#define MACRO_CODE_MAX 256                     // Largest compiled macro in bytes
+#define MACRO_LOOP_DEPTH 4                     // Deepest REPEAT nesting
+#define MACRO_RUN_MAX 10000                    // Largest repeat count accepted by RUN
+#define MACRO_RUN_TIME_MAX_MS (10 * 60 * 1000) // Longest RUN before it is stopped
+
+// Compiled macro
+typedef struct
+{
+    uint8_t code[MACRO_CODE_MAX]; // Bytecode
+    uint16_t length;              // Number of bytes used in code
+} macro_t;
+
+// Compile macro source into bytecode
+// On ESP_ERR_INVALID_ARG, *bad_step holds the 1-based index of the failing step.
+esp_err_t macro_compile(const char *source, macro_t *out, int *bad_step);
+
+// Store, load and delete compiled macros in NVS
+esp_err_t macro_save(const char *name, const macro_t *macro);
+esp_err_t macro_load(const char *name, macro_t *macro);
+esp_err_t macro_delete(const char *name);
+
+// Execute a macro repeat times
+// set_level is called for every LED change; level is the LED state before the run.
+// Waits block the calling task; stop_requested (may be NULL) is polled about
+// every millisecond of the run. Returns ESP_OK when the run completed,
+// ESP_FAIL when stopped on request, ESP_ERR_TIMEOUT after time_max_ms
+// and ESP_ERR_INVALID_STATE on corrupt bytecode.
+esp_err_t macro_run(const macro_t *macro, int repeat, int time_max_ms, int level,
+                    void (*set_level)(int level), int (*stop_requested)(void));
@@ -17,6 +17,40 @@
 // Include standard string library for string manipulation
 #include <string.h>
 
+// Include standard libraries for strtoul() and variable arguments
+#include <stdlib.h>
+#include <stdarg.h>
+
+// Include the hardware-independent line editor and command parser
+#include "command_parser.h"
+
+// Include LED command macros (compiled sequences stored in NVS)
+#include "macro.h"
+
+// Include non-volatile storage used to persist macros
+#include "nvs_flash.h"
+
+// Include FreeRTOS mutex used to run one command at a time
+#include "freertos/semphr.h"
+
+// Include static or dynamic mutex creation (RTOS allocation profile)
+#include "rtos_alloc.h"
+
+// Include the console interface shared with the TCP server
+#include "console.h"
+
+// Include the optional TCP command server
+#include "tcp_server.h"
+
+// Include cycle counters for parsing and dispatch
+#include "perf_counter.h"
+
+// Include CPU load, stack and heap telemetry
+#include "telemetry.h"
+
+// Include the binary event trace dumped by the TRACE command
+#include "trace_ring.h"
+
 // Define constants for LED GPIO pin
 // GPIO 2 is usually the onboard LED on ESP32 development boards
 #define LED_GPIO 2
@@ -28,20 +62,131 @@
 #define UART_RXD_PIN 3           // GPIO 3 = RX pin
 #define UART_BUF_SIZE 1024       // Buffer size for incoming data
 
-// Define command strings for LED control
-#define CMD_ON "ON"         // Command to turn LED ON
-#define CMD_OFF "OFF"       // Command to turn LED OFF
-#define CMD_TOGGLE "TOGGLE" // Command to toggle LED state
-#define CMD_BLINK "BLINK"   // Command to blink LED
-#define CMD_HELP "HELP"     // Command to show help
-#define CMD_EXIT "EXIT"     // Command to exit program
+// Longest command line, including the '\0' (DEFINE lines can be long)
+#define CMD_LINE_MAX 256
 
 // Define log tag for ESP32 logging system
 static const char *TAG = "SERIAL_LED";
 
+// Cycle counters reported by the PERF command
+static perf_counter_t parse_perf = PERF_COUNTER_INIT("parse_command");
+static perf_counter_t dispatch_perf = PERF_COUNTER_INIT("command_dispatch");
+
+// Trace event IDs (names are registered in app_main)
+enum
+{
+    TRACE_ID_COMMAND = 1, // process_command(), arg = command_status_t at the end
+    TRACE_ID_PARSE,       // parse_command(), arg = command_id_t at the end
+    TRACE_ID_GPIO,        // LED GPIO write, arg = level
+};
+
 // Global variable to track LED state (0=OFF, 1=ON)
 static int led_state = 0;
 
+// Tagged mode (console_t.tagged, per console)
+// In tagged mode every line is "<seq> <command>", nothing is echoed, no
+// prompt is shown and each command is answered with one compact line:
+//   ACK <seq> <led>      - command executed, <led> is the LED state after it
+//   NACK <seq> <reason>  - command rejected (UNKNOWN, BADARG, FAILED, BADSEQ)
+// This lets a host keep a window of commands in flight instead of waiting
+// for each human-readable reply.
+
+// Function to write console output to UART0 (through stdout)
+static void uart_console_write(void *ctx, const char *data, size_t len)
+{
+    fwrite(data, 1, len, stdout);
+}
+
+// Bytes received from UART but not yet fed to the line editor
+static uint8_t rx_chunk[64];
+static int rx_pos = 0;
+static int rx_len = 0;
+
+// Function to check UART0 for Ctrl-C while one of its commands runs
+// Pending bytes are moved into rx_chunk, so nothing typed ahead is lost.
+static int uart_console_interrupted(void *ctx)
+{
+    if (rx_pos > 0)
+    {
+        memmove(rx_chunk, rx_chunk + rx_pos, rx_len - rx_pos);
+        rx_len -= rx_pos;
+        rx_pos = 0;
+    }
+
+    size_t buffered = 0;
+    size_t room = sizeof(rx_chunk) - rx_len;
+    uart_get_buffered_data_len(UART_PORT_NUM, &buffered);
+    if (buffered > 0 && room > 0)
+    {
+        int len = uart_read_bytes(UART_PORT_NUM, rx_chunk + rx_len, buffered < room ? buffered : room, 0);
+        rx_len += len > 0 ? len : 0;
+    }
+    return memchr(rx_chunk, LINE_EDIT_INTERRUPT, rx_len) != NULL;
+}
+
+// Console for commands typed on UART0
+static console_t uart_console = {
+    .write = uart_console_write,
+    .ctx = NULL,
+    .tagged = 0,
+    .interrupted = uart_console_interrupted,
+};
+
+// Console whose command is currently executing (protected by command_mutex)
+static console_t *active_console = &uart_console;
+
+// Mutex so UART and TCP commands never run at the same time
+static SemaphoreHandle_t command_mutex;
+
+// Result of executing one command
+typedef enum
+{
+    CMD_STATUS_OK,      // Command executed
+    CMD_STATUS_UNKNOWN, // Command not recognised
+    CMD_STATUS_BAD_ARG, // Argument missing or out of range
+    CMD_STATUS_FAILED,  // Command understood but could not be completed
+} command_status_t;
+
+// Reason strings used in NACK lines, indexed by command_status_t
+static const char *const status_names[] = {"OK", "UNKNOWN", "BADARG", "FAILED"};
+
+// Function to write a reply to the active console, whatever its mode
+static void console_reply(const char *format, ...)
+{
+    char line[128]; // One reply line
+    va_list args;
+
+    va_start(args, format);
+    int len = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    if (len > 0)
+    {
+        active_console->write(active_console->ctx, line, len < (int)sizeof(line) ? len : (int)sizeof(line) - 1);
+    }
+}
+
+// Function to print a message meant for a human (suppressed in tagged mode)
+static void console_printf(const char *format, ...)
+{
+    char line[128]; // One message (long help lines are split by the caller)
+    va_list args;
+
+    if (active_console->tagged)
+    {
+        return;
+    }
+
+    va_start(args, format);
+    int len = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    if (len > 0)
+    {
+        active_console->write(active_console->ctx, line, len < (int)sizeof(line) ? len : (int)sizeof(line) - 1);
+    }
+}
+
 // Function to initialize UART (serial communication)
 void uart_init(void)
 {
@@ -98,8 +243,9 @@ void led_on(void)
 {
     // Set GPIO pin to HIGH (3.3V) to turn LED ON
     gpio_set_level(LED_GPIO, 1);
-    led_state = 1;             // Update global LED state
-    printf("LED turned ON\n"); // Print status to serial
+    TRACE_INSTANT(TRACE_ID_GPIO, 1);
+    led_state = 1;                     // Update global LED state
+    console_printf("LED turned ON\n"); // Print status to serial
     ESP_LOGI(TAG, "LED turned ON");
 }
 
@@ -108,11 +254,20 @@ void led_off(void)
 {
     // Set GPIO pin to LOW (0V) to turn LED OFF
     gpio_set_level(LED_GPIO, 0);
-    led_state = 0;              // Update global LED state
-    printf("LED turned OFF\n"); // Print status to serial
+    TRACE_INSTANT(TRACE_ID_GPIO, 0);
+    led_state = 0;                      // Update global LED state
+    console_printf("LED turned OFF\n"); // Print status to serial
     ESP_LOGI(TAG, "LED turned OFF");
 }
 
+// Function to set the LED without printing (used by macros)
+void led_set_level(int level)
+{
+    gpio_set_level(LED_GPIO, level);
+    TRACE_INSTANT(TRACE_ID_GPIO, level);
+    led_state = level;
+}
+
 // Function to toggle LED state
 void led_toggle(void)
 {
@@ -130,7 +285,7 @@ void led_toggle(void)
 // Function to blink LED specified number of times
 void led_blink(int times, int delay_ms)
 {
-    printf("Blinking LED %d times...\n", times);
+    console_printf("Blinking LED %d times...\n", times);
 
     // Loop to blink LED specified number of times
     for (int i = 0; i < times; i++)
@@ -142,157 +297,530 @@ void led_blink(int times, int delay_ms)
         vTaskDelay(delay_ms / portTICK_PERIOD_MS); // Wait specified delay
     }
 
-    printf("Blink complete!\n");
+    console_printf("Blink complete!\n");
     ESP_LOGI(TAG, "LED blinked %d times", times);
 }
 
 // Function to display help information
 void show_help(void)
 {
-    printf("\n=== ESP32 Serial LED Control ===\n");
-    printf("Available Commands:\n");
-    printf("  ON      - Turn LED ON\n");
-    printf("  OFF     - Turn LED OFF\n");
-    printf("  TOGGLE  - Toggle LED state\n");
-    printf("  BLINK   - Blink LED 5 times\n");
-    printf("  BLINK N - Blink LED N times (e.g., BLINK 3)\n");
-    printf("  STATUS  - Show current LED status\n");
-    printf("  HELP    - Show this help message\n");
-    printf("  EXIT    - Exit program (actually just stops accepting commands)\n");
-    printf("\nType command and press Enter:\n");
+    console_printf("\n=== ESP32 Serial LED Control ===\n");
+    console_printf("Available Commands:\n");
+    console_printf("  ON      - Turn LED ON\n");
+    console_printf("  OFF     - Turn LED OFF\n");
+    console_printf("  TOGGLE  - Toggle LED state\n");
+    console_printf("  BLINK   - Blink LED 5 times\n");
+    console_printf("  BLINK N - Blink LED N times (e.g., BLINK 3)\n");
+    console_printf("  STATUS  - Show current LED status\n");
+    console_printf("  DEFINE NAME STEPS - Store a macro (e.g., DEFINE SOS REPEAT 3;ON;WAIT 100;OFF;WAIT 100;END)\n");
+    console_printf("  RUN NAME [N]      - Run a stored macro N times (Ctrl-C stops it)\n");
+    console_printf("  UNDEF NAME        - Delete a stored macro\n");
+    console_printf("  TAGGED ON|OFF     - Pipelined mode: \"<seq> <command>\" lines, ACK/NACK replies\n");
+    console_printf("  PERF    - Show parse/dispatch cycle counts as JSON\n");
+    console_printf("  STATS   - Show CPU load per task, stack and heap usage\n");
+    console_printf("  TRACE   - Dump the event trace (tools/trace2perfetto.py)\n");
+    console_printf("  HELP    - Show this help message\n");
+    console_printf("  EXIT    - Exit program (actually just stops accepting commands)\n");
+    console_printf("\nType command and press Enter:\n");
+}
+
+// Function to show the cycle counters as one JSON line
+void show_perf(void)
+{
+    static char report[768]; // Longer than one console_printf() line
+
+    size_t len = perf_counter_format_json(report, sizeof(report));
+    console_printf("PERF ");
+    active_console->write(active_console->ctx, report, len);
+    console_printf("\n");
+}
+
+// Function to show the last telemetry sample (CPU, stacks, heap)
+void show_stats(void)
+{
+    static telemetry_sample_t sample; // Too large for the console stack
+
+    if (!telemetry_get(&sample))
+    {
+        console_printf("Telemetry not available\n");
+        return;
+    }
+
+    console_printf("Heap: free %lu, minimum %lu, largest block %lu bytes\n",
+                   (unsigned long)sample.heap_free, (unsigned long)sample.heap_min_free,
+                   (unsigned long)sample.heap_largest);
+    console_printf("Tasks: %u (CPU over the last %d ms, %% of one core)\n",
+                   sample.task_total, CONFIG_TELEMETRY_PERIOD_MS);
+    for (int i = 0; i < sample.task_count; i++)
+    {
+        const telemetry_task_t *task = &sample.tasks[i];
+        console_printf("  %-16s cpu %3u.%u%%  stack free %5lu  core %2d\n",
+                       task->name, task->cpu_permil / 10, task->cpu_permil % 10,
+                       (unsigned long)task->stack_free, task->core);
+    }
 }
 
 // Function to show current LED status
 void show_status(void)
 {
-    printf("LED Status: %s\n", led_state ? "ON" : "OFF");
-    printf("LED GPIO: %d\n", LED_GPIO);
+    console_printf("LED Status: %s\n", led_state ? "ON" : "OFF");
+    console_printf("LED GPIO: %d\n", LED_GPIO);
+}
+
+// Function to check a macro name (1-15 letters, digits or '_')
+static int macro_name_valid(const char *name, int len)
+{
+    if (len < 1 || len > MACRO_NAME_MAX)
+    {
+        return 0;
+    }
+    for (int i = 0; i < len; i++)
+    {
+        char c = name[i];
+        if (!((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_'))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Function to split "NAME rest" into a '\0'-terminated name and the rest
+// Returns NULL if the name is not valid.
+static const char *split_macro_name(const char *text, char *name)
+{
+    int len = 0;
+    while (text[len] != '\0' && text[len] != ' ')
+    {
+        len++;
+    }
+    if (!macro_name_valid(text, len))
+    {
+        return NULL;
+    }
+    memcpy(name, text, len);
+    name[len] = '\0';
+
+    text += len;
+    while (*text == ' ')
+    {
+        text++; // Skip spaces after the name
+    }
+    return text;
+}
+
+// Function to handle DEFINE NAME STEPS
+command_status_t macro_define(const char *text)
+{
+    static macro_t macro; // Compiled macro (static to keep it off the task stack)
+    char name[MACRO_NAME_MAX + 1];
+    int bad_step;
+
+    const char *source = split_macro_name(text, name);
+    if (source == NULL)
+    {
+        console_printf("Invalid macro name. Use 1-%d letters, digits or _.\n", MACRO_NAME_MAX);
+        return CMD_STATUS_BAD_ARG;
+    }
+
+    if (macro_compile(source, &macro, &bad_step) != ESP_OK)
+    {
+        console_printf("Invalid macro step %d.\n", bad_step);
+        return CMD_STATUS_BAD_ARG;
+    }
+
+    esp_err_t err = macro_save(name, &macro);
+    if (err != ESP_OK)
+    {
+        console_printf("Failed to store macro: %s\n", esp_err_to_name(err));
+        return CMD_STATUS_FAILED;
+    }
+
+    console_printf("Macro %s stored (%d bytes)\n", name, macro.length);
+    ESP_LOGI(TAG, "Macro %s stored (%d bytes)", name, macro.length);
+    return CMD_STATUS_OK;
+}
+
+// Function to poll the console running a macro for Ctrl-C
+static int macro_stop_requested(void)
+{
+    return active_console->interrupted != NULL && active_console->interrupted(active_console->ctx);
+}
+
+// Function to handle RUN NAME [N]
+command_status_t macro_execute(const char *text)
+{
+    static macro_t macro; // Loaded macro (static to keep it off the task stack)
+    char name[MACRO_NAME_MAX + 1];
+    int repeat = 1;
+
+    const char *rest = split_macro_name(text, name);
+    if (rest == NULL)
+    {
+        console_printf("Invalid macro name.\n");
+        return CMD_STATUS_BAD_ARG;
+    }
+
+    // Optional repeat count
+    if (*rest != '\0' && (sscanf(rest, "%d", &repeat) != 1 || repeat < 1 || repeat > MACRO_RUN_MAX))
+    {
+        console_printf("Invalid repeat count. Use 1-%d.\n", MACRO_RUN_MAX);
+        return CMD_STATUS_BAD_ARG;
+    }
+
+    esp_err_t err = macro_load(name, &macro);
+    if (err != ESP_OK)
+    {
+        console_printf("Unknown macro: %s\n", name);
+        return CMD_STATUS_FAILED;
+    }
+
+    // Every other console waits for the run: stop it at this console's limit
+    int time_max_ms = active_console->run_max_ms > 0 ? active_console->run_max_ms : MACRO_RUN_TIME_MAX_MS;
+    err = macro_run(&macro, repeat, time_max_ms, led_state, led_set_level, macro_stop_requested);
+    switch (err)
+    {
+    case ESP_OK:
+        console_printf("Macro %s done, LED %s\n", name, led_state ? "ON" : "OFF");
+        ESP_LOGI(TAG, "Macro %s ran %d times", name, repeat);
+        return CMD_STATUS_OK;
+    case ESP_FAIL:
+        console_printf("Macro %s interrupted, LED %s\n", name, led_state ? "ON" : "OFF");
+        break;
+    case ESP_ERR_TIMEOUT:
+        console_printf("Macro %s stopped after %d.%d s, LED %s\n", name, time_max_ms / 1000,
+                       time_max_ms % 1000 / 100, led_state ? "ON" : "OFF");
+        break;
+    default:
+        console_printf("Macro %s failed: %s\n", name, esp_err_to_name(err));
+        break;
+    }
+    ESP_LOGW(TAG, "Macro %s stopped: %s", name, esp_err_to_name(err));
+    return CMD_STATUS_FAILED;
+}
+
+// Function to handle UNDEF NAME
+command_status_t macro_undefine(const char *text)
+{
+    char name[MACRO_NAME_MAX + 1];
+
+    if (split_macro_name(text, name) == NULL)
+    {
+        console_printf("Invalid macro name.\n");
+        return CMD_STATUS_BAD_ARG;
+    }
+
+    if (macro_delete(name) != ESP_OK)
+    {
+        console_printf("Unknown macro: %s\n", name);
+        return CMD_STATUS_FAILED;
+    }
+
+    console_printf("Macro %s deleted\n", name);
+    return CMD_STATUS_OK;
+}
+
+// Function to switch tagged mode on or off (TAGGED ON / TAGGED OFF)
+command_status_t set_tagged_mode(const char *text)
+{
+    if (strcmp(text, "ON") == 0)
+    {
+        console_printf("Tagged mode ON\n");
+        active_console->tagged = 1;
+
+        // Log lines would interleave with ACK/NACK replies and slow the link
+        if (active_console == &uart_console)
+        {
+            esp_log_level_set(TAG, ESP_LOG_WARN);
+        }
+    }
+    else if (strcmp(text, "OFF") == 0)
+    {
+        active_console->tagged = 0;
+        if (active_console == &uart_console)
+        {
+            esp_log_level_set(TAG, ESP_LOG_INFO);
+        }
+        console_printf("Tagged mode OFF\n");
+    }
+    else
+    {
+        console_printf("Use TAGGED ON or TAGGED OFF.\n");
+        return CMD_STATUS_BAD_ARG;
+    }
+    return CMD_STATUS_OK;
 }
 
 // Function to read a line from UART (serial)
 int read_line(char *buffer, int max_len)
 {
-    int length = 0; // Track length of received string
-    char ch;        // Temporary character buffer
+    line_editor_t editor; // Line editor collecting characters into buffer
+
+    line_editor_init(&editor, buffer, max_len);
 
     // Read characters until newline or buffer full
-    while (length < max_len - 1)
+    while (1)
     {
-        // Read one character from UART
-        int len = uart_read_bytes(UART_PORT_NUM, (uint8_t *)&ch, 1, 20 / portTICK_PERIOD_MS);
-
-        // If character received
-        if (len > 0)
+        // Refill the local chunk when it is used up
+        if (rx_pos == rx_len)
         {
-            // Check for carriage return or newline (end of command)
-            if (ch == '\r' || ch == '\n')
+            size_t buffered = 0;
+            uart_get_buffered_data_len(UART_PORT_NUM, &buffered);
+
+            rx_pos = 0;
+            if (buffered > 0)
             {
-                buffer[length] = '\0'; // Null-terminate string
-                return length;         // Return string length
+                // Take everything already received in one call (pipelined commands)
+                rx_len = uart_read_bytes(UART_PORT_NUM, rx_chunk,
+                                         buffered < sizeof(rx_chunk) ? buffered : sizeof(rx_chunk), 0);
             }
-            // Handle backspace (delete character)
-            else if (ch == '\b' || ch == 127)
+            else
             {
-                if (length > 0)
-                {
-                    length--;        // Remove last character
-                    printf("\b \b"); // Erase from terminal
-                }
+                // Nothing pending: wait for the next character
+                rx_len = uart_read_bytes(UART_PORT_NUM, rx_chunk, 1, 20 / portTICK_PERIOD_MS);
             }
-            // Regular character
-            else
+
+            // Nothing received yet, keep waiting
+            if (rx_len <= 0)
             {
-                buffer[length] = ch; // Add to buffer
-                length++;            // Increment length
-                printf("%c", ch);    // Echo character to terminal
+                rx_len = 0;
+                continue;
             }
         }
-    }
 
-    buffer[length] = '\0'; // Null-terminate string
-    return length;         // Return string length
-}
+        char ch = rx_chunk[rx_pos++];
 
-// Function to process received command
-void process_command(char *cmd)
-{
-    // Convert command to uppercase for case-insensitive comparison
-    for (int i = 0; cmd[i]; i++)
-    {
-        if (cmd[i] >= 'a' && cmd[i] <= 'z')
+        // Let the line editor decide what the character means
+        switch (line_editor_feed(&editor, ch))
         {
-            cmd[i] = cmd[i] - 'a' + 'A';
+        case LINE_EDIT_APPENDED:
+            if (!uart_console.tagged)
+            {
+                printf("%c", ch); // Echo character to terminal
+            }
+            break;
+        case LINE_EDIT_ERASED:
+            if (!uart_console.tagged)
+            {
+                printf("\b \b"); // Erase from terminal
+            }
+            break;
+        case LINE_EDIT_FULL:
+            if (!uart_console.tagged)
+            {
+                printf("%c", ch); // Echo the last character that fit
+            }
+            return strlen(buffer); // Return string length
+        case LINE_EDIT_COMPLETE:
+            return strlen(buffer); // Return string length
+        case LINE_EDIT_CANCELLED:
+            if (!uart_console.tagged)
+            {
+                printf("^C\n> "); // Start over on a fresh prompt
+            }
+            break;
+        case LINE_EDIT_IGNORED:
+            break;
         }
     }
+}
+
+// Function to execute one command
+static command_status_t execute_command(char *cmd)
+{
+    command_t command; // Parsed command
+    uint32_t start = PERF_COUNTER_START();
+
+    // Parse command (also converts it to uppercase)
+    TRACE_BEGIN(TRACE_ID_PARSE, 0);
+    parse_command(cmd, &command);
+    TRACE_END(TRACE_ID_PARSE, command.id);
+    PERF_COUNTER_STOP(&parse_perf, start);
 
     ESP_LOGI(TAG, "Processing command: %s", cmd);
 
-    // Parse and execute command
-    if (strcmp(cmd, CMD_ON) == 0)
+    // Execute command
+    switch (command.id)
     {
+    case CMD_ID_ON:
         led_on(); // Turn LED ON
-    }
-    else if (strcmp(cmd, CMD_OFF) == 0)
-    {
+        break;
+    case CMD_ID_OFF:
         led_off(); // Turn LED OFF
-    }
-    else if (strcmp(cmd, CMD_TOGGLE) == 0)
-    {
+        break;
+    case CMD_ID_TOGGLE:
         led_toggle(); // Toggle LED state
-    }
-    else if (strncmp(cmd, CMD_BLINK, 5) == 0)
-    {
-        // Check if command has number argument (e.g., "BLINK 3")
-        int blink_times = 5; // Default: blink 5 times
-        if (strlen(cmd) > 5)
+        break;
+    case CMD_ID_BLINK:
+        if (command.arg_invalid)
         {
-            // Try to extract number from command
-            sscanf(cmd + 5, "%d", &blink_times);
-
-            // Validate number
-            if (blink_times < 1 || blink_times > 20)
+            console_printf("Invalid number. Use %d-%d.\n", BLINK_MIN_TIMES, BLINK_MAX_TIMES);
+            if (active_console->tagged)
             {
-                printf("Invalid number. Use 1-20.\n");
-                blink_times = 5; // Use default
+                return CMD_STATUS_BAD_ARG; // A host gets an error instead of a default
             }
         }
-        led_blink(blink_times, 200); // Blink with 200ms delay
+        if (active_console->run_max_ms > 0 && command.arg * 2 * 200 > active_console->run_max_ms)
+        {
+            // Every other console waits for the blink: keep it within the limit
+            console_printf("BLINK %d takes %d ms, this console allows %d ms.\n", command.arg,
+                           command.arg * 2 * 200, active_console->run_max_ms);
+            return CMD_STATUS_BAD_ARG;
+        }
+        led_blink(command.arg, 200); // Blink with 200ms delay
+        break;
+    case CMD_ID_STATUS:
+        if (!active_console->tagged)
+        {
+            show_status(); // Show LED status (the ACK already carries it)
+        }
+        break;
+    case CMD_ID_HELP:
+        if (!active_console->tagged)
+        {
+            show_help(); // Show help message
+        }
+        break;
+    case CMD_ID_EXIT:
+        console_printf("Exiting command mode. Press reset to restart.\n");
+        ESP_LOGI(TAG, "Exit command received");
+        // Note: We can't actually exit, but we can stop processing
+        break;
+    case CMD_ID_DEFINE:
+        return macro_define(command.text); // Compile and store a macro
+    case CMD_ID_RUN:
+        return macro_execute(command.text); // Run a stored macro
+    case CMD_ID_UNDEF:
+        return macro_undefine(command.text); // Delete a stored macro
+    case CMD_ID_TAGGED:
+        return set_tagged_mode(command.text); // Switch tagged mode
+    case CMD_ID_PERF:
+        if (!active_console->tagged)
+        {
+            show_perf(); // Show cycle counters
+        }
+        break;
+    case CMD_ID_STATS:
+        if (!active_console->tagged)
+        {
+            show_stats(); // Show CPU, stack and heap telemetry
+        }
+        break;
+    case CMD_ID_TRACE:
+        if (!active_console->tagged)
+        {
+            trace_dump(active_console->write, active_console->ctx); // Dump and clear the trace
+        }
+        break;
+    case CMD_ID_UNKNOWN:
+        console_printf("Unknown command: %s\n", cmd);
+        console_printf("Type HELP for available commands.\n");
+        return CMD_STATUS_UNKNOWN;
+    case CMD_ID_NONE:
+        break;
     }
-    else if (strcmp(cmd, "STATUS") == 0)
+
+    // Whole command cost, for the commands that do not wait (BLINK does)
+    if (command.id == CMD_ID_ON || command.id == CMD_ID_OFF || command.id == CMD_ID_TOGGLE)
     {
-        show_status(); // Show LED status
+        PERF_COUNTER_STOP(&dispatch_perf, start);
     }
-    else if (strcmp(cmd, CMD_HELP) == 0)
+    return CMD_STATUS_OK;
+}
+
+// Function to process received command
+command_status_t process_command(char *cmd)
+{
+    TRACE_BEGIN(TRACE_ID_COMMAND, 0);
+    command_status_t status = execute_command(cmd);
+    TRACE_END(TRACE_ID_COMMAND, status);
+    return status;
+}
+
+// Function to process a "<seq> <command>" line in tagged mode
+void process_tagged_line(char *line)
+{
+    char *cmd;
+    unsigned long seq = strtoul(line, &cmd, 10);
+
+    // The sequence number must be followed by a space (or end the line)
+    if (cmd == line || (*cmd != ' ' && *cmd != '\0'))
     {
-        show_help(); // Show help message
+        console_reply("NACK - BADSEQ\n");
+        return;
     }
-    else if (strcmp(cmd, CMD_EXIT) == 0)
+    while (*cmd == ' ')
     {
-        printf("Exiting command mode. Press reset to restart.\n");
-        ESP_LOGI(TAG, "Exit command received");
-        // Note: We can't actually exit, but we can stop processing
+        cmd++;
+    }
+
+    command_status_t status = process_command(cmd);
+    if (status == CMD_STATUS_OK)
+    {
+        console_reply("ACK %lu %d\n", seq, led_state);
+    }
+    else
+    {
+        console_reply("NACK %lu %s\n", seq, status_names[status]);
     }
-    else if (strlen(cmd) > 0)
+}
+
+// Function to execute one complete command line received on a console
+void console_execute_line(console_t *console, char *line)
+{
+    xSemaphoreTake(command_mutex, portMAX_DELAY);
+    active_console = console;
+
+    if (console->tagged)
+    {
+        process_tagged_line(line);
+    }
+    else
     {
-        printf("Unknown command: %s\n", cmd);
-        printf("Type HELP for available commands.\n");
+        process_command(line);
     }
+
+    active_console = &uart_console;
+    xSemaphoreGive(command_mutex);
 }
 
 // Main application function - entry point for ESP32 program
 void app_main(void)
 {
-    char command_buffer[64]; // Buffer to store received commands
+    char command_buffer[CMD_LINE_MAX]; // Buffer to store received commands
 
     // Set log level to INFO for debugging
     esp_log_level_set("*", ESP_LOG_INFO);
 
+    // Initialize NVS (stores macros)
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND)
+    {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(ret);
+
+    // Create the mutex shared by all command consoles
+    command_mutex = RTOS_MUTEX_CREATE();
+
     // Initialize LED
     led_init();
 
     // Initialize UART (serial communication)
     uart_init();
 
+    // Start sampling CPU load, stacks and heap for the STATS command
+    ESP_ERROR_CHECK(telemetry_start());
+
+    // Name the trace events for the TRACE dump
+    trace_name(TRACE_ID_COMMAND, "process_command");
+    trace_name(TRACE_ID_PARSE, "parse_command");
+    trace_name(TRACE_ID_GPIO, "gpio_set_level");
+
+    // Start the TCP command server (does nothing unless enabled in menuconfig)
+    tcp_server_start();
+
     // Show startup message
     printf("\n\n");
     printf("========================================\n");
@@ -310,7 +838,10 @@ void app_main(void)
     // Main program loop
     while (1)
     {
-        printf("\n> "); // Show command prompt
+        if (!uart_console.tagged)
+        {
+            printf("\n> "); // Show command prompt
+        }
 
         // Read command from serial
         int len = read_line(command_buffer, sizeof(command_buffer));
@@ -318,10 +849,18 @@ void app_main(void)
         // Process command if something was received
         if (len > 0)
         {
-            process_command(command_buffer);
+            console_execute_line(&uart_console, command_buffer);
         }
 
-        // Small delay to prevent CPU hogging
-        vTaskDelay(10 / portTICK_PERIOD_MS);
+        // Small delay to prevent CPU hogging, skipped while commands are queued
+        if (rx_pos == rx_len)
+        {
+            size_t buffered = 0;
+            uart_get_buffered_data_len(UART_PORT_NUM, &buffered);
+            if (buffered == 0)
+            {
+                vTaskDelay(10 / portTICK_PERIOD_MS);
+            }
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,377 @@
+// Include the TCP server interface
+#include "tcp_server.h"
+
+// Include project configuration (menuconfig options)
+#include "sdkconfig.h"
+
+#if CONFIG_SERIAL_LED_TCP_SERVER
+
+// Include standard libraries
+#include <stdio.h>
+#include <string.h>
+
+// Include ESP32 FreeRTOS headers for the server task
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Include static or dynamic task creation (RTOS allocation profile)
+#include "rtos_alloc.h"
+
+// Include ESP32 logging
+#include "esp_log.h"
+
+// Include the shared Wi-Fi station link
+#include "wifi_link.h"
+
+// Include LwIP sockets API
+#include "lwip/sockets.h"
+
+// Include the console interface and line editor
+#include "console.h"
+#include "command_parser.h"
+
+// Server configuration
+#define TCP_MAX_CLIENTS CONFIG_SERIAL_LED_TCP_MAX_CLIENTS
+#define TCP_LINE_MAX 256  // Longest command line, same as the serial console
+#define TCP_TX_SIZE 512   // Pending reply bytes per client
+#define TCP_RX_CHUNK 128  // Bytes read from a socket per recv()
+#define TCP_TX_WAIT_MS 50 // Longest wait for a slow reader when a reply does not fit in tx
+#define TCP_RUN_MAX_MS CONFIG_SERIAL_LED_TCP_RUN_MAX_MS // Longest BLINK or RUN per command
+
+// Every client needs a socket, plus one for the listening socket
+#if CONFIG_LWIP_MAX_SOCKETS < TCP_MAX_CLIENTS + 1
+#error "CONFIG_LWIP_MAX_SOCKETS must be at least CONFIG_SERIAL_LED_TCP_MAX_CLIENTS + 1"
+#endif
+
+// Log tag
+static const char *TAG = "TCP_SERVER";
+
+// One connected client; all buffers are fixed so nothing is allocated per connection
+typedef struct
+{
+    int sock;                  // Socket, -1 when the slot is free
+    console_t console;         // Console used to execute this client's commands
+    line_editor_t editor;      // Line editor state
+    char line[TCP_LINE_MAX];   // Line being received
+    char tx[TCP_TX_SIZE];      // Replies not yet sent
+    size_t tx_len;             // Bytes used in tx
+    unsigned long tx_overflow; // Reply bytes dropped because tx was full, not yet reported
+    int tx_stalled;            // Client missed TCP_TX_WAIT_MS; no more waiting until tx drains
+} tcp_client_t;
+
+static tcp_client_t clients[TCP_MAX_CLIENTS];
+
+// Function to send as much pending output as the socket accepts
+// Returns -1 if the connection failed.
+static int client_flush(tcp_client_t *client)
+{
+    while (client->tx_len > 0)
+    {
+        int sent = send(client->sock, client->tx, client->tx_len, 0);
+        if (sent < 0)
+        {
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+        }
+        memmove(client->tx, client->tx + sent, client->tx_len - sent);
+        client->tx_len -= sent;
+    }
+    return 0;
+}
+
+// Function to wait up to timeout_ms until tx has room for more output
+// Returns -1 if the client did not read in time or the connection failed.
+static int client_make_room(tcp_client_t *client, int timeout_ms)
+{
+    TickType_t start = xTaskGetTickCount();
+
+    while (client->tx_len == sizeof(client->tx))
+    {
+        int elapsed_ms = (xTaskGetTickCount() - start) * portTICK_PERIOD_MS;
+        if (elapsed_ms >= timeout_ms)
+        {
+            return -1;
+        }
+
+        fd_set write_fds;
+        FD_ZERO(&write_fds);
+        FD_SET(client->sock, &write_fds);
+        struct timeval timeout = {
+            .tv_sec = 0,
+            .tv_usec = (timeout_ms - elapsed_ms) * 1000,
+        };
+        if (select(client->sock + 1, NULL, &write_fds, NULL, &timeout) <= 0 || client_flush(client) < 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Function to queue reply bytes for a client (console write callback)
+// Output longer than tx (HELP, PERF, TRACE) is sent in chunks as the client
+// reads it. A client that stops reading loses the rest of the reply rather
+// than stalling every console; the loss is reported to it afterwards.
+static void client_write(void *ctx, const char *data, size_t len)
+{
+    tcp_client_t *client = (tcp_client_t *)ctx;
+
+    while (len > 0)
+    {
+        if (client->tx_len == sizeof(client->tx) &&
+            (client->tx_stalled || client_make_room(client, TCP_TX_WAIT_MS) < 0))
+        {
+            client->tx_stalled = 1;
+            client->tx_overflow += len;
+            return;
+        }
+
+        size_t room = sizeof(client->tx) - client->tx_len;
+        size_t chunk = len < room ? len : room;
+        memcpy(client->tx + client->tx_len, data, chunk);
+        client->tx_len += chunk;
+        data += chunk;
+        len -= chunk;
+    }
+}
+
+// Function to tell a client how much of its output was dropped, once
+// there is room for the notice
+static void client_report_overflow(tcp_client_t *client)
+{
+    char notice[48];
+    int len = snprintf(notice, sizeof(notice), "\n[%lu reply bytes dropped]\n", client->tx_overflow);
+
+    if (len > 0 && len <= (int)(sizeof(client->tx) - client->tx_len))
+    {
+        ESP_LOGW(TAG, "Client on socket %d: %lu reply bytes dropped", client->sock, client->tx_overflow);
+        memcpy(client->tx + client->tx_len, notice, len);
+        client->tx_len += len;
+        client->tx_overflow = 0;
+    }
+}
+
+// Function to check a client for Ctrl-C or a closed connection while one of
+// its commands runs (console interrupted callback); the data stays queued
+static int client_interrupted(void *ctx)
+{
+    tcp_client_t *client = (tcp_client_t *)ctx;
+    char pending[TCP_RX_CHUNK];
+
+    int len = recv(client->sock, pending, sizeof(pending), MSG_PEEK | MSG_DONTWAIT);
+    return len == 0 || (len > 0 && memchr(pending, LINE_EDIT_INTERRUPT, len) != NULL);
+}
+
+// Function to release a client slot
+static void client_close(tcp_client_t *client)
+{
+    ESP_LOGI(TAG, "Client on socket %d closed", client->sock);
+    close(client->sock);
+    client->sock = -1;
+}
+
+// Function to accept a new connection into a free slot
+static void accept_client(int listen_sock)
+{
+    int sock = accept(listen_sock, NULL, NULL);
+    if (sock < 0)
+    {
+        return;
+    }
+
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++)
+    {
+        tcp_client_t *client = &clients[i];
+        if (client->sock < 0)
+        {
+            // Non-blocking so one slow client cannot stall the others
+            fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+
+            int nodelay = 1; // Replies are small; do not wait to coalesce them
+            setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+            client->sock = sock;
+            client->console.write = client_write;
+            client->console.ctx = client;
+            client->console.tagged = 0;
+            client->console.interrupted = client_interrupted;
+            client->console.run_max_ms = TCP_RUN_MAX_MS;
+            client->tx_len = 0;
+            client->tx_overflow = 0;
+            client->tx_stalled = 0;
+            line_editor_init(&client->editor, client->line, sizeof(client->line));
+            ESP_LOGI(TAG, "Client on socket %d connected (slot %d)", sock, i);
+            return;
+        }
+    }
+
+    // All slots busy
+    ESP_LOGW(TAG, "Too many clients, rejecting connection");
+    close(sock);
+}
+
+// Function to read from a client and execute every complete line
+// Returns -1 if the connection should be closed.
+static int client_receive(tcp_client_t *client)
+{
+    char chunk[TCP_RX_CHUNK];
+    int len = recv(client->sock, chunk, sizeof(chunk), 0);
+
+    if (len == 0)
+    {
+        return -1; // Peer closed the connection
+    }
+    if (len < 0)
+    {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+    }
+
+    for (int i = 0; i < len; i++)
+    {
+        line_edit_result_t result = line_editor_feed(&client->editor, chunk[i]);
+        if ((result == LINE_EDIT_COMPLETE || result == LINE_EDIT_FULL) && client->line[0] != '\0')
+        {
+            console_execute_line(&client->console, client->line);
+        }
+    }
+    return 0;
+}
+
+// Function to create the listening socket
+static int create_listen_socket(void)
+{
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+    if (sock < 0)
+    {
+        ESP_LOGE(TAG, "Failed to create socket: error %d", errno);
+        return -1;
+    }
+
+    int reuse = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(CONFIG_SERIAL_LED_TCP_PORT);
+
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(sock, 4) < 0)
+    {
+        ESP_LOGE(TAG, "Failed to listen on port %d: error %d", CONFIG_SERIAL_LED_TCP_PORT, errno);
+        close(sock);
+        return -1;
+    }
+
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+    return sock;
+}
+
+// Server task: one select() loop for the listening socket and all clients
+static void tcp_server_task(void *arg)
+{
+    int listen_sock = create_listen_socket();
+    if (listen_sock < 0)
+    {
+        vTaskDelete(NULL);
+        return;
+    }
+
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++)
+    {
+        clients[i].sock = -1;
+    }
+
+    ESP_LOGI(TAG, "Listening on port %d (max %d clients)", CONFIG_SERIAL_LED_TCP_PORT, TCP_MAX_CLIENTS);
+
+    while (1)
+    {
+        fd_set read_fds;
+        fd_set write_fds;
+        int max_fd = listen_sock;
+
+        FD_ZERO(&read_fds);
+        FD_ZERO(&write_fds);
+        FD_SET(listen_sock, &read_fds);
+
+        for (int i = 0; i < TCP_MAX_CLIENTS; i++)
+        {
+            tcp_client_t *client = &clients[i];
+            if (client->sock < 0)
+            {
+                continue;
+            }
+            FD_SET(client->sock, &read_fds);
+            if (client->tx_len > 0)
+            {
+                FD_SET(client->sock, &write_fds); // Wait for room to send pending replies
+            }
+            if (client->sock > max_fd)
+            {
+                max_fd = client->sock;
+            }
+        }
+
+        if (select(max_fd + 1, &read_fds, &write_fds, NULL, NULL) < 0)
+        {
+            ESP_LOGE(TAG, "select() failed: error %d", errno);
+            vTaskDelay(100 / portTICK_PERIOD_MS);
+            continue;
+        }
+
+        if (FD_ISSET(listen_sock, &read_fds))
+        {
+            accept_client(listen_sock);
+        }
+
+        for (int i = 0; i < TCP_MAX_CLIENTS; i++)
+        {
+            tcp_client_t *client = &clients[i];
+            if (client->sock < 0)
+            {
+                continue;
+            }
+
+            int failed = 0;
+            if (FD_ISSET(client->sock, &read_fds))
+            {
+                failed = client_receive(client) < 0;
+            }
+
+            // Replies produced by this round are sent right away when possible
+            if (!failed && client->tx_len > 0)
+            {
+                failed = client_flush(client) < 0;
+            }
+            if (!failed && client->tx_overflow > 0)
+            {
+                client_report_overflow(client);
+                failed = client_flush(client) < 0;
+            }
+            if (client->tx_len == 0)
+            {
+                client->tx_stalled = 0; // Reading again: wait for it next time
+            }
+
+            if (failed)
+            {
+                client_close(client);
+            }
+        }
+    }
+}
+
+// Function to connect to Wi-Fi and start the server task
+void tcp_server_start(void)
+{
+    ESP_ERROR_CHECK(wifi_link_start(CONFIG_SERIAL_LED_WIFI_SSID, CONFIG_SERIAL_LED_WIFI_PASSWORD));
+    RTOS_TASK_CREATE_PINNED(tcp_server_task, "tcp_server", 4096, NULL, 5, NULL, tskNO_AFFINITY);
+}
+
+#else
+
+// TCP server disabled in menuconfig
+void tcp_server_start(void)
+{
+}
+
+#endif
@@ -0,0 +1,11 @@
+// TCP command server
+//
+// Serves the serial command set over Wi-Fi. One task multiplexes all
+// clients with non-blocking lwIP sockets and select(); each connection has
+// fixed receive and transmit buffers instead of its own task.
+// Enabled with "Serial LED TCP server" in menuconfig.
+
+#pragma once
+
+// Connect to Wi-Fi and start the server task (no-op when disabled)
+void tcp_server_start(void);
@@ -0,0 +1,235 @@
+// Include the deferred logging interface
+#include "dlog.h"
+
+// Include standard input/output library for snprintf() and the output
+#include <stdio.h>
+#include <string.h>
+
+// Include ESP32 FreeRTOS headers
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Include static or dynamic task creation (RTOS allocation profile)
+#include "rtos_alloc.h"
+
+// Cost of every DLOG* call (CONFIG_DLOG_MEASURE)
+perf_counter_t dlog_perf = PERF_COUNTER_INIT("log_call");
+
+#if CONFIG_DLOG_ENABLE
+
+// Ring size in 32-bit words (CONFIG_DLOG_BUFFER_SIZE is in bytes)
+#define RING_WORDS (CONFIG_DLOG_BUFFER_SIZE / 4)
+
+_Static_assert((RING_WORDS & (RING_WORDS - 1)) == 0, "CONFIG_DLOG_BUFFER_SIZE must be a power of two");
+
+// Record header words: timestamp (ms) and descriptor address
+#define HEADER_WORDS 2
+
+// Longest formatted line
+#define LINE_MAX 160
+
+// Ring of records (header + arguments), written by any task, read by the log task
+static uint32_t ring[RING_WORDS];
+static uint32_t ring_head; // Next word to write
+static uint32_t ring_tail; // Next word to read
+static uint32_t dropped;
+static portMUX_TYPE ring_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Level letters as printed by ESP_LOGx, indexed by esp_log_level_t
+static const char level_letters[] = "NEWIDV";
+
+void dlog_write(const dlog_format_t *format, const uint32_t *args)
+{
+    uint32_t words = HEADER_WORDS + format->nargs;
+    uint32_t now = esp_log_timestamp();
+
+    taskENTER_CRITICAL(&ring_lock);
+    if (RING_WORDS - (ring_head - ring_tail) < words)
+    {
+        dropped++;
+        taskEXIT_CRITICAL(&ring_lock);
+        return;
+    }
+    ring[ring_head++ % RING_WORDS] = now;
+    ring[ring_head++ % RING_WORDS] = (uint32_t)(uintptr_t)format;
+    for (uint32_t i = 0; i < format->nargs; i++)
+    {
+        ring[ring_head++ % RING_WORDS] = args[i];
+    }
+    taskEXIT_CRITICAL(&ring_lock);
+}
+
+uint32_t dlog_dropped(void)
+{
+    return dropped;
+}
+
+// Take the oldest record; returns its length in words, 0 if the ring is empty
+static uint32_t take_record(uint32_t *record)
+{
+    uint32_t words = 0;
+
+    taskENTER_CRITICAL(&ring_lock);
+    if (ring_tail != ring_head)
+    {
+        const dlog_format_t *format = (const dlog_format_t *)(uintptr_t)ring[(ring_tail + 1) % RING_WORDS];
+        words = HEADER_WORDS + format->nargs;
+        for (uint32_t i = 0; i < words; i++)
+        {
+            record[i] = ring[ring_tail++ % RING_WORDS];
+        }
+    }
+    taskEXIT_CRITICAL(&ring_lock);
+    return words;
+}
+
+#if CONFIG_DLOG_OUTPUT_TEXT
+
+// Format one argument with a single conversion spec ("%5.1f", "%lu", ...)
+static int format_arg(char *out, size_t size, const char *spec, size_t spec_len, uint32_t value)
+{
+    char conversion[16];
+    size_t len = 0;
+
+    // Copy the spec without length modifiers: every argument is 32 bits
+    for (size_t i = 0; i < spec_len && len < sizeof(conversion) - 1; i++)
+    {
+        if (strchr("hlLqjzt", spec[i]) == NULL)
+        {
+            conversion[len++] = spec[i];
+        }
+    }
+    conversion[len] = '\0';
+
+    switch (spec[spec_len - 1])
+    {
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    {
+        union
+        {
+            uint32_t u;
+            float f;
+        } bits = {.u = value};
+        return snprintf(out, size, conversion, (double)bits.f);
+    }
+    case 's':
+        return snprintf(out, size, conversion, value ? (const char *)(uintptr_t)value : "(null)");
+    case 'p':
+        return snprintf(out, size, conversion, (void *)(uintptr_t)value);
+    default:
+        return snprintf(out, size, conversion, value);
+    }
+}
+
+// Format a record like ESP_LOGx does: "I (1234) TAG: message"
+static void print_record(const uint32_t *record)
+{
+    const dlog_format_t *format = (const dlog_format_t *)(uintptr_t)record[1];
+    const uint32_t *args = &record[HEADER_WORDS];
+    char line[LINE_MAX];
+    size_t len;
+    int arg = 0;
+
+    len = snprintf(line, sizeof(line), "%c (%lu) %s: ", level_letters[format->level],
+                   (unsigned long)record[0], *format->tag);
+
+    for (const char *p = format->format; *p != '\0' && len < sizeof(line) - 1;)
+    {
+        if (*p != '%')
+        {
+            line[len++] = *p++;
+            continue;
+        }
+        if (p[1] == '%')
+        {
+            line[len++] = '%';
+            p += 2;
+            continue;
+        }
+
+        // Conversion spec: flags, width, precision, length, conversion letter
+        size_t spec_len = 1 + strspn(p + 1, "-+ #0123456789.hlLqjzt");
+        if (p[spec_len] == '\0')
+        {
+            break;
+        }
+        spec_len++;
+        int written = arg < format->nargs ? format_arg(line + len, sizeof(line) - len, p, spec_len, args[arg++]) : 0;
+        len += written > 0 ? (size_t)written : 0;
+        p += spec_len;
+    }
+    if (len > sizeof(line) - 1)
+    {
+        len = sizeof(line) - 1; // Truncated
+    }
+    line[len] = '\0';
+    printf("%s\n", line);
+}
+
+#else
+
+// Print a record as hex words for tools/dlog.py decode
+static void print_record(const uint32_t *record)
+{
+    const dlog_format_t *format = (const dlog_format_t *)(uintptr_t)record[1];
+
+    printf("DLOG");
+    for (uint32_t i = 0; i < HEADER_WORDS + format->nargs; i++)
+    {
+        printf(" %08lx", (unsigned long)record[i]);
+    }
+    printf("\n");
+}
+
+#endif
+
+// Low-priority task: format and print whatever has been logged
+static void dlog_task(void *arg)
+{
+    uint32_t record[HEADER_WORDS + 8];
+    uint32_t reported_drops = 0;
+
+    while (1)
+    {
+        while (take_record(record) > 0)
+        {
+            print_record(record);
+        }
+
+        uint32_t drops = dropped;
+        if (drops != reported_drops)
+        {
+            printf("W (%lu) dlog: %lu messages dropped\n", (unsigned long)esp_log_timestamp(),
+                   (unsigned long)(drops - reported_drops));
+            reported_drops = drops;
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_DLOG_FLUSH_PERIOD_MS));
+    }
+}
+
+esp_err_t dlog_start(void)
+{
+    BaseType_t created = RTOS_TASK_CREATE_PINNED(dlog_task, "dlog", CONFIG_DLOG_TASK_STACK, NULL,
+                                                 CONFIG_DLOG_TASK_PRIORITY, NULL, tskNO_AFFINITY);
+    return created == pdPASS ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+#else
+
+esp_err_t dlog_start(void)
+{
+    return ESP_OK;
+}
+
+uint32_t dlog_dropped(void)
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,112 @@
+// Cost per call of deferred logging against ESP_LOGI
+//
+//   bench_dlog [calls]
+//
+// Logs the same message, the per-ping line of b-net-connect, with DLOGI and
+// with ESP_LOGI, and prints one line per case:
+//
+//   BENCH {"name":"log_dlogi","target":"host","calls":20000,"seconds":0.001,"ns_per_call":40,"ops_per_s":25000000}
+//
+// The log task runs and formats the DLOGI records as on the board; both
+// outputs go to /dev/null, so ESP_LOGI pays for formatting but not for the
+// UART. Host numbers compare the two paths and revisions, not the ESP32.
+// Fails when a record was dropped or DLOGI is not the cheaper of the two.
+
+// Include standard input/output, library, clock and POSIX functions
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+// Include the deferred logging interface
+#include "dlog.h"
+
+static const char *TAG = "PING";
+
+// Calls logged between two pauses that let the log task drain the ring
+#define BATCH 1000
+
+// Benchmark results go to the original stdout; the logs go to /dev/null
+static FILE *report_out;
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double report(const char *name, long calls, double seconds)
+{
+    double ns_per_call = calls > 0 ? seconds * 1e9 / calls : 0.0;
+
+    fprintf(report_out,
+            "BENCH {\"name\":\"%s\",\"target\":\"host\",\"calls\":%ld,\"seconds\":%.3f,\"ns_per_call\":%.0f,"
+            "\"ops_per_s\":%.0f}\n",
+            name, calls, seconds, ns_per_call, seconds > 0 ? calls / seconds : 0.0);
+    return ns_per_call;
+}
+
+// Only the logging calls are timed, not the pauses between batches
+static double bench_dlogi(long calls)
+{
+    double elapsed = 0;
+
+    for (long done = 0; done < calls; done += BATCH)
+    {
+        double start = now_seconds();
+        for (long i = done; i < done + BATCH && i < calls; i++)
+        {
+            DLOGI(TAG, "Ping #%d: %d bytes from %s time=%d us", (int)i, 64, "192.168.1.1", 1234);
+        }
+        elapsed += now_seconds() - start;
+        usleep(20000);
+    }
+    return report("log_dlogi", calls, elapsed);
+}
+
+static double bench_esp_logi(long calls)
+{
+    double start = now_seconds();
+    for (long i = 0; i < calls; i++)
+    {
+        ESP_LOGI(TAG, "Ping #%d: %d bytes from %s time=%d us", (int)i, 64, "192.168.1.1", 1234);
+    }
+    return report("log_esp_logi", calls, now_seconds() - start);
+}
+
+int main(int argc, char **argv)
+{
+    long calls = argc > 1 ? atol(argv[1]) : 100000;
+
+    report_out = fdopen(dup(fileno(stdout)), "w");
+    setvbuf(report_out, NULL, _IOLBF, 0);
+    if (freopen("/dev/null", "w", stdout) == NULL || freopen("/dev/null", "w", stderr) == NULL)
+    {
+        return 1;
+    }
+    setenv("HOST_LOG", "1", 1); // The ESP_LOGI stand-in formats only when set
+
+    if (dlog_start() != ESP_OK)
+    {
+        fprintf(report_out, "dlog_start failed\n");
+        return 1;
+    }
+
+    double deferred = bench_dlogi(calls);
+    double stock = bench_esp_logi(calls);
+
+    if (dlog_dropped() != 0)
+    {
+        fprintf(report_out, "FAILED: %lu records dropped\n", (unsigned long)dlog_dropped());
+        return 1;
+    }
+    if (deferred >= stock)
+    {
+        fprintf(report_out, "FAILED: DLOGI %.0f ns per call, ESP_LOGI %.0f ns\n", deferred, stock);
+        return 1;
+    }
+    fprintf(report_out, "OK\n");
+    return 0;
+}
@@ -0,0 +1,15 @@
+// Configuration for the host build of the deferred logging component
+// (Kconfig defaults, with the ring large enough for one benchmark batch)
+#pragma once
+
+#define CONFIG_IDF_TARGET "linux"
+#define CONFIG_IDF_TARGET_LINUX 1
+#define CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ 160
+#define CONFIG_PERF_COUNTER_ENABLE 1
+#define CONFIG_DLOG_ENABLE 1
+#define CONFIG_DLOG_MEASURE 0
+#define CONFIG_DLOG_BUFFER_SIZE 65536
+#define CONFIG_DLOG_OUTPUT_TEXT 1
+#define CONFIG_DLOG_FLUSH_PERIOD_MS 20
+#define CONFIG_DLOG_TASK_PRIORITY 1
+#define CONFIG_DLOG_TASK_STACK 3072
@@ -0,0 +1,165 @@
+// Deferred logging
+//
+// DLOGI(TAG, "Ping #%d sent", seq) stores only the address of a static
+// descriptor (format string, tag, line, level) and the raw arguments, one
+// 32-bit word each, in a RAM ring. A low-priority task formats the records
+// later, so the calling task never runs printf-style formatting or waits on
+// the UART. With CONFIG_DLOG_OUTPUT_BINARY the task prints the records as
+// "DLOG <hex>" lines instead and the host formats them with
+//
+//   tools/dlog.py decode build/dlog_table.json serial.log
+//
+// where dlog_table.json is extracted from the ELF after every build (call
+// dlog_extract_table() after project() in the project CMakeLists.txt).
+//
+// Arguments are 32-bit: integers, float/double (stored as float) and
+// strings; a wider integer argument is a compile error. A string is stored
+// as a pointer and read when the record is formatted, so it must be a
+// literal or other static string; the host decoder prints the address.
+// TAG must be a variable (its address goes into the descriptor). Level
+// filtering is compile-time only (LOG_LOCAL_LEVEL); esp_log_level_set()
+// does not affect deferred records. When the ring is full new records are
+// dropped and counted.
+//
+// With CONFIG_DLOG_ENABLE off the DLOG* macros are plain ESP_LOG* calls.
+// With CONFIG_DLOG_MEASURE (off by default) each call, deferred or not,
+// is timed by the "log_call" perf counter, so two builds compare the cost
+// per call.
+
+#pragma once
+
+// Include standard integer types
+#include <stdint.h>
+
+// Include ESP32 error codes and the stock logging macros
+#include "esp_err.h"
+#include "esp_log.h"
+
+// Include cycle counters for CONFIG_DLOG_MEASURE
+#include "perf_counter.h"
+
+// Include sdkconfig for CONFIG_DLOG_*
+#include "sdkconfig.h"
+
+// Call site descriptor (in flash, one per DLOG* call)
+typedef struct
+{
+    const char *format;           // printf format string
+    const char *const *tag;       // Address of the caller's TAG variable
+    uint16_t line;                // Source line
+    uint8_t level;                // esp_log_level_t
+    uint8_t nargs;                // Argument words that follow the record header
+} dlog_format_t;
+
+// Start the task that drains the ring (records are kept until then)
+esp_err_t dlog_start(void);
+
+// Records dropped because the ring was full
+uint32_t dlog_dropped(void);
+
+// Store one record (called by the DLOG* macros)
+void dlog_write(const dlog_format_t *format, const uint32_t *args);
+
+// Counter timing every DLOG* call (CONFIG_DLOG_MEASURE)
+extern perf_counter_t dlog_perf;
+
+#if CONFIG_DLOG_MEASURE
+#define DLOG_MEASURE_START() uint32_t _dlog_start = PERF_COUNTER_START()
+#define DLOG_MEASURE_STOP() PERF_COUNTER_STOP(&dlog_perf, _dlog_start)
+#else
+#define DLOG_MEASURE_START()
+#define DLOG_MEASURE_STOP()
+#endif
+
+#if CONFIG_DLOG_ENABLE
+
+// Argument conversion to one 32-bit word
+static inline uint32_t dlog_from_int(int32_t value)
+{
+    return (uint32_t)value;
+}
+
+static inline uint32_t dlog_from_float(float value)
+{
+    union
+    {
+        float f;
+        uint32_t u;
+    } bits = {.f = value};
+    return bits.u;
+}
+
+static inline uint32_t dlog_from_ptr(const void *value)
+{
+    return (uint32_t)(uintptr_t)value;
+}
+
+// Integer arguments wider than 32 bits (int64_t, long long) would be
+// truncated by dlog_from_int(): reject them at compile time
+#define DLOG_ARG_FITS(x) _Generic((x),         \
+    float: 1,                                  \
+    double: 1,                                 \
+    char *: 1,                                 \
+    const char *: 1,                           \
+    void *: 1,                                 \
+    const void *: 1,                           \
+    default: sizeof(x) <= sizeof(int32_t))
+#define DLOG_ARG_CHECK(x) \
+    ((void)sizeof(struct { _Static_assert(DLOG_ARG_FITS(x), "DLOG arguments are 32-bit; cast or use ESP_LOGx"); int unused; }))
+
+#define DLOG_ARG(x) (DLOG_ARG_CHECK(x), _Generic((x), \
+    float: dlog_from_float,                    \
+    double: dlog_from_float,                   \
+    char *: dlog_from_ptr,                     \
+    const char *: dlog_from_ptr,               \
+    void *: dlog_from_ptr,                     \
+    const void *: dlog_from_ptr,               \
+    default: dlog_from_int)(x))
+
+// Argument count and list (up to 8 arguments)
+#define DLOG_NARGS(...) DLOG_NARGS_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define DLOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+#define DLOG_CAT(a, b) DLOG_CAT_(a, b)
+#define DLOG_CAT_(a, b) a##b
+#define DLOG_ARGS_0()
+#define DLOG_ARGS_1(a) DLOG_ARG(a)
+#define DLOG_ARGS_2(a, ...) DLOG_ARG(a), DLOG_ARGS_1(__VA_ARGS__)
+#define DLOG_ARGS_3(a, ...) DLOG_ARG(a), DLOG_ARGS_2(__VA_ARGS__)
+#define DLOG_ARGS_4(a, ...) DLOG_ARG(a), DLOG_ARGS_3(__VA_ARGS__)
+#define DLOG_ARGS_5(a, ...) DLOG_ARG(a), DLOG_ARGS_4(__VA_ARGS__)
+#define DLOG_ARGS_6(a, ...) DLOG_ARG(a), DLOG_ARGS_5(__VA_ARGS__)
+#define DLOG_ARGS_7(a, ...) DLOG_ARG(a), DLOG_ARGS_6(__VA_ARGS__)
+#define DLOG_ARGS_8(a, ...) DLOG_ARG(a), DLOG_ARGS_7(__VA_ARGS__)
+
+// The descriptor name is what tools/dlog.py looks for in the ELF symbol table
+#define DLOG_LEVEL(level, tag, fmt, ...)                                                  \
+    do                                                                                    \
+    {                                                                                     \
+        if (LOG_LOCAL_LEVEL >= (level))                                                   \
+        {                                                                                 \
+            DLOG_MEASURE_START();                                                         \
+            static const dlog_format_t _dlog_format = {                                   \
+                (fmt), &(tag), __LINE__, (level), DLOG_NARGS(__VA_ARGS__)};               \
+            const uint32_t _dlog_args[DLOG_NARGS(__VA_ARGS__) + 1] = {                     \
+                DLOG_CAT(DLOG_ARGS_, DLOG_NARGS(__VA_ARGS__))(__VA_ARGS__)};               \
+            dlog_write(&_dlog_format, _dlog_args);                                        \
+            DLOG_MEASURE_STOP();                                                          \
+        }                                                                                 \
+    } while (0)
+
+#else
+
+#define DLOG_LEVEL(level, tag, fmt, ...)                   \
+    do                                                     \
+    {                                                      \
+        DLOG_MEASURE_START();                              \
+        ESP_LOG_LEVEL_LOCAL((level), tag, fmt, ##__VA_ARGS__); \
+        DLOG_MEASURE_STOP();                               \
+    } while (0)
+
+#endif
+
+#define DLOGE(tag, fmt, ...) DLOG_LEVEL(ESP_LOG_ERROR, tag, fmt, ##__VA_ARGS__)
+#define DLOGW(tag, fmt, ...) DLOG_LEVEL(ESP_LOG_WARN, tag, fmt, ##__VA_ARGS__)
+#define DLOGI(tag, fmt, ...) DLOG_LEVEL(ESP_LOG_INFO, tag, fmt, ##__VA_ARGS__)
+#define DLOGD(tag, fmt, ...) DLOG_LEVEL(ESP_LOG_DEBUG, tag, fmt, ##__VA_ARGS__)
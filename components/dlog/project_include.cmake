@@ -0,0 +1,13 @@
+# Extract the deferred log format table from the ELF after every build.
+# Call after project():  dlog_extract_table()
+set(DLOG_TOOL ${CMAKE_CURRENT_LIST_DIR}/../../tools/dlog.py)
+
+function(dlog_extract_table)
+    idf_build_get_property(build_dir BUILD_DIR)
+    idf_build_get_property(python PYTHON)
+    set(elf ${CMAKE_PROJECT_NAME}.elf)
+    add_custom_command(TARGET ${elf} POST_BUILD
+        COMMAND ${python} ${DLOG_TOOL} extract $<TARGET_FILE:${elf}> -o ${build_dir}/dlog_table.json
+        COMMENT "Extracting deferred log formats to dlog_table.json"
+        VERBATIM)
+endfunction()
@@ -0,0 +1,306 @@
+// Include the probe engine interface
+#include "icmp_probe.h"
+
+// Include standard string and character functions
+#include <string.h>
+#include <ctype.h>
+
+// Include ESP32 FreeRTOS headers
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Include ESP32 logging and high resolution timer
+#include "esp_log.h"
+#include "esp_timer.h"
+
+// Include LwIP sockets and ICMP headers
+#include "lwip/sockets.h"
+#include "lwip/icmp.h"
+#include "lwip/inet_chksum.h"
+
+// Include static or dynamic task creation (RTOS allocation profile)
+#include "rtos_alloc.h"
+
+// Log tag
+static const char *TAG = "ICMP_PROBE";
+
+// Echo request identifier (also used by b-net-connect's ping)
+#define PROBE_ID 0xABCE
+
+// Echo request payload size
+#define PROBE_DATA_SIZE 32
+_Static_assert(sizeof(struct icmp_echo_hdr) + PROBE_DATA_SIZE == ICMP_PROBE_PACKET_SIZE,
+               "ICMP_PROBE_PACKET_SIZE must match the header and payload");
+
+// Receive timeout of one recvfrom() while waiting for the matching reply
+#define PROBE_POLL_MS 100
+
+// Per-target accumulator for the current window
+typedef struct
+{
+    uint32_t address;
+    uint16_t sent;
+    uint16_t received;
+    uint64_t rtt_sum_us;
+    uint32_t rtt_min_us;
+    uint32_t rtt_max_us;
+    uint64_t jitter_sum_us;
+    uint32_t jitter_count;
+    uint32_t last_rtt_us; // Previous reply's RTT (valid when received > 0)
+} probe_target_t;
+
+// Targets and statistics (stats_lock)
+static probe_target_t targets[ICMP_PROBE_MAX_TARGETS];
+static int target_count;
+static int64_t window_start_us;
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Probe task state
+static uint32_t probe_interval_ms;
+static int probe_sock = -1;
+static uint16_t probe_seq;
+static uint8_t probe_packet[ICMP_PROBE_PACKET_SIZE];
+static uint8_t reply_buffer[128];
+
+// Add one probe result (rtt_us < 0 = lost) to a target's window
+static void record_probe(probe_target_t *target, int32_t rtt_us)
+{
+    taskENTER_CRITICAL(&stats_lock);
+    target->sent++;
+    if (rtt_us >= 0)
+    {
+        uint32_t rtt = (uint32_t)rtt_us;
+        if (target->received > 0)
+        {
+            target->jitter_sum_us += rtt > target->last_rtt_us ? rtt - target->last_rtt_us
+                                                               : target->last_rtt_us - rtt;
+            target->jitter_count++;
+        }
+        target->received++;
+        target->rtt_sum_us += rtt;
+        target->rtt_min_us = target->received == 1 || rtt < target->rtt_min_us ? rtt : target->rtt_min_us;
+        target->rtt_max_us = rtt > target->rtt_max_us ? rtt : target->rtt_max_us;
+        target->last_rtt_us = rtt;
+    }
+    taskEXIT_CRITICAL(&stats_lock);
+}
+
+// Open the raw ICMP socket shared by all probes
+static int open_socket(void)
+{
+    int sock = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
+    if (sock < 0)
+    {
+        ESP_LOGE(TAG, "Failed to create socket: errno %d", errno);
+        return -1;
+    }
+
+    struct timeval timeout = {.tv_sec = 0, .tv_usec = PROBE_POLL_MS * 1000};
+    if (setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0)
+    {
+        ESP_LOGE(TAG, "Failed to set socket timeout");
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+bool icmp_probe_is_reply(const uint8_t *datagram, int len, uint16_t seq)
+{
+    int header_len = (datagram[0] & 0x0F) * 4;
+    if (len < header_len + (int)sizeof(struct icmp_echo_hdr))
+    {
+        return false;
+    }
+
+    const struct icmp_echo_hdr *reply = (const struct icmp_echo_hdr *)(datagram + header_len);
+    return ICMPH_TYPE(reply) == ICMP_ER && reply->id == PROBE_ID && reply->seqno == htons(seq);
+}
+
+size_t icmp_probe_build_request(uint8_t *packet, uint16_t seq)
+{
+    struct icmp_echo_hdr *request = (struct icmp_echo_hdr *)packet;
+    ICMPH_TYPE_SET(request, ICMP_ECHO);
+    ICMPH_CODE_SET(request, 0);
+    request->chksum = 0;
+    request->id = PROBE_ID;
+    request->seqno = htons(seq);
+    for (int i = 0; i < PROBE_DATA_SIZE; i++)
+    {
+        packet[sizeof(struct icmp_echo_hdr) + i] = (uint8_t)i;
+    }
+    request->chksum = inet_chksum(packet, ICMP_PROBE_PACKET_SIZE);
+    return ICMP_PROBE_PACKET_SIZE;
+}
+
+// Send one echo request to a target and wait for its reply
+static void probe_one(probe_target_t *target)
+{
+    if (probe_sock < 0)
+    {
+        probe_sock = open_socket();
+        if (probe_sock < 0)
+        {
+            record_probe(target, -1);
+            return;
+        }
+    }
+
+    // Discard replies that arrived after an earlier probe timed out
+    while (recv(probe_sock, reply_buffer, sizeof(reply_buffer), MSG_DONTWAIT) > 0)
+    {
+    }
+
+    uint16_t seq = ++probe_seq;
+    icmp_probe_build_request(probe_packet, seq);
+
+    struct sockaddr_in to = {.sin_family = AF_INET, .sin_addr.s_addr = target->address};
+    int64_t sent_us = esp_timer_get_time();
+    if (sendto(probe_sock, probe_packet, sizeof(probe_packet), 0, (struct sockaddr *)&to, sizeof(to)) < 0)
+    {
+        // No route while the link is down: a lost probe; reopen next time
+        record_probe(target, -1);
+        close(probe_sock);
+        probe_sock = -1;
+        return;
+    }
+
+    int64_t deadline_us = sent_us + CONFIG_ICMP_PROBE_TIMEOUT_MS * 1000LL;
+    while (esp_timer_get_time() < deadline_us)
+    {
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        int len = recvfrom(probe_sock, reply_buffer, sizeof(reply_buffer), 0,
+                           (struct sockaddr *)&from, &from_len);
+        if (len > 0 && from.sin_addr.s_addr == target->address &&
+            icmp_probe_is_reply(reply_buffer, len, seq))
+        {
+            int64_t rtt_us = esp_timer_get_time() - sent_us;
+            record_probe(target, rtt_us > INT32_MAX ? INT32_MAX : (int32_t)rtt_us);
+            return;
+        }
+    }
+    record_probe(target, -1);
+}
+
+// Probe every target once per interval
+static void probe_task(void *arg)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (1)
+    {
+        for (int i = 0; i < target_count; i++)
+        {
+            probe_one(&targets[i]);
+        }
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(probe_interval_ms));
+    }
+}
+
+int icmp_probe_parse_targets(const char *list, uint32_t *addresses, int max)
+{
+    int count = 0;
+
+    while (*list != '\0' && count < max)
+    {
+        // Skip separators, then copy one address
+        while (*list == ',' || isspace((unsigned char)*list))
+        {
+            list++;
+        }
+        char address[16];
+        size_t len = strcspn(list, ", \t");
+        if (len == 0)
+        {
+            break;
+        }
+        if (len < sizeof(address))
+        {
+            memcpy(address, list, len);
+            address[len] = '\0';
+            if (inet_pton(AF_INET, address, &addresses[count]) == 1)
+            {
+                count++;
+            }
+            else
+            {
+                ESP_LOGW(TAG, "Ignoring probe target \"%s\"", address);
+            }
+        }
+        list += len;
+    }
+
+    // Targets beyond max are not probed; say so rather than drop them quietly
+    list += strspn(list, ", \t");
+    if (*list != '\0')
+    {
+        ESP_LOGW(TAG, "Only the first %d probe targets are used, ignoring \"%s\"", max, list);
+    }
+    return count;
+}
+
+esp_err_t icmp_probe_start(const uint32_t *addresses, int count, uint32_t interval_ms)
+{
+    if (count < 1 || count > ICMP_PROBE_MAX_TARGETS || interval_ms == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // A lost reply holds the task for a full timeout per target
+    uint32_t worst_ms = (uint32_t)count * CONFIG_ICMP_PROBE_TIMEOUT_MS;
+    if (interval_ms <= worst_ms)
+    {
+        ESP_LOGW(TAG, "Interval %lu ms is not above %d target(s) x %d ms timeout, using %lu ms",
+                 (unsigned long)interval_ms, count, CONFIG_ICMP_PROBE_TIMEOUT_MS,
+                 (unsigned long)(worst_ms + CONFIG_ICMP_PROBE_TIMEOUT_MS));
+        interval_ms = worst_ms + CONFIG_ICMP_PROBE_TIMEOUT_MS;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        targets[i].address = addresses[i];
+    }
+    target_count = count;
+    probe_interval_ms = interval_ms;
+    window_start_us = esp_timer_get_time();
+
+    if (RTOS_TASK_CREATE_PINNED(probe_task, "icmp_probe", CONFIG_ICMP_PROBE_TASK_STACK, NULL,
+                                CONFIG_ICMP_PROBE_TASK_PRIORITY, NULL, tskNO_AFFINITY) != pdPASS)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Probing %d target(s) every %lu ms", count, (unsigned long)interval_ms);
+    return ESP_OK;
+}
+
+int icmp_probe_take_window(icmp_probe_stats_t *stats, int max, uint32_t *window_ms)
+{
+    int count = target_count < max ? target_count : max;
+    int64_t now_us = esp_timer_get_time();
+
+    taskENTER_CRITICAL(&stats_lock);
+    for (int i = 0; i < count; i++)
+    {
+        probe_target_t *target = &targets[i];
+        icmp_probe_stats_t *out = &stats[i];
+
+        out->address = target->address;
+        out->sent = target->sent;
+        out->received = target->received;
+        out->rtt_min_us = target->rtt_min_us;
+        out->rtt_avg_us = target->received ? (uint32_t)(target->rtt_sum_us / target->received) : 0;
+        out->rtt_max_us = target->rtt_max_us;
+        out->jitter_us = target->jitter_count ? (uint32_t)(target->jitter_sum_us / target->jitter_count) : 0;
+
+        // Start the next window; the address stays
+        uint32_t address = target->address;
+        memset(target, 0, sizeof(*target));
+        target->address = address;
+    }
+    *window_ms = (uint32_t)((now_us - window_start_us) / 1000);
+    window_start_us = now_us;
+    taskEXIT_CRITICAL(&stats_lock);
+
+    return count;
+}
@@ -0,0 +1,64 @@
+// ICMP link-quality probe engine
+//
+// A low-priority task sends one ICMP echo request to every target per
+// interval over a single raw socket, matches replies by identifier and
+// sequence number, and accumulates per-target statistics. A consumer takes
+// the statistics once per window (for example from a publishing timer), so
+// probes are aggregated instead of reported one by one:
+//
+//   sent, received        loss = sent - received
+//   rtt min/avg/max       over the replies of the window (microseconds)
+//   jitter                mean absolute difference of consecutive RTTs
+//
+// Taking a window resets the accumulators; probing never stops, so a window
+// taken after a long pause simply covers a longer time (window_ms).
+
+#pragma once
+
+// Include standard integer, size and bool types
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Include ESP32 error codes
+#include "esp_err.h"
+
+// Include sdkconfig for the target limit
+#include "sdkconfig.h"
+
+// Most targets probed at once
+#define ICMP_PROBE_MAX_TARGETS CONFIG_ICMP_PROBE_MAX_TARGETS
+
+// Echo request size: 8-byte ICMP header and 32 bytes of payload
+#define ICMP_PROBE_PACKET_SIZE 40
+
+// Statistics of one target over one window
+typedef struct
+{
+    uint32_t address;     // IPv4 address, network byte order
+    uint16_t sent;        // Echo requests sent
+    uint16_t received;    // Matching replies received in time
+    uint32_t rtt_min_us;  // 0 when nothing was received
+    uint32_t rtt_avg_us;
+    uint32_t rtt_max_us;
+    uint32_t jitter_us;   // 0 with fewer than two replies
+} icmp_probe_stats_t;
+
+// Parse up to max IPv4 addresses separated by spaces or commas; returns the count
+int icmp_probe_parse_targets(const char *list, uint32_t *addresses, int max);
+
+// Build the echo request with sequence number seq into packet
+// (ICMP_PROBE_PACKET_SIZE bytes, checksum filled in); returns its length
+size_t icmp_probe_build_request(uint8_t *packet, uint16_t seq);
+
+// Check that a received datagram (IPv4 header + ICMP, as a raw socket
+// returns it) is the echo reply to the request with sequence number seq
+bool icmp_probe_is_reply(const uint8_t *datagram, int len, uint16_t seq);
+
+// Start probing count targets (network byte order), each once per interval_ms
+// An interval not above count x CONFIG_ICMP_PROBE_TIMEOUT_MS is lengthened.
+esp_err_t icmp_probe_start(const uint32_t *addresses, int count, uint32_t interval_ms);
+
+// Copy and reset the statistics of every target; returns the number of
+// targets and the window length in ms (time since the previous take)
+int icmp_probe_take_window(icmp_probe_stats_t *stats, int max, uint32_t *window_ms);
@@ -0,0 +1,72 @@
+// Cycle-accurate performance counters
+//
+// A counter accumulates the cost of one code section in CPU cycles
+// (esp_cpu_get_cycle_count(); nanoseconds on the Linux target, which has no
+// cycle counter). Counters are static, register themselves on first use and
+// are reported together as one JSON object, e.g.
+//
+//   {"target":"esp32","unit":"cycles","cpu_mhz":160,"counters":[
+//    {"name":"parse_command","n":12,"min":410,"avg":520,"max":1380}]}
+//
+// so a script can compare runs and flag regressions. Measuring costs two
+// cycle count reads and a short critical section; with
+// CONFIG_PERF_COUNTER_ENABLE off the macros compile to nothing.
+//
+// Usage:
+//   static perf_counter_t parse_perf = PERF_COUNTER_INIT("parse_command");
+//   uint32_t start = PERF_COUNTER_START();
+//   parse_command(line, &cmd);
+//   PERF_COUNTER_STOP(&parse_perf, start);
+
+#pragma once
+
+// Include standard integer and size types
+#include <stddef.h>
+#include <stdint.h>
+
+// Include sdkconfig for CONFIG_PERF_COUNTER_ENABLE
+#include "sdkconfig.h"
+
+// One measured code section
+typedef struct perf_counter
+{
+    const char *name;          // Name in the JSON output
+    uint32_t count;            // Measurements
+    uint64_t total;            // Sum of all measurements (cycles)
+    uint32_t min;              // Smallest measurement
+    uint32_t max;              // Largest measurement
+    struct perf_counter *next; // Registered counters, linked on first use
+    uint8_t registered;
+} perf_counter_t;
+
+#define PERF_COUNTER_INIT(counter_name) {.name = (counter_name), .min = UINT32_MAX}
+
+// Current cycle count
+uint32_t perf_counter_now(void);
+
+// Unit of perf_counter_now() ("cycles", or "ns" on the Linux target)
+const char *perf_counter_unit(void);
+
+// perf_counter_now() ticks per second (CPU clock, or 10^9 on the Linux target)
+uint32_t perf_counter_ticks_per_second(void);
+
+// Add the cycles elapsed since start to a counter
+void perf_counter_add(perf_counter_t *counter, uint32_t start);
+
+// Write all registered counters as JSON into buffer; returns the length
+size_t perf_counter_format_json(char *buffer, size_t size);
+
+// Print the JSON report on one line, prefixed with "PERF " for grepping
+// Uses a static buffer: call from one task only.
+void perf_counter_print_json(void);
+
+// Reset all registered counters
+void perf_counter_reset(void);
+
+#if CONFIG_PERF_COUNTER_ENABLE
+#define PERF_COUNTER_START() perf_counter_now()
+#define PERF_COUNTER_STOP(counter, start) perf_counter_add((counter), (start))
+#else
+#define PERF_COUNTER_START() 0
+#define PERF_COUNTER_STOP(counter, start) ((void)(counter), (void)(start))
+#endif
@@ -0,0 +1,141 @@
+// Include the performance counter interface
+#include "perf_counter.h"
+
+// Include standard input/output library for snprintf()
+#include <stdio.h>
+
+// Include ESP32 FreeRTOS headers for critical sections
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+// The Linux target has no cycle counter: use a monotonic nanosecond clock
+#include <time.h>
+#else
+// Include the CPU cycle counter
+#include "esp_cpu.h"
+#endif
+
+// Registered counters and the lock protecting them and their values
+static perf_counter_t *counters;
+static portMUX_TYPE perf_lock = portMUX_INITIALIZER_UNLOCKED;
+
+uint32_t perf_counter_now(void)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000000ull + ts.tv_nsec);
+#else
+    return (uint32_t)esp_cpu_get_cycle_count();
+#endif
+}
+
+const char *perf_counter_unit(void)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    return "ns";
+#else
+    return "cycles";
+#endif
+}
+
+uint32_t perf_counter_ticks_per_second(void)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    return 1000000000u;
+#else
+    return CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1000000u;
+#endif
+}
+
+void perf_counter_add(perf_counter_t *counter, uint32_t start)
+{
+    uint32_t cycles = perf_counter_now() - start; // Unsigned subtraction handles wrap-around
+
+    taskENTER_CRITICAL(&perf_lock);
+    if (!counter->registered)
+    {
+        counter->registered = 1;
+        counter->next = counters;
+        counters = counter;
+    }
+    counter->count++;
+    counter->total += cycles;
+    if (cycles < counter->min)
+    {
+        counter->min = cycles;
+    }
+    if (cycles > counter->max)
+    {
+        counter->max = cycles;
+    }
+    taskEXIT_CRITICAL(&perf_lock);
+}
+
+size_t perf_counter_format_json(char *buffer, size_t size)
+{
+    size_t len;
+    int written;
+
+#if CONFIG_IDF_TARGET_LINUX
+    written = snprintf(buffer, size, "{\"target\":\"linux\",\"unit\":\"%s\",\"counters\":[", perf_counter_unit());
+#else
+    written = snprintf(buffer, size, "{\"target\":\"%s\",\"unit\":\"%s\",\"cpu_mhz\":%d,\"counters\":[",
+                       CONFIG_IDF_TARGET, perf_counter_unit(), CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+#endif
+    len = written < 0 ? 0 : (size_t)written;
+
+    // Counters are only ever prepended, so the list from this head stays valid
+    taskENTER_CRITICAL(&perf_lock);
+    perf_counter_t *first = counters;
+    taskEXIT_CRITICAL(&perf_lock);
+
+    // Snapshot one counter at a time; formatting happens outside the lock
+    for (perf_counter_t *counter = first; counter != NULL && len < size; counter = counter->next)
+    {
+        taskENTER_CRITICAL(&perf_lock);
+        perf_counter_t snapshot = *counter;
+        taskEXIT_CRITICAL(&perf_lock);
+
+        written = snprintf(buffer + len, size - len, "%s{\"name\":\"%s\",\"n\":%lu,\"min\":%lu,\"avg\":%lu,\"max\":%lu}",
+                           counter == first ? "" : ",", snapshot.name,
+                           (unsigned long)snapshot.count,
+                           (unsigned long)(snapshot.count ? snapshot.min : 0),
+                           (unsigned long)(snapshot.count ? snapshot.total / snapshot.count : 0),
+                           (unsigned long)snapshot.max);
+        if (written < 0)
+        {
+            break;
+        }
+        len += written;
+    }
+
+    if (len < size)
+    {
+        written = snprintf(buffer + len, size - len, "]}");
+        len += written < 0 ? 0 : written;
+    }
+    return len < size ? len : size - 1;
+}
+
+void perf_counter_print_json(void)
+{
+    static char text[1024]; // Static: callers may have small stacks (not reentrant)
+
+    perf_counter_format_json(text, sizeof(text));
+    printf("PERF %s\n", text);
+}
+
+void perf_counter_reset(void)
+{
+    taskENTER_CRITICAL(&perf_lock);
+    for (perf_counter_t *counter = counters; counter != NULL; counter = counter->next)
+    {
+        counter->count = 0;
+        counter->total = 0;
+        counter->min = UINT32_MAX;
+        counter->max = 0;
+    }
+    taskEXIT_CRITICAL(&perf_lock);
+}
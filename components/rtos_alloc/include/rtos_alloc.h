@@ -0,0 +1,72 @@
+// FreeRTOS object creation with a static-allocation profile
+//
+// The RTOS_* macros create tasks, queues, mutexes and event groups. With
+// CONFIG_RTOS_ALLOC_STATIC they use the *Static variants: the stack, TCB,
+// queue storage and control blocks are static variables owned by the call
+// site, so they show up in the static RAM footprint instead of the heap and
+// cannot fail at run time. A call site therefore creates at most one object:
+// use the macros in init code that runs once. Stack and queue sizes must be
+// compile-time constants.
+//
+// Without CONFIG_RTOS_ALLOC_STATIC the macros are the usual dynamic calls.
+
+#pragma once
+
+// Include ESP32 FreeRTOS headers for the objects created here
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+
+// Include sdkconfig for CONFIG_RTOS_ALLOC_STATIC
+#include "sdkconfig.h"
+
+#if CONFIG_RTOS_ALLOC_STATIC
+
+// Create a task pinned to a core (or tskNO_AFFINITY); returns pdPASS or pdFAIL
+#define RTOS_TASK_CREATE_PINNED(fn, name, stack_bytes, arg, priority, handle, core)      \
+    ({                                                                                  \
+        static StackType_t _rtos_stack[(stack_bytes) / sizeof(StackType_t)];             \
+        static StaticTask_t _rtos_tcb;                                                  \
+        TaskHandle_t _rtos_task = xTaskCreateStaticPinnedToCore(                        \
+            (fn), (name), (stack_bytes), (arg), (priority), _rtos_stack, &_rtos_tcb, (core)); \
+        TaskHandle_t *_rtos_handle = (handle);                                          \
+        if (_rtos_handle != NULL)                                                       \
+        {                                                                               \
+            *_rtos_handle = _rtos_task;                                                 \
+        }                                                                               \
+        _rtos_task != NULL ? pdPASS : pdFAIL;                                           \
+    })
+
+// Create a queue of length items of item_size bytes
+#define RTOS_QUEUE_CREATE(length, item_size)                                \
+    ({                                                                      \
+        static uint8_t _rtos_storage[(length) * (item_size)];               \
+        static StaticQueue_t _rtos_queue;                                   \
+        xQueueCreateStatic((length), (item_size), _rtos_storage, &_rtos_queue); \
+    })
+
+// Create a mutex
+#define RTOS_MUTEX_CREATE()                              \
+    ({                                                   \
+        static StaticSemaphore_t _rtos_mutex;            \
+        xSemaphoreCreateMutexStatic(&_rtos_mutex);       \
+    })
+
+// Create an event group
+#define RTOS_EVENT_GROUP_CREATE()                        \
+    ({                                                   \
+        static StaticEventGroup_t _rtos_events;          \
+        xEventGroupCreateStatic(&_rtos_events);          \
+    })
+
+#else
+
+#define RTOS_TASK_CREATE_PINNED(fn, name, stack_bytes, arg, priority, handle, core) \
+    xTaskCreatePinnedToCore((fn), (name), (stack_bytes), (arg), (priority), (handle), (core))
+#define RTOS_QUEUE_CREATE(length, item_size) xQueueCreate((length), (item_size))
+#define RTOS_MUTEX_CREATE() xSemaphoreCreateMutex()
+#define RTOS_EVENT_GROUP_CREATE() xEventGroupCreate()
+
+#endif
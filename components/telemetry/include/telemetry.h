@@ -0,0 +1,58 @@
+// Runtime resource telemetry
+//
+// A periodic esp_timer samples, per FreeRTOS task, the CPU load since the
+// previous sample and the stack high-water mark, plus the free, minimum
+// ever free and largest free block of the 8-bit heap. A sample costs one
+// uxTaskGetSystemState() call; readers get a copy of the last sample, so
+// asking for it never walks the task list.
+//
+// Per-task CPU load needs CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS (set in
+// the projects' sdkconfig.defaults); without it the load reads as 0.
+
+#pragma once
+
+// Include standard integer, boolean and size types
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Include ESP32 error codes
+#include "esp_err.h"
+
+// Include sdkconfig for the task limit
+#include "sdkconfig.h"
+
+// Tasks listed per sample (with more tasks, only the totals are reported)
+#define TELEMETRY_MAX_TASKS CONFIG_TELEMETRY_MAX_TASKS
+
+// One task in a sample
+typedef struct
+{
+    char name[16];       // Task name (truncated)
+    uint16_t cpu_permil; // CPU load over the last period, per mille of one core
+    uint32_t stack_free; // Smallest free stack seen (bytes)
+    int8_t core;         // Core affinity, -1 = any
+} telemetry_task_t;
+
+// One sample
+typedef struct
+{
+    uint32_t time_ms;        // Sample time (ms since boot)
+    uint32_t heap_free;      // Free heap (bytes)
+    uint32_t heap_min_free;  // Lowest free heap since boot (bytes)
+    uint32_t heap_largest;   // Largest free block (bytes); far below heap_free = fragmented
+    uint16_t task_total;     // Tasks that exist
+    uint16_t task_count;     // Tasks listed in tasks[]
+    telemetry_task_t tasks[TELEMETRY_MAX_TASKS];
+} telemetry_sample_t;
+
+// Take a first sample and start sampling every CONFIG_TELEMETRY_PERIOD_MS
+esp_err_t telemetry_start(void);
+
+// Copy the last sample; returns false before the first one
+bool telemetry_get(telemetry_sample_t *sample);
+
+// Write the last sample as compact text
+//   "heap free=.. min=.. largest=..; tasks=N; <name> cpu=12.5% stack=1234 core=1; ..."
+// Returns the length. Uses a static copy of the sample: call from one task only.
+size_t telemetry_format(char *buffer, size_t size);
@@ -0,0 +1,173 @@
+// Include the telemetry interface
+#include "telemetry.h"
+
+// Include standard input/output library for snprintf()
+#include <stdio.h>
+#include <string.h>
+
+// Include ESP32 FreeRTOS headers
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Include ESP32 high resolution timer, heap and logging
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+// Log tag
+static const char *TAG = "TELEMETRY";
+
+// Last sample handed to readers (sample_lock)
+static telemetry_sample_t sample;
+static bool sample_valid;
+static portMUX_TYPE sample_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Sampling work area (timer task only)
+static telemetry_sample_t next;
+#if configUSE_TRACE_FACILITY
+static TaskStatus_t task_status[TELEMETRY_MAX_TASKS];
+typedef struct
+{
+    TaskHandle_t handle;
+    uint32_t run_time; // Run-time counter at the sample
+} run_time_entry_t;
+// Counters at the previous sample, and at the one being taken: the task
+// order changes between samples, so previous[] stays intact until all
+// tasks have been looked up in it
+static run_time_entry_t previous[TELEMETRY_MAX_TASKS];
+static run_time_entry_t current[TELEMETRY_MAX_TASKS];
+static uint32_t previous_count;
+static uint32_t previous_total; // Total run time at the previous sample
+#endif
+static esp_timer_handle_t sample_timer;
+
+// Run-time counter of a task at the previous sample (0 if it is new)
+#if configUSE_TRACE_FACILITY
+static uint32_t previous_run_time(TaskHandle_t handle)
+{
+    for (uint32_t i = 0; i < previous_count; i++)
+    {
+        if (previous[i].handle == handle)
+        {
+            return previous[i].run_time;
+        }
+    }
+    return 0;
+}
+#endif
+
+static void take_sample(void *arg)
+{
+    next.time_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    next.heap_free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    next.heap_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    next.heap_largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    next.task_total = uxTaskGetNumberOfTasks();
+    next.task_count = 0;
+
+#if configUSE_TRACE_FACILITY
+    // Returns 0 when there are more tasks than slots: then only totals are reported
+    uint32_t total = 0;
+    UBaseType_t count = uxTaskGetSystemState(task_status, TELEMETRY_MAX_TASKS, &total);
+    uint32_t elapsed = total - previous_total;
+
+    for (UBaseType_t i = 0; i < count; i++)
+    {
+        const TaskStatus_t *status = &task_status[i];
+        telemetry_task_t *task = &next.tasks[i];
+        uint32_t run = (uint32_t)status->ulRunTimeCounter - previous_run_time(status->xHandle);
+
+        strncpy(task->name, status->pcTaskName, sizeof(task->name) - 1);
+        task->name[sizeof(task->name) - 1] = '\0';
+        task->cpu_permil = elapsed ? (uint16_t)((uint64_t)run * 1000 / elapsed) : 0;
+        task->stack_free = status->usStackHighWaterMark;
+#if configTASKLIST_INCLUDE_COREID
+        task->core = status->xCoreID == tskNO_AFFINITY ? -1 : (int8_t)status->xCoreID;
+#else
+        task->core = -1;
+#endif
+
+        current[i].handle = status->xHandle;
+        current[i].run_time = (uint32_t)status->ulRunTimeCounter;
+    }
+    next.task_count = count;
+    memcpy(previous, current, count * sizeof(current[0]));
+    previous_count = count;
+    previous_total = total;
+#endif
+
+    taskENTER_CRITICAL(&sample_lock);
+    sample = next;
+    sample_valid = true;
+    taskEXIT_CRITICAL(&sample_lock);
+}
+
+esp_err_t telemetry_start(void)
+{
+    const esp_timer_create_args_t timer_args = {
+        .callback = take_sample,
+        .name = "telemetry",
+    };
+
+    esp_err_t err = esp_timer_create(&timer_args, &sample_timer);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    take_sample(NULL); // Baseline, so the first periodic sample has a load
+    err = esp_timer_start_periodic(sample_timer, (uint64_t)CONFIG_TELEMETRY_PERIOD_MS * 1000);
+    if (err == ESP_OK)
+    {
+        ESP_LOGI(TAG, "Sampling every %d ms", CONFIG_TELEMETRY_PERIOD_MS);
+    }
+    return err;
+}
+
+bool telemetry_get(telemetry_sample_t *out)
+{
+    taskENTER_CRITICAL(&sample_lock);
+    bool valid = sample_valid;
+    if (valid)
+    {
+        *out = sample;
+    }
+    taskEXIT_CRITICAL(&sample_lock);
+    return valid;
+}
+
+size_t telemetry_format(char *buffer, size_t size)
+{
+    static telemetry_sample_t copy; // Too large for small task stacks
+    size_t len = 0;
+    int written;
+
+    if (size == 0)
+    {
+        return 0;
+    }
+    buffer[0] = '\0';
+    if (!telemetry_get(&copy))
+    {
+        return 0;
+    }
+
+    written = snprintf(buffer, size, "heap free=%lu min=%lu largest=%lu; tasks=%u",
+                       (unsigned long)copy.heap_free, (unsigned long)copy.heap_min_free,
+                       (unsigned long)copy.heap_largest, copy.task_total);
+    len = written < 0 ? 0 : (size_t)written;
+
+    for (int i = 0; i < copy.task_count && len < size; i++)
+    {
+        const telemetry_task_t *task = &copy.tasks[i];
+        written = snprintf(buffer + len, size - len, "; %s cpu=%u.%u%% stack=%lu core=%d",
+                           task->name, task->cpu_permil / 10, task->cpu_permil % 10,
+                           (unsigned long)task->stack_free, task->core);
+        if (written < 0)
+        {
+            break;
+        }
+        len += written;
+    }
+    return len < size ? len : size - 1;
+}
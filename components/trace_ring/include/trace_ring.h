@@ -0,0 +1,98 @@
+// Binary event trace
+//
+// Hot paths record 12-byte events (cycle count, event ID, 32-bit argument)
+// into a per-core ring in RAM instead of logging text. Recording takes a
+// slot with one atomic add and writes three words, so it costs well under a
+// microsecond and never blocks; when a ring is full the oldest events are
+// overwritten. trace_dump() writes the rings as text lines that
+// tools/trace2perfetto.py turns into a Chrome/Perfetto trace:
+//
+//   TRACE BEGIN <cpu_mhz> <cores> <events_per_core>
+//   TRACE NAME <id> <name>
+//   TRACE SYNC <core> <cycles> <us>        cycle count and esp_timer read together
+//   TRACE EV <core> <hex events...>        up to 16 events per line
+//   TRACE END
+//
+// Cycle counters are per core and wrap every 2^32 cycles (18 s at
+// 240 MHz). The host tool anchors each core's newest event to esp_timer
+// time with the SYNC pair and walks back through the ring, so only a gap of
+// more than one wrap between two consecutive events of a core misplaces the
+// older ones.
+//
+// With CONFIG_TRACE_RING_ENABLE off the TRACE_* macros compile to nothing.
+
+#pragma once
+
+// Include standard integer and size types
+#include <stddef.h>
+#include <stdint.h>
+
+// Include ESP32 error codes and the CPU cycle counter
+#include "esp_err.h"
+#include "esp_cpu.h"
+
+// Include sdkconfig for CONFIG_TRACE_RING_*
+#include "sdkconfig.h"
+
+// Event kind, stored in the top bits of the ID
+#define TRACE_KIND_INSTANT 0x0000
+#define TRACE_KIND_BEGIN 0x4000
+#define TRACE_KIND_END 0x8000
+#define TRACE_ID_MASK 0x3FFF
+
+// One recorded event
+typedef struct
+{
+    uint32_t cycles; // esp_cpu_get_cycle_count() of the recording core
+    uint16_t id;     // Event ID | TRACE_KIND_*
+    uint16_t unused;
+    uint32_t arg;    // Event argument (sequence number, command ID, ...)
+} trace_event_t;
+
+// Output callback for trace_dump()
+typedef void (*trace_write_t)(void *ctx, const char *data, size_t len);
+
+#if CONFIG_TRACE_RING_ENABLE
+
+#define TRACE_RING_EVENTS CONFIG_TRACE_RING_EVENTS
+
+// Rings and write counters (defined in trace_ring.c, used by the inline recorder)
+extern trace_event_t trace_rings[][TRACE_RING_EVENTS];
+extern uint32_t trace_heads[];
+extern volatile uint32_t trace_enabled;
+
+// Record an event on the current core
+static inline void trace_record(uint16_t id, uint32_t arg)
+{
+    if (!trace_enabled)
+    {
+        return;
+    }
+    int core = esp_cpu_get_core_id();
+    uint32_t index = __atomic_fetch_add(&trace_heads[core], 1, __ATOMIC_RELAXED);
+    trace_event_t *event = &trace_rings[core][index & (TRACE_RING_EVENTS - 1)];
+    event->cycles = esp_cpu_get_cycle_count();
+    event->id = id;
+    event->arg = arg;
+}
+
+#define TRACE_INSTANT(id, arg) trace_record((id) | TRACE_KIND_INSTANT, (arg))
+#define TRACE_BEGIN(id, arg) trace_record((id) | TRACE_KIND_BEGIN, (arg))
+#define TRACE_END(id, arg) trace_record((id) | TRACE_KIND_END, (arg))
+
+#else
+
+#define TRACE_INSTANT(id, arg) ((void)(arg))
+#define TRACE_BEGIN(id, arg) ((void)(arg))
+#define TRACE_END(id, arg) ((void)(arg))
+
+#endif
+
+// Give an event ID a name for the host tool (IDs 1 .. CONFIG_TRACE_RING_MAX_NAMES - 1)
+void trace_name(uint16_t id, const char *name);
+
+// Write all rings as text lines; recording pauses while dumping
+void trace_dump(trace_write_t write, void *ctx);
+
+// Send the dump to a UDP listener, one line per datagram
+esp_err_t trace_dump_udp(const char *ip, uint16_t port);
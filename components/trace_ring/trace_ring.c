@@ -0,0 +1,181 @@
+// Include the trace interface
+#include "trace_ring.h"
+
+// Include standard input/output library for snprintf()
+#include <stdio.h>
+#include <errno.h>
+
+// Include ESP32 FreeRTOS headers
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Include ESP32 logging, timer and inter-core call headers
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_ipc.h"
+
+// Include lwIP sockets for the UDP dump
+#include "lwip/sockets.h"
+
+// Log tag
+static const char *TAG = "TRACE";
+
+// Events per "TRACE EV" line
+#define EVENTS_PER_LINE 16
+
+// Event names, indexed by ID (without the kind bits)
+static const char *names[CONFIG_TRACE_RING_MAX_NAMES];
+
+#if CONFIG_TRACE_RING_ENABLE
+
+_Static_assert((TRACE_RING_EVENTS & (TRACE_RING_EVENTS - 1)) == 0,
+               "CONFIG_TRACE_RING_EVENTS must be a power of two");
+
+// One ring per core, written only through trace_record()
+trace_event_t trace_rings[portNUM_PROCESSORS][TRACE_RING_EVENTS];
+uint32_t trace_heads[portNUM_PROCESSORS];
+volatile uint32_t trace_enabled = 1;
+
+// Cycle count and esp_timer time read together on one core
+typedef struct
+{
+    uint32_t cycles;
+    int64_t us;
+} sync_point_t;
+
+static void read_sync_point(void *arg)
+{
+    sync_point_t *point = arg;
+    point->cycles = esp_cpu_get_cycle_count();
+    point->us = esp_timer_get_time();
+}
+
+#endif
+
+void trace_name(uint16_t id, const char *name)
+{
+    id &= TRACE_ID_MASK;
+    if (id < CONFIG_TRACE_RING_MAX_NAMES)
+    {
+        names[id] = name;
+    }
+    else
+    {
+        ESP_LOGW(TAG, "Event ID %u above CONFIG_TRACE_RING_MAX_NAMES", id);
+    }
+}
+
+void trace_dump(trace_write_t write, void *ctx)
+{
+#if CONFIG_TRACE_RING_ENABLE
+    char line[32 + EVENTS_PER_LINE * sizeof(trace_event_t) * 2];
+    int len;
+
+    // Stop recording so the rings hold still while they are read
+    trace_enabled = 0;
+
+    len = snprintf(line, sizeof(line), "TRACE BEGIN %d %d %d\n",
+                   CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ, portNUM_PROCESSORS, TRACE_RING_EVENTS);
+    write(ctx, line, len);
+
+    for (int id = 0; id < CONFIG_TRACE_RING_MAX_NAMES; id++)
+    {
+        if (names[id] != NULL)
+        {
+            len = snprintf(line, sizeof(line), "TRACE NAME %d %.64s\n", id, names[id]);
+            write(ctx, line, len);
+        }
+    }
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++)
+    {
+        // Anchor this core's cycle counter to the shared esp_timer clock
+        sync_point_t sync;
+        if (core == esp_cpu_get_core_id())
+        {
+            read_sync_point(&sync);
+        }
+#if !CONFIG_FREERTOS_UNICORE
+        else if (esp_ipc_call_blocking(core, read_sync_point, &sync) != ESP_OK)
+        {
+            continue;
+        }
+#endif
+        len = snprintf(line, sizeof(line), "TRACE SYNC %d %lu %lld\n",
+                       core, (unsigned long)sync.cycles, (long long)sync.us);
+        write(ctx, line, len);
+
+        // Oldest to newest; a wrapped ring holds the last TRACE_RING_EVENTS events
+        uint32_t head = trace_heads[core];
+        uint32_t count = head < TRACE_RING_EVENTS ? head : TRACE_RING_EVENTS;
+        for (uint32_t i = head - count; i != head;)
+        {
+            len = snprintf(line, sizeof(line), "TRACE EV %d ", core);
+            for (int n = 0; n < EVENTS_PER_LINE && i != head; n++, i++)
+            {
+                const uint8_t *bytes = (const uint8_t *)&trace_rings[core][i & (TRACE_RING_EVENTS - 1)];
+                for (size_t b = 0; b < sizeof(trace_event_t); b++)
+                {
+                    len += snprintf(line + len, sizeof(line) - len, "%02x", bytes[b]);
+                }
+            }
+            line[len++] = '\n';
+            write(ctx, line, len);
+        }
+
+        // Dumped events are not sent again
+        trace_heads[core] = 0;
+    }
+
+    write(ctx, "TRACE END\n", 10);
+    trace_enabled = 1;
+#else
+    write(ctx, "TRACE BEGIN 0 0 0\nTRACE END\n", 28);
+#endif
+}
+
+// UDP destination for trace_dump_udp()
+typedef struct
+{
+    int sock;
+    struct sockaddr_in addr;
+    int failed;
+} udp_sink_t;
+
+static void udp_write(void *ctx, const char *data, size_t len)
+{
+    udp_sink_t *sink = ctx;
+    if (sendto(sink->sock, data, len, 0, (struct sockaddr *)&sink->addr, sizeof(sink->addr)) < 0)
+    {
+        sink->failed++;
+    }
+}
+
+esp_err_t trace_dump_udp(const char *ip, uint16_t port)
+{
+    udp_sink_t sink = {0};
+
+    sink.addr.sin_family = AF_INET;
+    sink.addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, ip, &sink.addr.sin_addr) != 1)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    sink.sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sink.sock < 0)
+    {
+        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
+        return ESP_FAIL;
+    }
+
+    trace_dump(udp_write, &sink);
+    close(sink.sock);
+
+    if (sink.failed > 0)
+    {
+        ESP_LOGW(TAG, "%d trace lines not sent to %s:%u", sink.failed, ip, port);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
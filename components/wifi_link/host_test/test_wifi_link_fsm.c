@@ -0,0 +1,219 @@
+// Scripted event sequences for the Wi-Fi link state machine
+//
+// Each scenario feeds wl_fsm_handle() the events wifi_link.c would see
+// (with timestamps) and checks the action, the delay of WL_ACT_WAIT and the
+// state after every step, then the counters.
+
+// Include standard input/output
+#include <stdio.h>
+
+// Include the state machine
+#include "wifi_link_fsm.h"
+
+// Backoff limits used by every scenario (the Kconfig defaults)
+#define BACKOFF_MIN_MS 250
+#define BACKOFF_MAX_MS 10000
+
+// One scripted step and what must come out of it
+typedef struct
+{
+    wl_event_t event;
+    uint32_t now_ms;
+    wl_action_type_t action;
+    uint32_t delay_ms; // Checked for WL_ACT_WAIT only
+    wl_state_t state;
+} step_t;
+
+static int failures;
+
+#define CHECK_EQ(what, got, expected)                                                         \
+    do                                                                                        \
+    {                                                                                         \
+        if ((long)(got) != (long)(expected))                                                  \
+        {                                                                                     \
+            printf("  %s: got %ld, expected %ld\n", (what), (long)(got), (long)(expected));    \
+            failures++;                                                                       \
+        }                                                                                     \
+    } while (0)
+
+// Run steps on fsm; reports the first step that differs
+static void run_steps(const char *name, wl_fsm_t *fsm, const step_t *steps, int count)
+{
+    int before = failures;
+
+    printf("%s\n", name);
+    for (int i = 0; i < count && failures == before; i++)
+    {
+        wl_action_t action = wl_fsm_handle(fsm, steps[i].event, steps[i].now_ms);
+        CHECK_EQ("action", action.type, steps[i].action);
+        if (steps[i].action == WL_ACT_WAIT)
+        {
+            CHECK_EQ("delay_ms", action.delay_ms, steps[i].delay_ms);
+        }
+        CHECK_EQ("state", fsm->state, steps[i].state);
+        if (failures != before)
+        {
+            printf("  at step %d\n", i + 1);
+        }
+    }
+}
+
+// First boot, no cached AP: full scans with doubling backoff until the AP appears
+static void test_cold_boot_backoff(void)
+{
+    static const step_t steps[] = {
+        {WL_EV_START, 0, WL_ACT_CONNECT_SCAN, 0, WL_CONNECTING_SCAN},
+        {WL_EV_DISCONNECTED, 3000, WL_ACT_WAIT, 250, WL_BACKOFF},
+        {WL_EV_TIMER, 3250, WL_ACT_CONNECT_SCAN, 0, WL_CONNECTING_SCAN},
+        {WL_EV_DISCONNECTED, 6250, WL_ACT_WAIT, 500, WL_BACKOFF},
+        {WL_EV_TIMER, 6750, WL_ACT_CONNECT_SCAN, 0, WL_CONNECTING_SCAN},
+        {WL_EV_DISCONNECTED, 9750, WL_ACT_WAIT, 1000, WL_BACKOFF},
+        {WL_EV_TIMER, 10750, WL_ACT_CONNECT_SCAN, 0, WL_CONNECTING_SCAN},
+        {WL_EV_ASSOCIATED, 12750, WL_ACT_NONE, 0, WL_ASSOCIATED},
+        {WL_EV_GOT_IP, 13150, WL_ACT_LINK_UP, 0, WL_UP},
+    };
+    wl_fsm_t fsm;
+
+    wl_fsm_init(&fsm, false, BACKOFF_MIN_MS, BACKOFF_MAX_MS);
+    run_steps("cold boot: scan, back off 250/500/1000 ms, connect", &fsm, steps, sizeof(steps) / sizeof(steps[0]));
+    CHECK_EQ("full_scans", fsm.stats.full_scans, 4);
+    CHECK_EQ("fast_connects", fsm.stats.fast_connects, 0);
+    CHECK_EQ("associations", fsm.stats.associations, 1);
+    CHECK_EQ("failures", fsm.stats.failures, 0);
+    CHECK_EQ("last_assoc_ms", fsm.stats.last_assoc_ms, 2000);
+    CHECK_EQ("last_dhcp_ms", fsm.stats.last_dhcp_ms, 400);
+    CHECK_EQ("has_cache", fsm.has_cache, 1);
+}
+
+// Backoff doubles up to the maximum and stays there; retrying never stops
+static void test_backoff_cap(void)
+{
+    static const uint32_t expected[] = {250, 500, 1000, 2000, 4000, 8000, 10000, 10000};
+    wl_fsm_t fsm;
+    uint32_t now = 0;
+    int before = failures;
+
+    printf("backoff: doubles to the maximum, retries forever\n");
+    wl_fsm_init(&fsm, false, BACKOFF_MIN_MS, BACKOFF_MAX_MS);
+    wl_fsm_handle(&fsm, WL_EV_START, now);
+    for (int i = 0; i < 1000 && failures == before; i++)
+    {
+        wl_action_t wait = wl_fsm_handle(&fsm, WL_EV_DISCONNECTED, now += 3000);
+        uint32_t delay = i < (int)(sizeof(expected) / sizeof(expected[0])) ? expected[i] : BACKOFF_MAX_MS;
+        CHECK_EQ("action", wait.type, WL_ACT_WAIT);
+        CHECK_EQ("delay_ms", wait.delay_ms, delay);
+
+        wl_action_t retry = wl_fsm_handle(&fsm, WL_EV_TIMER, now += wait.delay_ms);
+        CHECK_EQ("retry", retry.type, WL_ACT_CONNECT_SCAN);
+    }
+    CHECK_EQ("failures", fsm.stats.failures, 1000);
+}
+
+// Reboot with a cached AP: directed connect, no scan
+static void test_cached_boot(void)
+{
+    static const step_t steps[] = {
+        {WL_EV_START, 0, WL_ACT_CONNECT_FAST, 0, WL_CONNECTING_FAST},
+        {WL_EV_ASSOCIATED, 120, WL_ACT_NONE, 0, WL_ASSOCIATED},
+        {WL_EV_GOT_IP, 300, WL_ACT_LINK_UP, 0, WL_UP},
+    };
+    wl_fsm_t fsm;
+
+    wl_fsm_init(&fsm, true, BACKOFF_MIN_MS, BACKOFF_MAX_MS);
+    run_steps("cached boot: directed connect", &fsm, steps, sizeof(steps) / sizeof(steps[0]));
+    CHECK_EQ("full_scans", fsm.stats.full_scans, 0);
+    CHECK_EQ("fast_connects", fsm.stats.fast_connects, 1);
+    CHECK_EQ("last_assoc_ms", fsm.stats.last_assoc_ms, 120);
+    CHECK_EQ("last_dhcp_ms", fsm.stats.last_dhcp_ms, 180);
+}
+
+// Cached AP moved or gone: scan at once, back off, then try the cache first again
+static void test_stale_cache(void)
+{
+    static const step_t steps[] = {
+        {WL_EV_START, 0, WL_ACT_CONNECT_FAST, 0, WL_CONNECTING_FAST},
+        {WL_EV_DISCONNECTED, 500, WL_ACT_CONNECT_SCAN, 0, WL_CONNECTING_SCAN},
+        {WL_EV_DISCONNECTED, 3500, WL_ACT_WAIT, 250, WL_BACKOFF},
+        {WL_EV_TIMER, 3750, WL_ACT_CONNECT_FAST, 0, WL_CONNECTING_FAST},
+        {WL_EV_DISCONNECTED, 4250, WL_ACT_CONNECT_SCAN, 0, WL_CONNECTING_SCAN},
+        {WL_EV_ASSOCIATED, 6250, WL_ACT_NONE, 0, WL_ASSOCIATED},
+        {WL_EV_GOT_IP, 6500, WL_ACT_LINK_UP, 0, WL_UP},
+    };
+    wl_fsm_t fsm;
+
+    wl_fsm_init(&fsm, true, BACKOFF_MIN_MS, BACKOFF_MAX_MS);
+    run_steps("stale cache: directed, scan, back off, directed, scan", &fsm, steps,
+              sizeof(steps) / sizeof(steps[0]));
+    CHECK_EQ("full_scans", fsm.stats.full_scans, 2);
+    CHECK_EQ("fast_connects", fsm.stats.fast_connects, 0);
+    CHECK_EQ("last_assoc_ms", fsm.stats.last_assoc_ms, 6250 - 3750);
+}
+
+// Drop of an established link: reconnect to the same AP right away
+static void test_fast_reconnect(void)
+{
+    static const step_t steps[] = {
+        {WL_EV_START, 0, WL_ACT_CONNECT_SCAN, 0, WL_CONNECTING_SCAN},
+        {WL_EV_ASSOCIATED, 2000, WL_ACT_NONE, 0, WL_ASSOCIATED},
+        {WL_EV_GOT_IP, 2500, WL_ACT_LINK_UP, 0, WL_UP},
+        {WL_EV_DISCONNECTED, 60000, WL_ACT_CONNECT_FAST, 0, WL_CONNECTING_FAST},
+        {WL_EV_ASSOCIATED, 60080, WL_ACT_NONE, 0, WL_ASSOCIATED},
+        {WL_EV_GOT_IP, 60130, WL_ACT_LINK_UP, 0, WL_UP},
+        {WL_EV_DISCONNECTED, 90000, WL_ACT_CONNECT_FAST, 0, WL_CONNECTING_FAST},
+        {WL_EV_ASSOCIATED, 90090, WL_ACT_NONE, 0, WL_ASSOCIATED},
+        {WL_EV_DISCONNECTED, 91000, WL_ACT_WAIT, 250, WL_BACKOFF}, // No IP: counts as a failure
+        {WL_EV_TIMER, 91250, WL_ACT_CONNECT_FAST, 0, WL_CONNECTING_FAST},
+        {WL_EV_ASSOCIATED, 91300, WL_ACT_NONE, 0, WL_ASSOCIATED},
+        {WL_EV_GOT_IP, 91400, WL_ACT_LINK_UP, 0, WL_UP},
+    };
+    wl_fsm_t fsm;
+
+    wl_fsm_init(&fsm, false, BACKOFF_MIN_MS, BACKOFF_MAX_MS);
+    run_steps("drop: directed reconnect, DHCP failure backs off", &fsm, steps, sizeof(steps) / sizeof(steps[0]));
+    CHECK_EQ("disconnects", fsm.stats.disconnects, 2);
+    CHECK_EQ("fast_connects", fsm.stats.fast_connects, 3);
+    CHECK_EQ("full_scans", fsm.stats.full_scans, 1);
+    CHECK_EQ("associations", fsm.stats.associations, 4);
+    CHECK_EQ("failures", fsm.stats.failures, 0);
+    CHECK_EQ("last_assoc_ms", fsm.stats.last_assoc_ms, 50);
+    CHECK_EQ("last_dhcp_ms", fsm.stats.last_dhcp_ms, 100);
+}
+
+// Events that do not fit the state are ignored
+static void test_stray_events(void)
+{
+    static const step_t steps[] = {
+        {WL_EV_TIMER, 0, WL_ACT_NONE, 0, WL_IDLE},
+        {WL_EV_GOT_IP, 0, WL_ACT_NONE, 0, WL_IDLE},
+        {WL_EV_DISCONNECTED, 0, WL_ACT_NONE, 0, WL_IDLE},
+        {WL_EV_START, 10, WL_ACT_CONNECT_SCAN, 0, WL_CONNECTING_SCAN},
+        {WL_EV_START, 20, WL_ACT_NONE, 0, WL_CONNECTING_SCAN},
+        {WL_EV_TIMER, 30, WL_ACT_NONE, 0, WL_CONNECTING_SCAN},
+        {WL_EV_GOT_IP, 40, WL_ACT_NONE, 0, WL_CONNECTING_SCAN},
+        {WL_EV_ASSOCIATED, 2000, WL_ACT_NONE, 0, WL_ASSOCIATED},
+        {WL_EV_ASSOCIATED, 2100, WL_ACT_NONE, 0, WL_ASSOCIATED},
+        {WL_EV_GOT_IP, 2200, WL_ACT_LINK_UP, 0, WL_UP},
+        {WL_EV_GOT_IP, 2300, WL_ACT_NONE, 0, WL_UP},
+        {WL_EV_ASSOCIATED, 2400, WL_ACT_NONE, 0, WL_UP},
+        {WL_EV_TIMER, 2500, WL_ACT_NONE, 0, WL_UP},
+    };
+    wl_fsm_t fsm;
+
+    wl_fsm_init(&fsm, false, BACKOFF_MIN_MS, BACKOFF_MAX_MS);
+    run_steps("stray events are ignored", &fsm, steps, sizeof(steps) / sizeof(steps[0]));
+    CHECK_EQ("associations", fsm.stats.associations, 1);
+    CHECK_EQ("last_dhcp_ms", fsm.stats.last_dhcp_ms, 200);
+}
+
+int main(void)
+{
+    test_cold_boot_backoff();
+    test_backoff_cap();
+    test_cached_boot();
+    test_stale_cache();
+    test_fast_reconnect();
+    test_stray_events();
+
+    printf(failures ? "FAILED (%d)\n" : "OK\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,45 @@
+// Wi-Fi station link shared by the example projects
+//
+// Starts the station without blocking and keeps it connected for good:
+// the last AP (BSSID, channel) and IP lease are cached in NVS so a reboot
+// or drop reconnects with a directed connect instead of a full scan, and
+// failed attempts back off instead of giving up. Optionally the cached
+// lease or a configured static address is applied without waiting for DHCP
+// (see Kconfig "Wi-Fi link").
+//
+// NVS must be initialized before wifi_link_start().
+
+#pragma once
+
+// Include standard integer and boolean types
+#include <stdbool.h>
+#include <stdint.h>
+
+// Include ESP32 error codes
+#include "esp_err.h"
+
+// Include FreeRTOS tick type
+#include "freertos/FreeRTOS.h"
+
+// Link counters and timings
+typedef struct
+{
+    uint32_t associations;  // Successful associations since boot
+    uint32_t fast_connects; // Associations through the cached BSSID/channel
+    uint32_t full_scans;    // Connects that needed a full scan
+    uint32_t disconnects;   // Drops of an established link
+    uint32_t last_assoc_ms; // Attempt start -> associated, last connection
+    uint32_t last_dhcp_ms;  // Associated -> IP address, last connection
+} wifi_link_stats_t;
+
+// Initialize netif, event loop and Wi-Fi, and start connecting; does not wait
+esp_err_t wifi_link_start(const char *ssid, const char *password);
+
+// Wait until the link has an IP address; returns false on timeout
+bool wifi_link_wait_up(TickType_t timeout);
+
+// Whether the link currently has an IP address
+bool wifi_link_is_up(void);
+
+// Copy the link counters
+void wifi_link_get_stats(wifi_link_stats_t *stats);
@@ -0,0 +1,325 @@
+// Include the Wi-Fi link interface
+#include "wifi_link.h"
+
+// Include the connect/retry state machine
+#include "wifi_link_fsm.h"
+
+// Include standard string functions
+#include <string.h>
+
+// Include ESP32 FreeRTOS headers
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+
+// Include static or dynamic mutex/event group creation (RTOS allocation profile)
+#include "rtos_alloc.h"
+
+// Include ESP32 Wi-Fi, networking and event components
+#include "esp_wifi.h"
+#include "esp_netif.h"
+#include "esp_event.h"
+
+// Include ESP32 high resolution timer, logging and non-volatile storage
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "nvs.h"
+
+// Log tag
+static const char *TAG = "WIFI_LINK";
+
+// NVS location of the cached AP and lease
+#define LINK_NVS_NAMESPACE "wifi_link"
+#define LINK_NVS_KEY "last"
+
+// Event group bit set while the link has an IP address
+#define LINK_UP_BIT BIT0
+
+// Last AP the link was up with
+typedef struct
+{
+    char ssid[33];    // SSID the entry belongs to
+    uint8_t bssid[6]; // AP MAC address
+    uint8_t channel;  // AP primary channel
+    uint32_t ip;      // DHCP lease: address, netmask, gateway (network order)
+    uint32_t netmask;
+    uint32_t gateway;
+} link_cache_t;
+
+static wl_fsm_t fsm;
+static SemaphoreHandle_t fsm_lock; // Event loop and timer task both feed the FSM
+static EventGroupHandle_t link_events;
+static esp_timer_handle_t backoff_timer;
+static esp_netif_t *sta_netif;
+static wifi_config_t wifi_config;
+static link_cache_t cache;
+static bool cache_valid;
+static bool address_preset; // Address applied without DHCP for the current attempt
+
+// ============================================================================
+// NVS Cache
+// ============================================================================
+
+static bool load_cache(const char *ssid)
+{
+    nvs_handle_t handle;
+    size_t size = sizeof(cache);
+
+    if (nvs_open(LINK_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK)
+    {
+        return false;
+    }
+    esp_err_t err = nvs_get_blob(handle, LINK_NVS_KEY, &cache, &size);
+    nvs_close(handle);
+
+    // An entry for another network (or another layout) is ignored
+    return err == ESP_OK && size == sizeof(cache) &&
+           strncmp(cache.ssid, ssid, sizeof(cache.ssid)) == 0 && cache.channel != 0;
+}
+
+// Remember the AP and lease the link is up with
+static void save_cache(void)
+{
+    wifi_ap_record_t ap;
+    esp_netif_ip_info_t ip_info;
+    link_cache_t entry = {0};
+
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK || esp_netif_get_ip_info(sta_netif, &ip_info) != ESP_OK)
+    {
+        return;
+    }
+    strncpy(entry.ssid, (const char *)wifi_config.sta.ssid, sizeof(entry.ssid) - 1);
+    memcpy(entry.bssid, ap.bssid, sizeof(entry.bssid));
+    entry.channel = ap.primary;
+    entry.ip = ip_info.ip.addr;
+    entry.netmask = ip_info.netmask.addr;
+    entry.gateway = ip_info.gw.addr;
+
+    if (cache_valid && memcmp(&entry, &cache, sizeof(entry)) == 0)
+    {
+        return; // Unchanged: spare the flash
+    }
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(LINK_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err == ESP_OK)
+    {
+        err = nvs_set_blob(handle, LINK_NVS_KEY, &entry, sizeof(entry));
+        if (err == ESP_OK)
+        {
+            err = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Could not cache AP: %s", esp_err_to_name(err));
+        return;
+    }
+
+    cache = entry;
+    cache_valid = true;
+}
+
+// ============================================================================
+// Actions
+// ============================================================================
+
+// Apply a static address (configured, or the cached lease on the cached AP)
+// or fall back to DHCP
+static void apply_address(bool cached_ap)
+{
+    esp_netif_ip_info_t ip_info = {0};
+
+#if CONFIG_WIFI_LINK_STATIC_IP
+    (void)cached_ap;
+    ip_info.ip.addr = esp_ip4addr_aton(CONFIG_WIFI_LINK_STATIC_IP_ADDR);
+    ip_info.netmask.addr = esp_ip4addr_aton(CONFIG_WIFI_LINK_STATIC_NETMASK);
+    ip_info.gw.addr = esp_ip4addr_aton(CONFIG_WIFI_LINK_STATIC_GATEWAY);
+#elif CONFIG_WIFI_LINK_REUSE_LEASE
+    if (cached_ap && cache.ip != 0)
+    {
+        ip_info.ip.addr = cache.ip;
+        ip_info.netmask.addr = cache.netmask;
+        ip_info.gw.addr = cache.gateway;
+    }
+#else
+    (void)cached_ap;
+#endif
+
+    address_preset = ip_info.ip.addr != 0;
+    if (address_preset)
+    {
+        esp_netif_dhcpc_stop(sta_netif);
+        esp_netif_set_ip_info(sta_netif, &ip_info);
+    }
+    else
+    {
+        esp_netif_dhcpc_start(sta_netif); // ESP_ERR_ESP_NETIF_DHCP_ALREADY_STARTED is fine
+    }
+}
+
+static void run_action(wl_action_t action)
+{
+    switch (action.type)
+    {
+    case WL_ACT_CONNECT_FAST:
+        // Directed connect: no scan of other channels, no AP selection
+        wifi_config.sta.bssid_set = true;
+        memcpy(wifi_config.sta.bssid, cache.bssid, sizeof(cache.bssid));
+        wifi_config.sta.channel = cache.channel;
+        wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+        apply_address(true);
+        esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+        esp_wifi_connect();
+        break;
+
+    case WL_ACT_CONNECT_SCAN:
+        wifi_config.sta.bssid_set = false;
+        wifi_config.sta.channel = 0;
+        wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+        wifi_config.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+        apply_address(false);
+        esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+        esp_wifi_connect();
+        break;
+
+    case WL_ACT_WAIT:
+        ESP_LOGI(TAG, "Connect failed %lu times, retrying in %lu ms",
+                 (unsigned long)fsm.stats.failures, (unsigned long)action.delay_ms);
+        esp_timer_start_once(backoff_timer, (uint64_t)action.delay_ms * 1000);
+        break;
+
+    case WL_ACT_LINK_UP:
+        save_cache();
+        ESP_LOGI(TAG, "Link up: associated in %lu ms, address in %lu ms%s",
+                 (unsigned long)fsm.stats.last_assoc_ms, (unsigned long)fsm.stats.last_dhcp_ms,
+                 address_preset ? " (no DHCP)" : "");
+        xEventGroupSetBits(link_events, LINK_UP_BIT);
+        break;
+
+    case WL_ACT_NONE:
+        break;
+    }
+}
+
+// Feed one event to the state machine and carry out its action
+static void feed(wl_event_t event)
+{
+    xSemaphoreTake(fsm_lock, portMAX_DELAY);
+    wl_action_t action = wl_fsm_handle(&fsm, event, (uint32_t)(esp_timer_get_time() / 1000));
+    run_action(action);
+    xSemaphoreGive(fsm_lock);
+}
+
+// ============================================================================
+// Event Sources
+// ============================================================================
+
+static void event_handler(void *arg, esp_event_base_t event_base,
+                          int32_t event_id, void *event_data)
+{
+    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START)
+    {
+        feed(WL_EV_START);
+    }
+    else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED)
+    {
+        feed(WL_EV_ASSOCIATED);
+        if (address_preset)
+        {
+            feed(WL_EV_GOT_IP); // Address already set: no DHCP round trip
+        }
+    }
+    else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED)
+    {
+        wifi_event_sta_disconnected_t *event = (wifi_event_sta_disconnected_t *)event_data;
+        ESP_LOGD(TAG, "Disconnected, reason %d", event->reason);
+        xEventGroupClearBits(link_events, LINK_UP_BIT);
+        feed(WL_EV_DISCONNECTED);
+    }
+    else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP)
+    {
+        ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
+        ESP_LOGI(TAG, "Got IP:" IPSTR, IP2STR(&event->ip_info.ip));
+        feed(WL_EV_GOT_IP);
+    }
+}
+
+static void backoff_timer_callback(void *arg)
+{
+    feed(WL_EV_TIMER);
+}
+
+// ============================================================================
+// Public Interface
+// ============================================================================
+
+esp_err_t wifi_link_start(const char *ssid, const char *password)
+{
+    fsm_lock = RTOS_MUTEX_CREATE();
+    link_events = RTOS_EVENT_GROUP_CREATE();
+    if (fsm_lock == NULL || link_events == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = backoff_timer_callback,
+        .name = "wifi_backoff",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &backoff_timer));
+
+    ESP_ERROR_CHECK(esp_netif_init());
+    ESP_ERROR_CHECK(esp_event_loop_create_default());
+    sta_netif = esp_netif_create_default_wifi_sta();
+
+    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
+
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT, ESP_EVENT_ANY_ID,
+                                                        &event_handler, NULL, NULL));
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP,
+                                                        &event_handler, NULL, NULL));
+
+    strncpy((char *)wifi_config.sta.ssid, ssid, sizeof(wifi_config.sta.ssid));
+    strncpy((char *)wifi_config.sta.password, password, sizeof(wifi_config.sta.password));
+    wifi_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
+
+    cache_valid = load_cache(ssid);
+    wl_fsm_init(&fsm, cache_valid, CONFIG_WIFI_LINK_BACKOFF_MIN_MS, CONFIG_WIFI_LINK_BACKOFF_MAX_MS);
+    if (cache_valid)
+    {
+        ESP_LOGI(TAG, "Cached AP " MACSTR " on channel %u", MAC2STR(cache.bssid), cache.channel);
+    }
+
+    // Avoid writing the Wi-Fi config to flash on every connect
+    ESP_ERROR_CHECK(esp_wifi_set_storage(WIFI_STORAGE_RAM));
+    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+    ESP_ERROR_CHECK(esp_wifi_start()); // WIFI_EVENT_STA_START starts the first attempt
+
+    return ESP_OK;
+}
+
+bool wifi_link_wait_up(TickType_t timeout)
+{
+    EventBits_t bits = xEventGroupWaitBits(link_events, LINK_UP_BIT, pdFALSE, pdFALSE, timeout);
+    return (bits & LINK_UP_BIT) != 0;
+}
+
+bool wifi_link_is_up(void)
+{
+    return (xEventGroupGetBits(link_events) & LINK_UP_BIT) != 0;
+}
+
+void wifi_link_get_stats(wifi_link_stats_t *stats)
+{
+    xSemaphoreTake(fsm_lock, portMAX_DELAY);
+    stats->associations = fsm.stats.associations;
+    stats->fast_connects = fsm.stats.fast_connects;
+    stats->full_scans = fsm.stats.full_scans;
+    stats->disconnects = fsm.stats.disconnects;
+    stats->last_assoc_ms = fsm.stats.last_assoc_ms;
+    stats->last_dhcp_ms = fsm.stats.last_dhcp_ms;
+    xSemaphoreGive(fsm_lock);
+}
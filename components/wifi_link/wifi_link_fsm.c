@@ -0,0 +1,113 @@
+// Include the state machine interface
+#include "wifi_link_fsm.h"
+
+// Include memset()
+#include <string.h>
+
+void wl_fsm_init(wl_fsm_t *fsm, bool has_cache, uint32_t backoff_min_ms, uint32_t backoff_max_ms)
+{
+    memset(fsm, 0, sizeof(*fsm));
+    fsm->state = WL_IDLE;
+    fsm->has_cache = has_cache;
+    fsm->backoff_min_ms = backoff_min_ms;
+    fsm->backoff_max_ms = backoff_max_ms;
+}
+
+// Start a new attempt: directed connect if possible, else full scan
+static wl_action_t start_attempt(wl_fsm_t *fsm, uint32_t now_ms)
+{
+    wl_action_t action = {WL_ACT_CONNECT_SCAN, 0};
+
+    fsm->attempt_start = now_ms;
+    if (fsm->has_cache)
+    {
+        fsm->state = WL_CONNECTING_FAST;
+        action.type = WL_ACT_CONNECT_FAST;
+    }
+    else
+    {
+        fsm->state = WL_CONNECTING_SCAN;
+        fsm->stats.full_scans++;
+    }
+    return action;
+}
+
+// A full attempt failed: wait before the next one
+static wl_action_t back_off(wl_fsm_t *fsm)
+{
+    wl_action_t action = {WL_ACT_WAIT, fsm->backoff_min_ms};
+
+    fsm->stats.failures++;
+    for (uint32_t i = 1; i < fsm->stats.failures && action.delay_ms < fsm->backoff_max_ms; i++)
+    {
+        action.delay_ms *= 2;
+    }
+    if (action.delay_ms > fsm->backoff_max_ms)
+    {
+        action.delay_ms = fsm->backoff_max_ms;
+    }
+
+    fsm->state = WL_BACKOFF;
+    return action;
+}
+
+wl_action_t wl_fsm_handle(wl_fsm_t *fsm, wl_event_t event, uint32_t now_ms)
+{
+    wl_action_t none = {WL_ACT_NONE, 0};
+
+    switch (event)
+    {
+    case WL_EV_START:
+        return fsm->state == WL_IDLE ? start_attempt(fsm, now_ms) : none;
+
+    case WL_EV_ASSOCIATED:
+        if (fsm->state != WL_CONNECTING_FAST && fsm->state != WL_CONNECTING_SCAN)
+        {
+            return none;
+        }
+        if (fsm->state == WL_CONNECTING_FAST)
+        {
+            fsm->stats.fast_connects++;
+        }
+        fsm->stats.associations++;
+        fsm->stats.last_assoc_ms = now_ms - fsm->attempt_start;
+        fsm->associated_at = now_ms;
+        fsm->state = WL_ASSOCIATED;
+        return none;
+
+    case WL_EV_GOT_IP:
+        if (fsm->state != WL_ASSOCIATED)
+        {
+            return none;
+        }
+        fsm->stats.last_dhcp_ms = now_ms - fsm->associated_at;
+        fsm->stats.failures = 0;
+        fsm->has_cache = true; // The driver saves the AP it is connected to
+        fsm->state = WL_UP;
+        return (wl_action_t){WL_ACT_LINK_UP, 0};
+
+    case WL_EV_DISCONNECTED:
+        switch (fsm->state)
+        {
+        case WL_CONNECTING_FAST:
+            // Cached AP not reachable (moved channel, gone): scan right away
+            fsm->state = WL_CONNECTING_SCAN;
+            fsm->stats.full_scans++;
+            return (wl_action_t){WL_ACT_CONNECT_SCAN, 0};
+        case WL_CONNECTING_SCAN:
+        case WL_ASSOCIATED:
+            return back_off(fsm);
+        case WL_UP:
+            // Same AP is the best guess after a drop
+            fsm->stats.disconnects++;
+            return start_attempt(fsm, now_ms);
+        default:
+            return none;
+        }
+
+    case WL_EV_TIMER:
+        return fsm->state == WL_BACKOFF ? start_attempt(fsm, now_ms) : none;
+    }
+
+    return none;
+}
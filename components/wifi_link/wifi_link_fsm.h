@@ -0,0 +1,86 @@
+// Wi-Fi connect/retry state machine
+//
+// Pure logic with no ESP-IDF calls: the driver (wifi_link.c) feeds it Wi-Fi
+// and IP events with a millisecond timestamp and carries out the returned
+// action. This keeps the policy testable on a host with a scripted event
+// sequence.
+//
+// Policy:
+//   - With a cached AP (BSSID + channel) a directed connect is tried first;
+//     if it fails, a full scan follows immediately.
+//   - A failed full scan backs off (doubling up to a maximum) and then starts
+//     over with the directed connect. Retrying never stops.
+//   - A drop from an established link reconnects directly to the cached AP.
+
+#pragma once
+
+// Include standard integer and boolean types
+#include <stdbool.h>
+#include <stdint.h>
+
+// Link states
+typedef enum
+{
+    WL_IDLE,            // Not started
+    WL_CONNECTING_FAST, // Directed connect to the cached BSSID/channel
+    WL_CONNECTING_SCAN, // Connect after a full scan
+    WL_ASSOCIATED,      // Associated, waiting for an IP address
+    WL_UP,              // Associated with an IP address
+    WL_BACKOFF,         // Waiting before the next attempt
+} wl_state_t;
+
+// Inputs
+typedef enum
+{
+    WL_EV_START,        // Driver started
+    WL_EV_ASSOCIATED,   // WIFI_EVENT_STA_CONNECTED
+    WL_EV_DISCONNECTED, // WIFI_EVENT_STA_DISCONNECTED (also a failed attempt)
+    WL_EV_GOT_IP,       // IP_EVENT_STA_GOT_IP (or static address applied)
+    WL_EV_TIMER,        // Backoff timer expired
+} wl_event_t;
+
+// What the driver has to do next
+typedef enum
+{
+    WL_ACT_NONE,
+    WL_ACT_CONNECT_FAST, // Configure the cached BSSID/channel and connect
+    WL_ACT_CONNECT_SCAN, // Configure a full scan and connect
+    WL_ACT_WAIT,         // Arm the backoff timer for delay_ms
+    WL_ACT_LINK_UP,      // Link usable: save the cache, signal waiters
+} wl_action_type_t;
+
+typedef struct
+{
+    wl_action_type_t type;
+    uint32_t delay_ms; // WL_ACT_WAIT only
+} wl_action_t;
+
+// Counters and timings reported by the driver
+typedef struct
+{
+    uint32_t associations;  // Successful associations
+    uint32_t fast_connects; // Associations through the directed connect
+    uint32_t full_scans;    // Full-scan connects attempted
+    uint32_t disconnects;   // Drops of an established link
+    uint32_t failures;      // Consecutive failed attempts (0 while up)
+    uint32_t last_assoc_ms; // Attempt start -> associated, last connection
+    uint32_t last_dhcp_ms;  // Associated -> IP address, last connection
+} wl_stats_t;
+
+// State machine instance
+typedef struct
+{
+    wl_state_t state;
+    bool has_cache;           // A cached BSSID/channel is available
+    uint32_t backoff_min_ms;  // First backoff delay
+    uint32_t backoff_max_ms;  // Backoff delays double up to this
+    uint32_t attempt_start;   // Time the current connection attempt started
+    uint32_t associated_at;   // Time of the last association
+    wl_stats_t stats;
+} wl_fsm_t;
+
+// Reset the state machine
+void wl_fsm_init(wl_fsm_t *fsm, bool has_cache, uint32_t backoff_min_ms, uint32_t backoff_max_ms);
+
+// Feed an event at time now_ms and get the action to perform
+wl_action_t wl_fsm_handle(wl_fsm_t *fsm, wl_event_t event, uint32_t now_ms);
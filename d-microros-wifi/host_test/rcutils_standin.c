@@ -0,0 +1,28 @@
+// rcutils default allocator stand-in (the part rcl's allocations go through)
+
+// Include the stand-in header
+#include "rcutils/allocator.h"
+
+static rcutils_allocator_t default_allocator;
+
+rcutils_allocator_t rcutils_get_zero_initialized_allocator(void)
+{
+    rcutils_allocator_t zero = {0};
+    return zero;
+}
+
+rcutils_allocator_t rcutils_get_default_allocator(void)
+{
+    return default_allocator;
+}
+
+bool rcutils_set_default_allocator(rcutils_allocator_t *allocator)
+{
+    if (allocator == NULL || allocator->allocate == NULL || allocator->deallocate == NULL ||
+        allocator->reallocate == NULL || allocator->zero_allocate == NULL)
+    {
+        return false;
+    }
+    default_allocator = *allocator;
+    return true;
+}
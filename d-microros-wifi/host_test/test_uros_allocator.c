@@ -0,0 +1,310 @@
+// Pool allocator tests: block selection, statistics, the steady-state
+// allocation counter, and a replay of the allocations create_entities()
+// makes for the LED node
+//
+// The replay is a model, not a recording: the sizes below are estimates of
+// the rcl/rclc structures each call allocates on a 32-bit target (rcl and
+// rclc humble), not measured. It checks that the pool table holds the
+// modelled node with headroom and that a reconnect cycle gives every block
+// back. It runs no rcl/rmw code, so it says nothing about whether spinning,
+// publishing and taking allocate: that is what the steady-state counter
+// (alloc steady= on /led_diagnostics) shows on the board, next to the real
+// per-pool peaks logged by uros_allocator_set_steady(true).
+
+// Include standard input/output and libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Include the allocator
+#include "uros_allocator.h"
+
+// Entities created by create_entities() in microros_led.c
+#define NODE_SUBSCRIPTIONS 4
+#define NODE_PUBLISHERS 5
+#define NODE_TIMERS 5
+#define EXECUTOR_HANDLES 9
+
+// Approximate sizeof() of what rcl/rclc allocate per call (32-bit target)
+#define SIZE_CONTEXT_IMPL 160      // rcl_context_impl_t with the rmw context
+#define SIZE_INIT_OPTIONS_IMPL 80  // Copy of the init options
+#define SIZE_ARGUMENTS_IMPL 48     // Parsed (empty) global arguments
+#define SIZE_NODE_IMPL 176         // rcl_node_impl_t incl. options and rosout QoS
+#define SIZE_GUARD_CONDITION 8     // rcl_guard_condition_t
+#define SIZE_GUARD_IMPL 28         // rcl_guard_condition_impl_t
+#define SIZE_PUBLISHER_IMPL 240    // rcl_publisher_impl_t incl. options and actual QoS
+#define SIZE_SUBSCRIPTION_IMPL 248 // rcl_subscription_impl_t incl. options and actual QoS
+#define SIZE_TIMER_IMPL 96         // rcl_timer_impl_t
+#define SIZE_EXECUTOR_HANDLE 72    // rclc_executor_handle_t
+#define SIZE_WAIT_SET_IMPL 80      // rcl_wait_set_impl_t
+#define SIZE_RMW_WAIT_SET 40       // rmw_wait_set_t
+#define SIZE_NAME 24               // Short strings: enclave, logger name, topic names
+#define SIZE_STRING_MAP 36         // rcutils_string_map_t impl used to expand topic names
+
+static int failures;
+
+#define CHECK_EQ(what, got, expected)                                                         \
+    do                                                                                        \
+    {                                                                                         \
+        if ((long)(got) != (long)(expected))                                                  \
+        {                                                                                     \
+            printf("  %s: got %ld, expected %ld\n", (what), (long)(got), (long)(expected));    \
+            failures++;                                                                       \
+        }                                                                                     \
+    } while (0)
+
+#define CHECK(what, condition)              \
+    do                                      \
+    {                                       \
+        if (!(condition))                   \
+        {                                   \
+            printf("  %s: failed\n", what); \
+            failures++;                     \
+        }                                   \
+    } while (0)
+
+static rcutils_allocator_t allocator;
+
+// Block size of the pool a pointer came from (0 if none)
+static unsigned block_size_of(void *pointer)
+{
+    uros_pool_stats_t before[16];
+    uros_pool_stats_t after;
+    size_t count = 0;
+    unsigned size = 0;
+
+    // Freeing the block drops in_use of exactly one pool
+    while (uros_allocator_get_pool(count, &before[count]))
+    {
+        count++;
+    }
+    allocator.deallocate(pointer, allocator.state);
+    for (size_t i = 0; i < count; i++)
+    {
+        uros_allocator_get_pool(i, &after);
+        if (after.in_use != before[i].in_use)
+        {
+            size = after.block_size;
+        }
+    }
+    return size;
+}
+
+// Smallest block that fits, spill to the next size, realloc, zero-allocate
+static void test_pools(void)
+{
+    uros_allocator_stats_t stats;
+    uros_pool_stats_t pool;
+
+    printf("pools\n");
+    allocator = uros_allocator_init();
+
+    CHECK_EQ("1 byte", block_size_of(allocator.allocate(1, allocator.state)), 32);
+    CHECK_EQ("32 bytes", block_size_of(allocator.allocate(32, allocator.state)), 32);
+    CHECK_EQ("33 bytes", block_size_of(allocator.allocate(33, allocator.state)), 64);
+    CHECK_EQ("300 bytes", block_size_of(allocator.allocate(300, allocator.state)), 512);
+
+    // An exhausted pool hands out blocks of the next size up
+    uros_allocator_get_pool(0, &pool);
+    void **blocks = calloc(pool.count, sizeof(void *));
+    for (unsigned i = 0; i < pool.count; i++)
+    {
+        blocks[i] = allocator.allocate(16, allocator.state);
+    }
+    CHECK_EQ("spill", block_size_of(allocator.allocate(16, allocator.state)), 64);
+    for (unsigned i = 0; i < pool.count; i++)
+    {
+        allocator.deallocate(blocks[i], allocator.state);
+    }
+    free(blocks);
+
+    // Reallocate stays in place while the block is big enough, then copies
+    char *text = allocator.allocate(10, allocator.state);
+    strcpy(text, "micro-ROS");
+    CHECK("realloc in place", allocator.reallocate(text, 30, allocator.state) == text);
+    char *grown = allocator.reallocate(text, 100, allocator.state);
+    CHECK("realloc copies", strcmp(grown, "micro-ROS") == 0);
+    CHECK_EQ("realloc grows", block_size_of(grown), 128);
+
+    unsigned char *zeroed = allocator.zero_allocate(10, 20, allocator.state);
+    int all_zero = 1;
+    for (int i = 0; i < 200; i++)
+    {
+        all_zero &= zeroed[i] == 0;
+    }
+    CHECK("zero_allocate", all_zero);
+    CHECK_EQ("zero_allocate size", block_size_of(zeroed), 256);
+    CHECK("zero_allocate overflow", allocator.zero_allocate((size_t)-1, 2, allocator.state) == NULL);
+
+    allocator.deallocate(NULL, allocator.state);
+    uros_allocator_get_stats(&stats);
+    CHECK_EQ("bytes_in_use", stats.bytes_in_use, 0);
+    CHECK("bytes_peak", stats.bytes_peak >= 32 * pool.count);
+    CHECK_EQ("steady_allocations", stats.steady_allocations, 0);
+}
+
+// The steady-state counter counts only allocations made while steady
+static void test_steady_counter(void)
+{
+    uros_allocator_stats_t stats;
+
+    printf("steady_counter\n");
+    allocator = uros_allocator_init();
+
+    void *setup = allocator.allocate(100, allocator.state);
+    uros_allocator_set_steady(true);
+    uros_allocator_get_stats(&stats);
+    CHECK_EQ("no allocations yet", stats.steady_allocations, 0);
+
+    allocator.deallocate(setup, allocator.state); // Frees are not counted
+    allocator.deallocate(allocator.allocate(8, allocator.state), allocator.state);
+    allocator.deallocate(allocator.allocate(8, allocator.state), allocator.state);
+    uros_allocator_get_stats(&stats);
+    CHECK_EQ("counted in steady state", stats.steady_allocations, 2);
+
+    uros_allocator_set_steady(false);
+    allocator.deallocate(allocator.allocate(8, allocator.state), allocator.state);
+    uros_allocator_get_stats(&stats);
+    CHECK_EQ("not counted after steady", stats.steady_allocations, 2);
+    CHECK_EQ("allocations", stats.allocations, 4);
+}
+
+// ============================================================================
+// Entity Replay
+// ============================================================================
+
+// Live blocks of the modelled node, freed again by destroy_entities()
+static void *live[128];
+static int live_count;
+
+// scale_percent grows every structure (100 = the sizes above)
+static int scale_percent;
+
+static void *hold(size_t size)
+{
+    void *block = allocator.allocate(size * scale_percent / 100, allocator.state);
+    live[live_count++] = block;
+    return block;
+}
+
+// Resolving a topic or node name: a string map of the substitutions, the
+// expanded and the remapped name, all freed before the call returns
+static void resolve_name(void)
+{
+    void *temporary[10];
+    int count = 0;
+
+    temporary[count++] = allocator.zero_allocate(1, SIZE_STRING_MAP, allocator.state);
+    temporary[count++] = allocator.allocate(3 * sizeof(char *), allocator.state); // Keys
+    temporary[count++] = allocator.allocate(3 * sizeof(char *), allocator.state); // Values
+    for (int i = 0; i < 6; i++)
+    {
+        temporary[count++] = allocator.allocate(SIZE_NAME, allocator.state);
+    }
+    temporary[count++] = allocator.allocate(2 * SIZE_NAME, allocator.state); // Expanded name
+    while (count > 0)
+    {
+        allocator.deallocate(temporary[--count], allocator.state);
+    }
+}
+
+static void guard_condition(void)
+{
+    hold(SIZE_GUARD_CONDITION);
+    hold(SIZE_GUARD_IMPL);
+}
+
+// What create_entities() allocates, in its order
+static void create_entities_model(void)
+{
+    // rclc_support_init_with_options(): context, init options, arguments
+    hold(SIZE_INIT_OPTIONS_IMPL);
+    hold(SIZE_CONTEXT_IMPL);
+    hold(SIZE_ARGUMENTS_IMPL);
+    hold(SIZE_NAME); // Enclave
+
+    // rclc_node_init_default(): node, names, graph guard condition
+    resolve_name();
+    hold(SIZE_NODE_IMPL);
+    hold(SIZE_NAME); // Logger name
+    hold(SIZE_NAME); // Fully qualified name
+    guard_condition();
+
+    for (int i = 0; i < NODE_SUBSCRIPTIONS; i++)
+    {
+        resolve_name();
+        hold(SIZE_SUBSCRIPTION_IMPL);
+    }
+    for (int i = 0; i < NODE_PUBLISHERS; i++)
+    {
+        resolve_name();
+        hold(SIZE_PUBLISHER_IMPL);
+    }
+    for (int i = 0; i < NODE_TIMERS; i++)
+    {
+        hold(SIZE_TIMER_IMPL);
+        guard_condition();
+    }
+
+    // rclc_executor_init(), then rclc_executor_prepare() builds the wait set
+    hold(EXECUTOR_HANDLES * SIZE_EXECUTOR_HANDLE);
+    hold(SIZE_WAIT_SET_IMPL);
+    hold(NODE_SUBSCRIPTIONS * sizeof(void *)); // rcl subscription slots
+    hold(NODE_TIMERS * sizeof(void *));        // rcl timer slots
+    hold(NODE_SUBSCRIPTIONS * sizeof(void *)); // rmw subscription slots
+    hold(NODE_TIMERS * sizeof(void *));        // rmw guard condition slots (timers)
+    hold(SIZE_RMW_WAIT_SET);
+}
+
+static void destroy_entities_model(void)
+{
+    while (live_count > 0)
+    {
+        allocator.deallocate(live[--live_count], allocator.state);
+    }
+}
+
+// Connect, spin, lose the agent, reconnect: pools must hold the node with
+// a quarter of every used pool to spare, and no block may leak
+static void test_entity_replay(int percent)
+{
+    uros_allocator_stats_t stats;
+    uros_pool_stats_t pool;
+
+    printf("entity_replay (structures at %d%%)\n", percent);
+    allocator = uros_allocator_init();
+    scale_percent = percent;
+
+    for (int cycle = 0; cycle < 3; cycle++)
+    {
+        create_entities_model();
+        destroy_entities_model();
+    }
+
+    uros_allocator_get_stats(&stats);
+    CHECK_EQ("bytes_in_use after teardown", stats.bytes_in_use, 0);
+    printf("  peak %u of %u bytes\n", (unsigned)stats.bytes_peak, (unsigned)stats.bytes_total);
+
+    for (size_t i = 0; uros_allocator_get_pool(i, &pool); i++)
+    {
+        printf("  %4u-byte blocks: peak %2u of %2u\n", pool.block_size, pool.peak, pool.count);
+        if (percent == 100)
+        {
+            CHECK("headroom", pool.peak * 4 <= pool.count * 3);
+        }
+    }
+}
+
+int main(void)
+{
+    test_pools();
+    test_steady_counter();
+    test_entity_replay(100);
+
+    // Larger structures (another rcl release) spill into bigger blocks but
+    // must still fit; exhaustion aborts the test
+    test_entity_replay(150);
+
+    printf(failures ? "FAILED (%d)\n" : "OK\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,140 @@
+// Include the agent finder interface
+#include "agent_finder.h"
+
+// Include standard libraries
+#include <stdio.h>
+#include <string.h>
+
+// Include ESP32 logging and non-volatile storage
+#include "esp_log.h"
+#include "nvs.h"
+
+// Include micro-ROS utilities (UDP address, ping)
+#include <rmw_microros/rmw_microros.h>
+
+// Include XRCE-DDS agent discovery
+#include <uxr/client/profile/discovery/discovery.h>
+#include <uxr/client/util/ip.h>
+
+// Log tag
+static const char *TAG = "AGENT_FINDER";
+
+// NVS location of the cached agent
+#define AGENT_NVS_NAMESPACE "uros_agent"
+#define AGENT_NVS_KEY "last"
+
+#define PROBE_TIMEOUT_MS 100   // Ping timeout for one candidate
+#define DISCOVERY_ATTEMPTS 1   // Multicast requests per search
+#define DISCOVERY_WAIT_MS 300  // Time to wait for answers to one request
+
+// Set the address in the options and check that an agent answers there
+static bool probe(rmw_init_options_t *rmw_options, const agent_address_t *address)
+{
+    if (rmw_uros_options_set_udp_address(address->ip, address->port, rmw_options) != RMW_RET_OK)
+    {
+        return false;
+    }
+    return rmw_uros_ping_agent_options(PROBE_TIMEOUT_MS, 1, rmw_options) == RMW_RET_OK;
+}
+
+// Read the cached agent; returns false if there is none
+static bool load_cached(agent_address_t *address)
+{
+    nvs_handle_t handle;
+    size_t size = sizeof(*address);
+
+    if (nvs_open(AGENT_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK)
+    {
+        return false;
+    }
+    esp_err_t err = nvs_get_blob(handle, AGENT_NVS_KEY, address, &size);
+    nvs_close(handle);
+
+    // Reject blobs of another layout and unterminated strings
+    return err == ESP_OK && size == sizeof(*address) &&
+           memchr(address->ip, '\0', sizeof(address->ip)) != NULL &&
+           memchr(address->port, '\0', sizeof(address->port)) != NULL;
+}
+
+// Discovery callback: keep the first agent that answers
+static bool on_agent_found(const TransportLocator *locator, void *args)
+{
+    agent_address_t *address = (agent_address_t *)args;
+    uint16_t port;
+    uxrIpProtocol protocol;
+
+    if (!uxr_locator_to_ip(locator, address->ip, sizeof(address->ip), &port, &protocol) ||
+        protocol != UXR_IPv4)
+    {
+        return false; // Keep listening
+    }
+    snprintf(address->port, sizeof(address->port), "%u", port);
+    return true; // Stop discovery
+}
+
+bool agent_finder_find(rmw_init_options_t *rmw_options, agent_address_t *address)
+{
+    agent_address_t cached;
+    bool have_cached = load_cached(&cached);
+
+    // 1. Last agent that accepted a session
+    if (have_cached && probe(rmw_options, &cached))
+    {
+        *address = cached;
+        ESP_LOGI(TAG, "Cached agent %s:%s answered", address->ip, address->port);
+        return true;
+    }
+
+    // 2. Configured agent (skipped if it is the cached one that just failed)
+    agent_address_t configured = {0};
+    snprintf(configured.ip, sizeof(configured.ip), "%s", CONFIG_MICROROS_LED_AGENT_IP);
+    snprintf(configured.port, sizeof(configured.port), "%d", CONFIG_MICROROS_LED_AGENT_PORT);
+    bool same_as_cached = have_cached && strcmp(cached.ip, configured.ip) == 0 &&
+                          strcmp(cached.port, configured.port) == 0;
+    if (!same_as_cached && probe(rmw_options, &configured))
+    {
+        *address = configured;
+        ESP_LOGI(TAG, "Configured agent %s:%s answered", address->ip, address->port);
+        return true;
+    }
+
+    // 3. Multicast discovery
+    agent_address_t discovered = {0};
+    uxr_discovery_agents_default(DISCOVERY_ATTEMPTS, DISCOVERY_WAIT_MS, on_agent_found, &discovered);
+    if (discovered.ip[0] != '\0' && probe(rmw_options, &discovered))
+    {
+        *address = discovered;
+        ESP_LOGI(TAG, "Discovered agent %s:%s", address->ip, address->port);
+        return true;
+    }
+
+    return false;
+}
+
+void agent_finder_remember(const agent_address_t *address)
+{
+    agent_address_t cached;
+    if (load_cached(&cached) && memcmp(&cached, address, sizeof(cached)) == 0)
+    {
+        return; // Unchanged: spare the flash
+    }
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(AGENT_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err == ESP_OK)
+    {
+        err = nvs_set_blob(handle, AGENT_NVS_KEY, address, sizeof(*address));
+        if (err == ESP_OK)
+        {
+            err = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Could not cache agent address: %s", esp_err_to_name(err));
+        return;
+    }
+    ESP_LOGI(TAG, "Cached agent %s:%s", address->ip, address->port);
+}
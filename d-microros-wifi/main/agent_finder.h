@@ -0,0 +1,30 @@
+// micro-ROS agent discovery
+//
+// Candidates are tried in order until one answers a short ping:
+//   1. the last agent that accepted a session (cached in NVS)
+//   2. the configured agent (MICROROS_LED_AGENT_IP / _PORT)
+//   3. any agent answering a multicast discovery request
+// Each probe takes at most a few hundred milliseconds, so a cold connect to
+// a known agent does not wait for long ping timeouts. Retrying with backoff
+// is up to the caller.
+
+#pragma once
+
+// Include standard boolean type
+#include <stdbool.h>
+
+// Include the rmw init options that carry the agent address
+#include <rmw/init_options.h>
+
+// Agent UDP address as text, the form rmw_uros_options_set_udp_address() takes
+typedef struct
+{
+    char ip[16];  // Dotted IPv4 address
+    char port[6]; // Decimal UDP port
+} agent_address_t;
+
+// Find a reachable agent; on success it is stored in address and set in rmw_options
+bool agent_finder_find(rmw_init_options_t *rmw_options, agent_address_t *address);
+
+// Cache an agent that accepted a session so the next boot tries it first
+void agent_finder_remember(const agent_address_t *address);
@@ -0,0 +1,73 @@
+// Include the boot timeline interface
+#include "boot_timeline.h"
+
+// Include standard input/output library for snprintf()
+#include <stdio.h>
+
+// Include ESP32 high resolution timer and logging
+#include "esp_timer.h"
+#include "esp_log.h"
+
+// Log tag
+static const char *TAG = "BOOT";
+
+// Time each phase was reached (us), 0 = not yet
+static int64_t phase_us[BOOT_PHASE_COUNT];
+
+// Names used in the log and diagnostics text, indexed by boot_phase_t
+static const char *const phase_names[BOOT_PHASE_COUNT] = {
+    "app_main",
+    "nvs",
+    "wifi_start",
+    "uros_prep",
+    "wifi_ip",
+    "agent",
+    "entities",
+    "first_cmd",
+};
+
+bool boot_mark(boot_phase_t phase)
+{
+    if (phase_us[phase] != 0)
+    {
+        return false;
+    }
+    phase_us[phase] = esp_timer_get_time();
+    return true;
+}
+
+size_t boot_format(char *buffer, size_t size)
+{
+    size_t len = 0;
+
+    if (size == 0)
+    {
+        return 0;
+    }
+    buffer[0] = '\0';
+
+    for (int i = 0; i < BOOT_PHASE_COUNT && len < size; i++)
+    {
+        if (phase_us[i] == 0)
+        {
+            continue;
+        }
+        int written = snprintf(buffer + len, size - len, "%s%s=%lld",
+                               len ? " " : "", phase_names[i],
+                               (long long)(phase_us[i] / 1000));
+        if (written < 0)
+        {
+            break;
+        }
+        len += written;
+    }
+    return len < size ? len : size - 1;
+}
+
+void boot_log(void)
+{
+    char text[160];
+
+    boot_format(text, sizeof(text));
+    ESP_LOGI(TAG, "Boot timeline (ms): %s", text);
+}
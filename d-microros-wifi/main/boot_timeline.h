@@ -0,0 +1,38 @@
+// Boot timeline
+//
+// Bring-up steps run in parallel (Wi-Fi associates while the micro-ROS task
+// prepares its allocator and init options), so the boot time is not the sum
+// of the steps. Each phase records the esp_timer time (microseconds since
+// the timer started, shortly before app_main) the first time it is reached.
+// The timeline is logged once the first LED command arrives and is appended
+// to /led_diagnostics.
+
+#pragma once
+
+// Include standard integer, boolean and size types
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Boot phases, roughly in the order they are reached
+typedef enum
+{
+    BOOT_APP_MAIN,       // app_main entered
+    BOOT_NVS_READY,      // NVS initialized
+    BOOT_WIFI_STARTED,   // Wi-Fi driver started, association running
+    BOOT_UROS_PREPARED,  // Allocator, init options and message memory ready
+    BOOT_WIFI_CONNECTED, // Got an IP address
+    BOOT_AGENT_FOUND,    // An agent answered
+    BOOT_ENTITIES_READY, // Session, node, topics and executor created
+    BOOT_FIRST_COMMAND,  // First LED command callback ran
+    BOOT_PHASE_COUNT,
+} boot_phase_t;
+
+// Record the current time for a phase; returns true only the first time
+bool boot_mark(boot_phase_t phase);
+
+// Write "name=ms ..." for every phase reached into buffer; returns the length
+size_t boot_format(char *buffer, size_t size);
+
+// Log the timeline
+void boot_log(void);
@@ -0,0 +1,97 @@
+// Include the latency interface
+#include "latency.h"
+
+// Include standard input/output library for snprintf()
+#include <stdio.h>
+
+// Include ESP32 high resolution timer
+#include "esp_timer.h"
+
+// One histogram per stage
+typedef struct
+{
+    uint32_t buckets[LATENCY_BUCKETS]; // Sample counts per log2 bucket
+    uint32_t count;                    // Total samples
+    uint32_t max_us;                   // Largest sample
+} latency_histogram_t;
+
+static latency_histogram_t histograms[LATENCY_STAGE_COUNT];
+
+// Names used in the diagnostics text, indexed by latency_stage_t
+static const char *const stage_names[LATENCY_STAGE_COUNT] = {
+    "dispatch_cb",
+    "cb_gpio",
+    "gpio_pub",
+    "dispatch_pub",
+    "decode_str",
+    "decode_batch",
+    "timer_jitter",
+};
+
+uint32_t latency_now(void)
+{
+    return (uint32_t)esp_timer_get_time();
+}
+
+void latency_record(latency_stage_t stage, uint32_t from, uint32_t to)
+{
+    latency_record_us(stage, to - from); // Unsigned subtraction handles wrap-around
+}
+
+void latency_record_us(latency_stage_t stage, uint32_t us)
+{
+    latency_histogram_t *h = &histograms[stage];
+
+    // Bucket index = number of significant bits
+    int bucket = us ? 32 - __builtin_clz(us) : 0;
+    if (bucket >= LATENCY_BUCKETS)
+    {
+        bucket = LATENCY_BUCKETS - 1;
+    }
+
+    h->buckets[bucket]++;
+    h->count++;
+    if (us > h->max_us)
+    {
+        h->max_us = us;
+    }
+}
+
+// Upper bound (us) of the bucket holding the given percentile
+static uint32_t percentile(const latency_histogram_t *h, uint32_t percent)
+{
+    uint32_t target = (uint64_t)h->count * percent / 100;
+    uint32_t seen = 0;
+
+    for (int i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        seen += h->buckets[i];
+        if (seen > target)
+        {
+            return (1u << i) - 1;
+        }
+    }
+    return h->max_us;
+}
+
+size_t latency_format(char *buffer, size_t size)
+{
+    size_t len = 0;
+
+    for (int i = 0; i < LATENCY_STAGE_COUNT && len < size; i++)
+    {
+        const latency_histogram_t *h = &histograms[i];
+        int written = snprintf(buffer + len, size - len, "%s%s n=%lu p50=%lu p99=%lu max=%lu",
+                               i ? "; " : "", stage_names[i],
+                               (unsigned long)h->count,
+                               (unsigned long)percentile(h, 50),
+                               (unsigned long)percentile(h, 99),
+                               (unsigned long)h->max_us);
+        if (written < 0)
+        {
+            break;
+        }
+        len += written;
+    }
+    return len < size ? len : size - 1;
+}
@@ -0,0 +1,47 @@
+// Latency histograms for the LED command path
+//
+// Each command is stamped (esp_timer microseconds, truncated to 32 bits) at
+// the stages the firmware can observe:
+//   dispatch - rcl_wait() returned with data and the executor is about to
+//              run callbacks (first point after the transport receive)
+//   callback - subscription callback entered
+//   gpio     - LED worker wrote the GPIO
+//   publish  - /led_status message carrying the change was published
+//   decoded  - callback finished turning the message into queued operations
+// The time between two stages is recorded in a log2 histogram, so the
+// cost per sample is a few instructions and the memory is fixed.
+
+#pragma once
+
+// Include standard integer and size types
+#include <stddef.h>
+#include <stdint.h>
+
+// Histogram buckets: bucket n holds samples in [2^(n-1), 2^n) us, bucket 0 is < 1 us
+#define LATENCY_BUCKETS 22
+
+// Measured intervals
+typedef enum
+{
+    LATENCY_DISPATCH_TO_CALLBACK, // Executor dispatch -> callback entry
+    LATENCY_CALLBACK_TO_GPIO,     // Callback entry -> GPIO write (queue wait)
+    LATENCY_GPIO_TO_PUBLISH,      // GPIO write -> /led_status publish
+    LATENCY_DISPATCH_TO_PUBLISH,  // Whole path seen by a subscriber
+    LATENCY_COMMAND_DECODE,       // /led_command callback entry -> op queued (string path)
+    LATENCY_BATCH_DECODE,         // /led_batch callback entry -> all ops queued
+    LATENCY_TIMER_JITTER,         // |actual - nominal| period of the /led_status timer
+    LATENCY_STAGE_COUNT,
+} latency_stage_t;
+
+// Current time stamp in microseconds (wraps after ~71 minutes)
+uint32_t latency_now(void);
+
+// Record the interval between two stamps
+void latency_record(latency_stage_t stage, uint32_t from, uint32_t to);
+
+// Record a duration measured elsewhere (microseconds)
+void latency_record_us(latency_stage_t stage, uint32_t us);
+
+// Write "name n=.. p50=.. p99=.. max=.." for every stage into buffer
+// Percentiles are bucket upper bounds in microseconds. Returns the length.
+size_t latency_format(char *buffer, size_t size);
@@ -0,0 +1,263 @@
+// Include the LED worker interface
+#include "led_worker.h"
+
+// Include ESP32 FreeRTOS headers
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+// Include ESP32 drivers
+#include "driver/gpio.h"
+#include "esp_log.h"
+
+// Include ESP32 high resolution timer
+#include "esp_timer.h"
+
+// Include latency histograms
+#include "latency.h"
+
+// Include cycle counters for the queue and GPIO paths
+#include "perf_counter.h"
+
+// Include the binary event trace and this node's event IDs
+#include "trace_ring.h"
+#include "trace_ids.h"
+
+// Include deferred logging (per-operation messages stay off the worker)
+#include "dlog.h"
+
+// Include static or dynamic queue and task creation (RTOS allocation profile)
+#include "rtos_alloc.h"
+
+// Log tag
+static const char *TAG = "LED_WORKER";
+
+// Worker task placement (see Kconfig.projbuild)
+#if CONFIG_MICROROS_LED_WORKER_CORE < 0
+#define LED_WORKER_CORE tskNO_AFFINITY
+#else
+#define LED_WORKER_CORE CONFIG_MICROROS_LED_WORKER_CORE
+#endif
+
+// Cycle counters (reported with the diagnostics)
+static perf_counter_t submit_perf = PERF_COUNTER_INIT("led_submit");
+static perf_counter_t set_perf = PERF_COUNTER_INIT("led_set");
+
+// Worker state
+static QueueHandle_t led_queue;
+static TaskHandle_t worker_task;
+static volatile int led_state = 0;
+static volatile uint32_t led_changes = 0;
+static led_worker_stats_t stats;
+
+// Latency bookkeeping
+static const led_op_t *current_op;    // Operation being executed
+static int current_op_written;        // Current operation already wrote the GPIO
+static int current_op_changed;        // Current operation already changed the LED
+static uint32_t last_change_dispatch; // Dispatch stamp if the last transition was an op's first, else 0
+static uint32_t last_change_gpio;     // Time of the last transition
+static portMUX_TYPE change_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Transition log (written by the worker, taken by the publisher; change_lock)
+static led_transition_t transitions[LED_TRANSITION_LOG];
+static uint32_t transitions_head; // Next slot to write
+static uint32_t transitions_tail; // Next slot to take
+
+// ============================================================================
+// LED Control Functions (worker task only)
+// ============================================================================
+
+// Set the GPIO and count real transitions for the status publisher
+static void led_set(int level)
+{
+    uint32_t start = PERF_COUNTER_START();
+    gpio_set_level(LED_GPIO, level);
+    TRACE_INSTANT(TRACE_ID_LED_SET, level);
+    int64_t now_us = esp_timer_get_time();
+    uint32_t now = (uint32_t)now_us; // Same clock as latency_now()
+
+    // The first write of an operation ends its queue wait
+    if (!current_op_written)
+    {
+        latency_record(LATENCY_CALLBACK_TO_GPIO, current_op->callback, now);
+        current_op_written = 1;
+    }
+
+    if (level != led_state)
+    {
+        taskENTER_CRITICAL(&change_lock);
+        led_state = level;
+        led_changes++;
+        last_change_gpio = now;
+
+        // Only an operation's first transition counts for the whole-path latency
+        last_change_dispatch = current_op_changed ? 0 : current_op->dispatch;
+        current_op_changed = 1;
+
+        // Log the transition; when full, the oldest entry is overwritten
+        if (transitions_head - transitions_tail == LED_TRANSITION_LOG)
+        {
+            transitions_tail++;
+            stats.transitions_lost++;
+        }
+        led_transition_t *t = &transitions[transitions_head % LED_TRANSITION_LOG];
+        t->time_us = now_us;
+        t->seq = led_changes;
+        t->level = level;
+        transitions_head++;
+        taskEXIT_CRITICAL(&change_lock);
+    }
+
+    PERF_COUNTER_STOP(&set_perf, start);
+}
+
+static void led_on(void)
+{
+    led_set(1);
+    DLOGI(TAG, "LED turned ON");
+}
+
+static void led_off(void)
+{
+    led_set(0);
+    DLOGI(TAG, "LED turned OFF");
+}
+
+static void led_toggle(void)
+{
+    led_set(!led_state);
+    DLOGI(TAG, "LED toggled to %s", led_state ? "ON" : "OFF");
+}
+
+static void led_blink(int times, int delay_ms)
+{
+    DLOGI(TAG, "Blinking LED %d times", times);
+    for (int i = 0; i < times; i++)
+    {
+        led_on();
+        vTaskDelay(delay_ms / portTICK_PERIOD_MS);
+        led_off();
+        vTaskDelay(delay_ms / portTICK_PERIOD_MS);
+    }
+}
+
+// ============================================================================
+// Worker Task
+// ============================================================================
+
+static void led_worker_task(void *arg)
+{
+    led_op_t op;
+
+    while (1)
+    {
+        xQueueReceive(led_queue, &op, portMAX_DELAY);
+        current_op = &op;
+        current_op_written = 0;
+        current_op_changed = 0;
+
+        switch (op.code)
+        {
+        case LED_OP_ON:
+            led_on();
+            break;
+        case LED_OP_OFF:
+            led_off();
+            break;
+        case LED_OP_TOGGLE:
+            led_toggle();
+            break;
+        case LED_OP_BLINK:
+            led_blink(op.count, op.period_ms);
+            break;
+        default:
+            ESP_LOGW(TAG, "Unknown LED operation %d", op.code);
+            break;
+        }
+
+        stats.executed++;
+    }
+}
+
+// ============================================================================
+// Public Interface
+// ============================================================================
+
+void led_worker_init(void)
+{
+    gpio_reset_pin(LED_GPIO);
+    gpio_set_direction(LED_GPIO, GPIO_MODE_OUTPUT);
+    gpio_set_level(LED_GPIO, 0);
+    led_state = 0;
+    ESP_LOGI(TAG, "LED initialized on GPIO %d", LED_GPIO);
+
+    led_queue = RTOS_QUEUE_CREATE(LED_QUEUE_LENGTH, sizeof(led_op_t));
+    RTOS_TASK_CREATE_PINNED(led_worker_task,
+                            "led_worker",
+                            CONFIG_MICROROS_LED_WORKER_STACK,
+                            NULL,
+                            CONFIG_MICROROS_LED_WORKER_PRIORITY,
+                            &worker_task,
+                            LED_WORKER_CORE);
+}
+
+bool led_worker_submit(const led_op_t *op)
+{
+    uint32_t start = PERF_COUNTER_START();
+
+    // Never wait: a full queue means the new operation is dropped
+    if (xQueueSend(led_queue, op, 0) != pdTRUE)
+    {
+        stats.dropped++;
+        return false;
+    }
+    PERF_COUNTER_STOP(&submit_perf, start);
+    TRACE_INSTANT(TRACE_ID_LED_SUBMIT, op->code);
+
+    stats.enqueued++;
+    uint32_t waiting = uxQueueMessagesWaiting(led_queue);
+    if (waiting > stats.high_water)
+    {
+        stats.high_water = waiting;
+    }
+    return true;
+}
+
+int led_worker_state(void)
+{
+    return led_state;
+}
+
+uint32_t led_worker_change_count(void)
+{
+    return led_changes;
+}
+
+void led_worker_last_change(uint32_t *dispatch, uint32_t *gpio)
+{
+    taskENTER_CRITICAL(&change_lock);
+    *dispatch = last_change_dispatch;
+    *gpio = last_change_gpio;
+    taskEXIT_CRITICAL(&change_lock);
+}
+
+bool led_worker_take_transition(led_transition_t *transition)
+{
+    bool taken = false;
+
+    taskENTER_CRITICAL(&change_lock);
+    if (transitions_tail != transitions_head)
+    {
+        *transition = transitions[transitions_tail % LED_TRANSITION_LOG];
+        transitions_tail++;
+        taken = true;
+    }
+    taskEXIT_CRITICAL(&change_lock);
+    return taken;
+}
+
+void led_worker_get_stats(led_worker_stats_t *out)
+{
+    *out = stats;
+    out->stack_free = worker_task ? uxTaskGetStackHighWaterMark(worker_task) : 0;
+}
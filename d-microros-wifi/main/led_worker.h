@@ -0,0 +1,82 @@
+// LED worker task
+//
+// micro-ROS callbacks must not block the executor, so they only enqueue
+// fixed-size LED operations here. A dedicated task drains the queue and
+// drives the GPIO, including effects that take time such as BLINK.
+//
+// Overflow policy: when the queue is full the new operation is dropped and
+// counted. Queued operations are never reordered or overwritten, and
+// callers never wait.
+
+#pragma once
+
+// Include standard integer and boolean types
+#include <stdbool.h>
+#include <stdint.h>
+
+// LED GPIO Configuration
+#define LED_GPIO 2 // Onboard LED on most ESP32 boards
+
+// Queue and task configuration
+// Core, priority and stack come from Kconfig (micro-ROS LED -> Task placement)
+#define LED_QUEUE_LENGTH 32   // Operations waiting for the worker (holds one full /led_batch)
+#define LED_TRANSITION_LOG 32 // Transitions kept until the publisher takes them
+
+// LED operations (same values as the LedOp.msg constants, checked in microros_led.c)
+typedef enum
+{
+    LED_OP_ON,     // Turn LED on
+    LED_OP_OFF,    // Turn LED off
+    LED_OP_TOGGLE, // Invert LED
+    LED_OP_BLINK,  // Blink count times, period_ms on and period_ms off
+} led_op_code_t;
+
+// One queued LED operation
+typedef struct
+{
+    uint8_t code;       // led_op_code_t
+    uint16_t count;     // Blink count (BLINK only)
+    uint16_t period_ms; // Half-period of a blink (BLINK only)
+    uint32_t dispatch;  // Latency stamp: executor dispatch of the message
+    uint32_t callback;  // Latency stamp: callback entry
+} led_op_t;
+
+// One LED transition, as written to the GPIO
+typedef struct
+{
+    int64_t time_us; // esp_timer time of the GPIO write
+    uint32_t seq;    // Transition number since boot
+    uint8_t level;   // New LED level
+} led_transition_t;
+
+// Worker counters
+typedef struct
+{
+    uint32_t enqueued;         // Operations accepted into the queue
+    uint32_t executed;         // Operations finished by the worker
+    uint32_t dropped;          // Operations rejected because the queue was full
+    uint32_t high_water;       // Largest number of operations waiting at once
+    uint32_t transitions_lost; // Transitions overwritten before they were taken
+    uint32_t stack_free;       // Smallest free stack of the worker task so far (bytes)
+} led_worker_stats_t;
+
+// Configure the LED GPIO, create the queue and start the worker task
+void led_worker_init(void);
+
+// Enqueue an operation without blocking; returns false if it was dropped
+bool led_worker_submit(const led_op_t *op);
+
+// Current LED level (0=OFF, 1=ON)
+int led_worker_state(void);
+
+// Number of LED level changes since boot (compare to detect new transitions)
+uint32_t led_worker_change_count(void);
+
+// Latency stamps (see latency.h) of the most recent LED transition
+void led_worker_last_change(uint32_t *dispatch, uint32_t *gpio);
+
+// Take the oldest transition not yet taken; returns false if there is none
+bool led_worker_take_transition(led_transition_t *transition);
+
+// Copy the worker counters
+void led_worker_get_stats(led_worker_stats_t *stats);
@@ -5,18 +5,17 @@
 // Include ESP32 FreeRTOS headers
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/event_groups.h"
 
 // Include ESP32 drivers
 #include "driver/gpio.h"
 #include "esp_log.h"
 #include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_netif.h"
 #include "nvs_flash.h"
 
-// Include ESP32 WiFi components
-#include "esp_wifi.h"
-#include "esp_event.h"
-#include "esp_netif.h"
+// Include the shared Wi-Fi link (cached AP, fast reconnect, unbounded retry)
+#include "wifi_link.h"
 
 // Include micro-ROS headers
 #include <rcl/rcl.h>
@@ -24,226 +23,366 @@
 #include <rclc/rclc.h>
 #include <rclc/executor.h>
 #include <rmw_microros/rmw_microros.h>
+#include <uxr/client/config.h>
 
 // Include ROS 2 message types
 #include <std_msgs/msg/bool.h>
 #include <std_msgs/msg/string.h>
 #include <std_msgs/msg/int32.h>
+#include <esp32_interfaces/msg/led_op_batch.h>
+#include <esp32_interfaces/msg/led_state.h>
+#include <esp32_interfaces/msg/probe_stats_batch.h>
+
+// Include the LED worker (GPIO is driven outside the executor)
+#include "led_worker.h"
+
+// Include the static pool allocator used for all micro-ROS memory
+#include "uros_allocator.h"
+
+// Include latency histograms for the command path
+#include "latency.h"
+
+// Include agent time synchronization
+#include "time_sync.h"
+
+// Include agent discovery and the NVS agent cache
+#include "agent_finder.h"
+
+// Include per-phase boot timestamps
+#include "boot_timeline.h"
+
+// Include cycle counters (LED queue and GPIO paths)
+#include "perf_counter.h"
+
+// Include CPU load, stack and heap telemetry
+#include "telemetry.h"
+
+// Include the binary event trace and this node's event IDs
+#include "trace_ring.h"
+#include "trace_ids.h"
+
+// Include deferred logging
+#include "dlog.h"
+
+// Include static or dynamic task creation (RTOS allocation profile)
+#include "rtos_alloc.h"
+
+// Include the ICMP link-quality probe engine
+#include "icmp_probe.h"
 
 // WiFi Configuration - CHANGE THESE TO YOUR NETWORK
 #define WIFI_SSID "ssid"
 #define WIFI_PASS "pass"
 
-// micro-ROS Agent Configuration
-#define AGENT_IP "192.168.1.2" // IP address of your ROS 2 machine running micro-ROS agent
-#define AGENT_PORT 8888
-
-// LED GPIO Configuration
-#define LED_GPIO 2 // Onboard LED on most ESP32 boards
-
-// WiFi connection bits
-#define WIFI_CONNECTED_BIT BIT0
-#define WIFI_FAIL_BIT BIT1
+// micro-ROS Agent Configuration (see Kconfig.projbuild)
+// Tried after the cached agent and before multicast discovery (agent_finder.h)
+#define AGENT_IP CONFIG_MICROROS_LED_AGENT_IP
+#define AGENT_PORT CONFIG_MICROROS_LED_AGENT_PORT
+
+// /led_status publishing (see Kconfig.projbuild)
+// The status timer runs at the maximum rate; it publishes only when the LED
+// changed since the last publish, or when the heartbeat interval has passed.
+#define STATUS_PERIOD_MS (1000 / CONFIG_MICROROS_LED_STATUS_MAX_RATE_HZ)
+#define STATUS_HEARTBEAT_MS CONFIG_MICROROS_LED_STATUS_HEARTBEAT_MS
+
+// Agent time re-synchronization (see Kconfig.projbuild)
+#define TIME_SYNC_PERIOD_MS CONFIG_MICROROS_LED_TIME_SYNC_PERIOD_MS
+#define TIME_SYNC_TIMEOUT_MS 50 // Longest time a sync may block the executor
+
+// /led_diagnostics publishing period (see Kconfig.projbuild)
+#define DIAG_PERIOD_MS CONFIG_MICROROS_LED_DIAG_PERIOD_MS
+
+// UDP port on the agent host that receives trace dumps (see Kconfig.projbuild)
+#define TRACE_UDP_PORT CONFIG_MICROROS_LED_TRACE_UDP_PORT
+
+// ICMP probes published on /probe_stats (see Kconfig.projbuild)
+#define PROBE_INTERVAL_MS CONFIG_MICROROS_LED_PROBE_INTERVAL_MS
+#define PROBE_WINDOW_MS CONFIG_MICROROS_LED_PROBE_WINDOW_MS
+#define PROBE_STATS_MAX 4 // Must match the ProbeStats[<=4] bound in ProbeStatsBatch.msg
+#define PROBE_TARGETS_MAX ICMP_PROBE_MAX_TARGETS
+
+_Static_assert(PROBE_TARGETS_MAX <= PROBE_STATS_MAX, "ICMP_PROBE_MAX_TARGETS exceeds the ProbeStats[<=4] bound");
+_Static_assert(PROBE_INTERVAL_MS > CONFIG_ICMP_PROBE_TIMEOUT_MS,
+               "MICROROS_LED_PROBE_INTERVAL_MS must be longer than ICMP_PROBE_TIMEOUT_MS");
+
+// Size of the /telemetry text buffer, including the '\0' (about 45 bytes per task)
+#define TELEMETRY_TEXT_MAX 1024
+
+// Size of the /led_diagnostics text buffer, including the '\0'
+// Larger than one frame: the reliable stream fragments it.
+#define DIAG_TEXT_MAX 1024
+
+// Longest time the executor blocks waiting for the agent before looping
+// The wait returns as soon as the transport has data; it also bounds how
+// late an agent liveness check can run.
+#define EXECUTOR_WAIT_MS 200
+
+// micro-ROS task placement (see Kconfig.projbuild)
+#if CONFIG_MICROROS_LED_UROS_TASK_CORE < 0
+#define UROS_TASK_CORE tskNO_AFFINITY
+#else
+#define UROS_TASK_CORE CONFIG_MICROROS_LED_UROS_TASK_CORE
+#endif
+
+// Agent liveness (see Kconfig.projbuild)
+#define AGENT_PING_PERIOD_MS CONFIG_MICROROS_LED_AGENT_PING_PERIOD_MS
+#define AGENT_PING_MISSES 3        // Consecutive failed pings that mean the agent is gone
+#define AGENT_PROBE_TIMEOUT_MS 100 // Timeout of a single ping
+#define AGENT_BACKOFF_MIN_MS 100   // First pause after a failed search
+#define AGENT_BACKOFF_MAX_MS 4000  // Pauses double up to this
 
 // Log tag
 static const char *TAG = "MICROROS_LED";
 
-// Global variables
-static EventGroupHandle_t s_wifi_event_group;
-static int s_retry_num = 0;
-static int led_state = 0;
-
-// micro-ROS variables
-rcl_subscription_t led_control_subscriber;
-rcl_subscription_t led_command_subscriber;
-rcl_publisher_t led_status_publisher;
-std_msgs__msg__Bool led_control_msg;
-std_msgs__msg__String led_command_msg;
-std_msgs__msg__Bool led_status_msg;
-std_msgs__msg__Int32 led_blink_subscriber;
-rcl_subscription_t blink_subscriber;
-
-// Function prototypes
-void led_init(void);
-void led_on(void);
-void led_off(void);
-void led_toggle(void);
-void led_blink(int times, int delay_ms);
+// Size of the /led_command string buffer, including the '\0'
+#define LED_COMMAND_MAX 64
+
+// /led_batch limits
+#define LED_BATCH_MAX 32            // Must match the LedOp[<=32] bound in LedOpBatch.msg
+#define LED_BATCH_PIN_MASK 0x1      // Pin mask bits the worker drives (bit 0 = LED_GPIO)
+#define LED_BLINK_PERIOD_MS 200     // Default blink half-period
+#define LED_BLINK_PERIOD_MAX_MS 5000
+
+// Topic QoS (see Kconfig.projbuild): true = best effort, false = reliable
+#ifdef CONFIG_MICROROS_LED_CONTROL_BEST_EFFORT
+#define QOS_CONTROL_BEST_EFFORT true
+#else
+#define QOS_CONTROL_BEST_EFFORT false
+#endif
+#ifdef CONFIG_MICROROS_LED_COMMAND_BEST_EFFORT
+#define QOS_COMMAND_BEST_EFFORT true
+#else
+#define QOS_COMMAND_BEST_EFFORT false
+#endif
+#ifdef CONFIG_MICROROS_LED_BLINK_BEST_EFFORT
+#define QOS_BLINK_BEST_EFFORT true
+#else
+#define QOS_BLINK_BEST_EFFORT false
+#endif
+#ifdef CONFIG_MICROROS_LED_BATCH_BEST_EFFORT
+#define QOS_BATCH_BEST_EFFORT true
+#else
+#define QOS_BATCH_BEST_EFFORT false
+#endif
+#ifdef CONFIG_MICROROS_LED_STATUS_BEST_EFFORT
+#define QOS_STATUS_BEST_EFFORT true
+#else
+#define QOS_STATUS_BEST_EFFORT false
+#endif
+#ifdef CONFIG_MICROROS_LED_STATE_BEST_EFFORT
+#define QOS_STATE_BEST_EFFORT true
+#else
+#define QOS_STATE_BEST_EFFORT false
+#endif
+#ifdef CONFIG_MICROROS_LED_PROBE_BEST_EFFORT
+#define QOS_PROBE_BEST_EFFORT true
+#else
+#define QOS_PROBE_BEST_EFFORT false
+#endif
+
+// Largest serialized /led_batch: encapsulation (4) + sequence length (4) + 12 per LedOp
+#define LED_BATCH_CDR_MAX (4 + 4 + LED_BATCH_MAX * 12)
+
+// XRCE-DDS message header (8), submessage header (4) and WRITE_DATA request (4)
+#define XRCE_WRITE_OVERHEAD 16
+
+// Best-effort streams do not fragment: a full batch must fit in one frame
+_Static_assert(LED_BATCH_CDR_MAX + XRCE_WRITE_OVERHEAD <= UXR_CONFIG_UDP_TRANSPORT_MTU,
+               "LED_BATCH_MAX operations do not fit in one UDP transport frame");
+
+// led_batch_callback() passes LedOp.op to the worker unchanged
+_Static_assert(LED_OP_ON == esp32_interfaces__msg__LedOp__ON, "led_op_code_t must match LedOp.msg");
+_Static_assert(LED_OP_OFF == esp32_interfaces__msg__LedOp__OFF, "led_op_code_t must match LedOp.msg");
+_Static_assert(LED_OP_TOGGLE == esp32_interfaces__msg__LedOp__TOGGLE, "led_op_code_t must match LedOp.msg");
+_Static_assert(LED_OP_BLINK == esp32_interfaces__msg__LedOp__BLINK, "led_op_code_t must match LedOp.msg");
+
+// Largest serialized /probe_stats: encapsulation (4) + stamp (8) + window (4)
+// + sequence length (4) + 24 per ProbeStats
+#define PROBE_BATCH_CDR_MAX (4 + 8 + 4 + 4 + PROBE_STATS_MAX * 24)
+
+_Static_assert(PROBE_BATCH_CDR_MAX + XRCE_WRITE_OVERHEAD <= UXR_CONFIG_UDP_TRANSPORT_MTU,
+               "PROBE_STATS_MAX targets do not fit in one UDP transport frame");
+
+// micro-ROS entities and message storage (static, nothing on the heap)
+static rcl_subscription_t led_control_subscriber;
+static rcl_subscription_t led_command_subscriber;
+static rcl_publisher_t led_status_publisher;
+static std_msgs__msg__Bool led_control_msg;
+static std_msgs__msg__String led_command_msg;
+static char led_command_buffer[LED_COMMAND_MAX];
+static std_msgs__msg__Bool led_status_msg;
+static std_msgs__msg__Int32 led_blink_subscriber;
+static rcl_subscription_t blink_subscriber;
+static rcl_timer_t led_status_timer;
+static rcl_publisher_t diagnostics_publisher;
+static std_msgs__msg__String diagnostics_msg;
+static char diagnostics_buffer[DIAG_TEXT_MAX];
+static rcl_timer_t diagnostics_timer;
+static rcl_publisher_t led_state_publisher;
+static esp32_interfaces__msg__LedState led_state_msg;
+static rcl_timer_t time_sync_timer;
+static rcl_subscription_t led_batch_subscriber;
+static esp32_interfaces__msg__LedOpBatch led_batch_msg;
+static esp32_interfaces__msg__LedOp led_batch_ops[LED_BATCH_MAX];
+static uint32_t batch_ops_rejected; // Batch operations skipped as invalid
+static rcl_publisher_t telemetry_publisher;
+static std_msgs__msg__String telemetry_msg;
+static char telemetry_buffer[TELEMETRY_TEXT_MAX];
+static rcl_timer_t telemetry_timer;
+static rcl_publisher_t probe_stats_publisher;
+static esp32_interfaces__msg__ProbeStatsBatch probe_stats_msg;
+static esp32_interfaces__msg__ProbeStats probe_stats_targets[PROBE_STATS_MAX];
+static rcl_timer_t probe_timer;
+
+// micro-ROS support objects (recreated after every agent outage)
+static rcl_allocator_t allocator;
+static rcl_init_options_t init_options; // Carries the agent address
+static agent_address_t agent_address;   // Agent the session is opened with
+static rclc_support_t support;
+static rcl_node_t node;
+static rclc_executor_t executor;
+
+// Agent connection state
+typedef enum
+{
+    AGENT_WAITING,      // No agent: probing
+    AGENT_AVAILABLE,    // Agent answered: create entities
+    AGENT_CONNECTED,    // Entities up: spinning and checking liveness
+    AGENT_DISCONNECTED, // Agent stopped answering: tear down
+} agent_state_t;
+
+// Executor jitter: previous /led_status timer callback (0 = none since connecting)
+static uint32_t last_status_callback;
+
+// Outage statistics
+static uint32_t agent_outages;         // Outages detected since boot
+static uint32_t last_recovery_ms;      // Loss detection -> entities recreated, last outage
+static uint32_t last_outage_lost;      // Messages lost in the last outage
+static int64_t outage_start_ms;        // When the current outage was detected
+static uint32_t publish_failures;      // Failed rcl_publish() calls since boot
+static uint32_t outage_start_failures; // publish_failures when the outage started
+static uint32_t outage_start_lost;     // Worker transitions_lost when the outage started
+
+// Latency stamps of the message being dispatched
+static uint32_t dispatch_stamp;
+static uint32_t callback_stamp;
 
 // ============================================================================
-// LED Control Functions
+// micro-ROS Callback Functions
 // ============================================================================
 
-void led_init(void)
+// Publish and count failures (they show messages lost while the agent is gone)
+static void publish_counted(const rcl_publisher_t *publisher, const void *msg)
 {
-    gpio_reset_pin(LED_GPIO);
-    gpio_set_direction(LED_GPIO, GPIO_MODE_OUTPUT);
-    gpio_set_level(LED_GPIO, 0);
-    led_state = 0;
-    ESP_LOGI(TAG, "LED initialized on GPIO %d", LED_GPIO);
+    if (rcl_publish(publisher, msg, NULL) != RCL_RET_OK)
+    {
+        publish_failures++;
+    }
 }
 
-void led_on(void)
+// Record the start of an agent outage
+static void agent_lost(void)
 {
-    gpio_set_level(LED_GPIO, 1);
-    led_state = 1;
-    ESP_LOGI(TAG, "LED turned ON");
+    led_worker_stats_t queue;
+    led_worker_get_stats(&queue);
+
+    agent_outages++;
+    outage_start_ms = esp_timer_get_time() / 1000;
+    outage_start_failures = publish_failures;
+    outage_start_lost = queue.transitions_lost;
+    ESP_LOGW(TAG, "micro-ROS agent lost, tearing down entities");
 }
 
-void led_off(void)
+// Record the end of an agent outage (entities are up again)
+static void agent_connected(void)
 {
-    gpio_set_level(LED_GPIO, 0);
-    led_state = 0;
-    ESP_LOGI(TAG, "LED turned OFF");
+    agent_finder_remember(&agent_address);
+
+    if (agent_outages == 0)
+    {
+        // Boot metric: time from reset to a usable session
+        ESP_LOGI(TAG, "Connected to micro-ROS agent %s:%s, %lld ms after boot",
+                 agent_address.ip, agent_address.port, (long long)(esp_timer_get_time() / 1000));
+        return;
+    }
+
+    led_worker_stats_t queue;
+    led_worker_get_stats(&queue);
+
+    // Lost = publishes that failed before the loss was detected plus
+    // /led_state transitions overwritten while nothing was published
+    last_recovery_ms = (uint32_t)(esp_timer_get_time() / 1000 - outage_start_ms);
+    last_outage_lost = (publish_failures - outage_start_failures) +
+                       (queue.transitions_lost - outage_start_lost);
+    ESP_LOGI(TAG, "micro-ROS agent back: recovered in %lu ms, %lu messages lost",
+             (unsigned long)last_recovery_ms, (unsigned long)last_outage_lost);
 }
 
-void led_toggle(void)
+// Executor trigger: stamp the dispatch, then run if anything is ready
+static bool dispatch_trigger(rclc_executor_handle_t *handles, unsigned int size, void *obj)
 {
-    led_state = !led_state;
-    gpio_set_level(LED_GPIO, led_state);
-    ESP_LOGI(TAG, "LED toggled to %s", led_state ? "ON" : "OFF");
+    dispatch_stamp = latency_now();
+    return rclc_executor_trigger_any(handles, size, obj);
 }
 
-void led_blink(int times, int delay_ms)
+// Stamp callback entry (first statement of every subscription callback)
+static void stamp_callback_entry(void)
 {
-    ESP_LOGI(TAG, "Blinking LED %d times", times);
-    for (int i = 0; i < times; i++)
+    callback_stamp = latency_now();
+    latency_record(LATENCY_DISPATCH_TO_CALLBACK, dispatch_stamp, callback_stamp);
+
+    // Time-to-first-command closes the boot timeline
+    if (boot_mark(BOOT_FIRST_COMMAND))
     {
-        led_on();
-        vTaskDelay(delay_ms / portTICK_PERIOD_MS);
-        led_off();
-        vTaskDelay(delay_ms / portTICK_PERIOD_MS);
+        boot_log();
     }
 }
 
-// ============================================================================
-// WiFi Event Handler
-// ============================================================================
-
-static void wifi_event_handler(void *arg, esp_event_base_t event_base,
-                               int32_t event_id, void *event_data)
+// Enqueue a simple LED operation for the worker
+static void submit_led_op(led_op_code_t code)
 {
-    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START)
+    led_op_t op = {.code = code, .dispatch = dispatch_stamp, .callback = callback_stamp};
+    if (!led_worker_submit(&op))
     {
-        esp_wifi_connect();
-    }
-    else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED)
-    {
-        if (s_retry_num < 10)
-        {
-            esp_wifi_connect();
-            s_retry_num++;
-            ESP_LOGI(TAG, "Retry to connect to the AP");
-        }
-        else
-        {
-            xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
-        }
-        ESP_LOGI(TAG, "Connect to the AP failed");
-    }
-    else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP)
-    {
-        ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
-        ESP_LOGI(TAG, "Got IP:" IPSTR, IP2STR(&event->ip_info.ip));
-        s_retry_num = 0;
-        xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+        ESP_LOGW(TAG, "LED queue full, operation dropped");
     }
 }
 
-// ============================================================================
-// WiFi Initialization
-// ============================================================================
-
-void wifi_init_sta(void)
+// Enqueue a blink for the worker
+static void submit_blink(int times)
 {
-    s_wifi_event_group = xEventGroupCreate();
-
-    ESP_ERROR_CHECK(esp_netif_init());
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
-    esp_netif_create_default_wifi_sta();
-
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
-
-    esp_event_handler_instance_t instance_any_id;
-    esp_event_handler_instance_t instance_got_ip;
-    ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT,
-                                                        ESP_EVENT_ANY_ID,
-                                                        &wifi_event_handler,
-                                                        NULL,
-                                                        &instance_any_id));
-    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT,
-                                                        IP_EVENT_STA_GOT_IP,
-                                                        &wifi_event_handler,
-                                                        NULL,
-                                                        &instance_got_ip));
-
-    wifi_config_t wifi_config = {
-        .sta = {
-            .ssid = WIFI_SSID,
-            .password = WIFI_PASS,
-            .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-        },
-    };
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
-    ESP_ERROR_CHECK(esp_wifi_start());
-
-    ESP_LOGI(TAG, "wifi_init_sta finished.");
-
-    EventBits_t bits = xEventGroupWaitBits(s_wifi_event_group,
-                                           WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
-                                           pdFALSE,
-                                           pdFALSE,
-                                           portMAX_DELAY);
-
-    if (bits & WIFI_CONNECTED_BIT)
-    {
-        ESP_LOGI(TAG, "Connected to AP SSID:%s", WIFI_SSID);
-    }
-    else if (bits & WIFI_FAIL_BIT)
-    {
-        ESP_LOGI(TAG, "Failed to connect to SSID:%s", WIFI_SSID);
-    }
-    else
+    led_op_t op = {.code = LED_OP_BLINK, .count = times, .period_ms = LED_BLINK_PERIOD_MS,
+                   .dispatch = dispatch_stamp, .callback = callback_stamp};
+    if (!led_worker_submit(&op))
     {
-        ESP_LOGE(TAG, "UNEXPECTED EVENT");
+        ESP_LOGW(TAG, "LED queue full, blink dropped");
     }
 }
 
-// ============================================================================
-// micro-ROS Callback Functions
-// ============================================================================
-
 // Callback for /led_control topic (std_msgs/Bool)
 void led_control_callback(const void *msgin)
 {
+    TRACE_BEGIN(TRACE_ID_LED_CONTROL, 0);
+    stamp_callback_entry();
     const std_msgs__msg__Bool *msg = (const std_msgs__msg__Bool *)msgin;
 
-    if (msg->data)
-    {
-        led_on();
-    }
-    else
-    {
-        led_off();
-    }
-
-    // Publish status update
-    led_status_msg.data = led_state;
-    rcl_publish(&led_status_publisher, &led_status_msg, NULL);
+    submit_led_op(msg->data ? LED_OP_ON : LED_OP_OFF);
+    TRACE_END(TRACE_ID_LED_CONTROL, 0);
 }
 
 // Callback for /led_command topic (std_msgs/String)
 void led_command_callback(const void *msgin)
 {
+    TRACE_BEGIN(TRACE_ID_LED_COMMAND, 0);
+    stamp_callback_entry();
     const std_msgs__msg__String *msg = (const std_msgs__msg__String *)msgin;
 
-    ESP_LOGI(TAG, "Received command: %s", msg->data.data);
+    ESP_LOGD(TAG, "Received command: %s", msg->data.data);
 
     // Convert to uppercase for comparison
     char cmd[64];
     strncpy(cmd, msg->data.data, sizeof(cmd) - 1);
+    cmd[sizeof(cmd) - 1] = '\0';
     for (int i = 0; cmd[i]; i++)
     {
         if (cmd[i] >= 'a' && cmd[i] <= 'z')
@@ -254,15 +393,18 @@ void led_command_callback(const void *msgin)
 
     if (strcmp(cmd, "ON") == 0)
     {
-        led_on();
+        submit_led_op(LED_OP_ON);
+        latency_record(LATENCY_COMMAND_DECODE, callback_stamp, latency_now());
     }
     else if (strcmp(cmd, "OFF") == 0)
     {
-        led_off();
+        submit_led_op(LED_OP_OFF);
+        latency_record(LATENCY_COMMAND_DECODE, callback_stamp, latency_now());
     }
     else if (strcmp(cmd, "TOGGLE") == 0)
     {
-        led_toggle();
+        submit_led_op(LED_OP_TOGGLE);
+        latency_record(LATENCY_COMMAND_DECODE, callback_stamp, latency_now());
     }
     else if (strncmp(cmd, "BLINK", 5) == 0)
     {
@@ -271,21 +413,71 @@ void led_command_callback(const void *msgin)
         {
             sscanf(cmd + 5, "%d", &times);
         }
-        led_blink(times, 200);
+        if (times < 1)
+            times = 1;
+        if (times > 20)
+            times = 20;
+        submit_blink(times);
+        latency_record(LATENCY_COMMAND_DECODE, callback_stamp, latency_now());
+    }
+    else if (strcmp(cmd, "TRACE") == 0)
+    {
+        // Send the trace to the agent host (tools/trace2perfetto.py)
+        if (trace_dump_udp(agent_address.ip, TRACE_UDP_PORT) != ESP_OK)
+        {
+            ESP_LOGW(TAG, "Trace dump to %s:%d failed", agent_address.ip, TRACE_UDP_PORT);
+        }
     }
     else
     {
         ESP_LOGW(TAG, "Unknown command: %s", cmd);
     }
+    TRACE_END(TRACE_ID_LED_COMMAND, 0);
+}
 
-    // Publish status update
-    led_status_msg.data = led_state;
-    rcl_publish(&led_status_publisher, &led_status_msg, NULL);
+// Callback for /led_batch topic (esp32_interfaces/LedOpBatch)
+// Fields are used as received: no copies, no text parsing.
+void led_batch_callback(const void *msgin)
+{
+    TRACE_BEGIN(TRACE_ID_LED_BATCH, 0);
+    stamp_callback_entry();
+    const esp32_interfaces__msg__LedOpBatch *msg = (const esp32_interfaces__msg__LedOpBatch *)msgin;
+
+    for (size_t i = 0; i < msg->ops.size; i++)
+    {
+        const esp32_interfaces__msg__LedOp *in = &msg->ops.data[i];
+
+        // Only the onboard LED exists; operations for other pins are skipped
+        if (in->op > esp32_interfaces__msg__LedOp__BLINK || !(in->pin_mask & LED_BATCH_PIN_MASK))
+        {
+            batch_ops_rejected++;
+            continue;
+        }
+
+        led_op_t op = {.code = in->op, .dispatch = dispatch_stamp, .callback = callback_stamp};
+        if (op.code == LED_OP_BLINK)
+        {
+            op.count = in->count < 1 ? 1 : (in->count > 20 ? 20 : in->count);
+            op.period_ms = in->period_ms == 0 ? LED_BLINK_PERIOD_MS
+                                              : (in->period_ms > LED_BLINK_PERIOD_MAX_MS ? LED_BLINK_PERIOD_MAX_MS
+                                                                                         : in->period_ms);
+        }
+        if (!led_worker_submit(&op))
+        {
+            ESP_LOGW(TAG, "LED queue full, %u batch operations dropped", (unsigned)(msg->ops.size - i));
+            break;
+        }
+    }
+
+    latency_record(LATENCY_BATCH_DECODE, callback_stamp, latency_now());
+    TRACE_END(TRACE_ID_LED_BATCH, msg->ops.size);
 }
 
 // Callback for /led_blink topic (std_msgs/Int32)
 void led_blink_callback(const void *msgin)
 {
+    TRACE_BEGIN(TRACE_ID_LED_BLINK, 0);
+    stamp_callback_entry();
     const std_msgs__msg__Int32 *msg = (const std_msgs__msg__Int32 *)msgin;
 
     int times = msg->data;
@@ -294,115 +486,576 @@ void led_blink_callback(const void *msgin)
     if (times > 20)
         times = 20;
 
-    ESP_LOGI(TAG, "Blink command received: %d times", times);
-    led_blink(times, 200);
+    ESP_LOGD(TAG, "Blink command received: %d times", times);
+    submit_blink(times);
+    TRACE_END(TRACE_ID_LED_BLINK, times);
+}
+
+// Publish every logged LED transition on /led_state with its agent time
+static void publish_transitions(void)
+{
+    led_transition_t transition;
+
+    while (led_worker_take_transition(&transition))
+    {
+        int64_t epoch_ns = time_sync_to_epoch_ns(transition.time_us);
+        led_state_msg.stamp.sec = (int32_t)(epoch_ns / 1000000000);
+        led_state_msg.stamp.nanosec = (uint32_t)(epoch_ns % 1000000000);
+        led_state_msg.state = transition.level;
+        led_state_msg.seq = transition.seq;
+        publish_counted(&led_state_publisher, &led_state_msg);
+    }
+}
+
+// Publish /led_status on change, coalesced, plus a heartbeat
+static void publish_status(void)
+{
+    static uint32_t published_changes = UINT32_MAX; // Forces the first publish
+    static int64_t last_publish_ms = 0;
+
+    // The status timer is the fastest periodic handle, so its period error
+    // shows how late the executor loop gets around to ready work
+    uint32_t now = latency_now();
+    if (last_status_callback != 0)
+    {
+        int32_t error_us = (int32_t)(now - last_status_callback) - STATUS_PERIOD_MS * 1000;
+        latency_record_us(LATENCY_TIMER_JITTER, error_us < 0 ? -error_us : error_us);
+    }
+    last_status_callback = now;
 
-    // Publish status update
-    led_status_msg.data = led_state;
-    rcl_publish(&led_status_publisher, &led_status_msg, NULL);
+    int64_t now_ms = esp_timer_get_time() / 1000;
+    uint32_t changes = led_worker_change_count();
+
+    // Every transition goes out on /led_state, even when /led_status coalesces them
+    publish_transitions();
+
+    // Any number of transitions since the last tick collapse into one message
+    if (changes == published_changes && now_ms - last_publish_ms < STATUS_HEARTBEAT_MS)
+    {
+        return;
+    }
+
+    led_status_msg.data = led_worker_state();
+    if (rcl_publish(&led_status_publisher, &led_status_msg, NULL) != RCL_RET_OK)
+    {
+        publish_failures++;
+    }
+    else
+    {
+        // A change reached subscribers: close its latency measurement
+        if (changes != published_changes)
+        {
+            uint32_t published = latency_now();
+            uint32_t change_dispatch;
+            uint32_t change_gpio;
+            led_worker_last_change(&change_dispatch, &change_gpio);
+
+            latency_record(LATENCY_GPIO_TO_PUBLISH, change_gpio, published);
+            if (change_dispatch != 0)
+            {
+                latency_record(LATENCY_DISPATCH_TO_PUBLISH, change_dispatch, published);
+            }
+        }
+
+        published_changes = changes;
+        last_publish_ms = now_ms;
+    }
+}
+
+// Timer callback: publish /led_status and /led_state
+void led_status_timer_callback(rcl_timer_t *timer, int64_t last_call_time)
+{
+    if (timer == NULL)
+    {
+        return;
+    }
+    TRACE_BEGIN(TRACE_ID_STATUS_TIMER, 0);
+    publish_status();
+    TRACE_END(TRACE_ID_STATUS_TIMER, 0);
+}
+
+// Timer callback: re-synchronize with the agent clock
+void time_sync_timer_callback(rcl_timer_t *timer, int64_t last_call_time)
+{
+    if (timer == NULL)
+    {
+        return;
+    }
+    TRACE_BEGIN(TRACE_ID_SYNC_TIMER, 0);
+    time_sync_update(TIME_SYNC_TIMEOUT_MS);
+    TRACE_END(TRACE_ID_SYNC_TIMER, 0);
+}
+
+// Timer callback: publish latency histograms and counters on /led_diagnostics
+void diagnostics_timer_callback(rcl_timer_t *timer, int64_t last_call_time)
+{
+    if (timer == NULL)
+    {
+        return;
+    }
+
+    TRACE_BEGIN(TRACE_ID_DIAG_TIMER, 0);
+
+    led_worker_stats_t queue;
+    uros_allocator_stats_t memory;
+    time_sync_stats_t clock;
+    wifi_link_stats_t link;
+    led_worker_get_stats(&queue);
+    uros_allocator_get_stats(&memory);
+    time_sync_get_stats(&clock);
+    wifi_link_get_stats(&link);
+
+    size_t len = latency_format(diagnostics_buffer, sizeof(diagnostics_buffer));
+    len += snprintf(diagnostics_buffer + len, sizeof(diagnostics_buffer) - len,
+                    "; queue enq=%lu exec=%lu drop=%lu hw=%lu lost=%lu batch_rej=%lu; alloc peak=%lu/%lu steady=%lu"
+                    "; clock synced=%d offset_ns=%lld drift_ppb=%ld syncs=%lu fails=%lu"
+                    "; agent outages=%lu recovery_ms=%lu lost=%lu pub_fail=%lu"
+                    "; stack uros=%lu led=%lu"
+                    "; wifi assoc_ms=%lu dhcp_ms=%lu fast=%lu scans=%lu drops=%lu",
+                    (unsigned long)queue.enqueued, (unsigned long)queue.executed,
+                    (unsigned long)queue.dropped, (unsigned long)queue.high_water,
+                    (unsigned long)queue.transitions_lost, (unsigned long)batch_ops_rejected,
+                    (unsigned long)memory.bytes_peak, (unsigned long)memory.bytes_total,
+                    (unsigned long)memory.steady_allocations,
+                    clock.synchronized, (long long)clock.offset_ns, (long)clock.drift_ppb,
+                    (unsigned long)clock.syncs, (unsigned long)clock.failures,
+                    (unsigned long)agent_outages, (unsigned long)last_recovery_ms,
+                    (unsigned long)last_outage_lost, (unsigned long)publish_failures,
+                    (unsigned long)uxTaskGetStackHighWaterMark(NULL), (unsigned long)queue.stack_free,
+                    (unsigned long)link.last_assoc_ms, (unsigned long)link.last_dhcp_ms,
+                    (unsigned long)link.fast_connects, (unsigned long)link.full_scans,
+                    (unsigned long)link.disconnects);
+    if (len < sizeof(diagnostics_buffer) - 1)
+    {
+        len += snprintf(diagnostics_buffer + len, sizeof(diagnostics_buffer) - len, "; boot ms ");
+        if (len < sizeof(diagnostics_buffer))
+        {
+            len += boot_format(diagnostics_buffer + len, sizeof(diagnostics_buffer) - len);
+        }
+    }
+    if (len >= sizeof(diagnostics_buffer))
+    {
+        len = sizeof(diagnostics_buffer) - 1; // Truncated
+    }
+
+    diagnostics_msg.data.size = len;
+    publish_counted(&diagnostics_publisher, &diagnostics_msg);
+
+    // Cycle counters go to the console as JSON ("PERF {...}")
+    perf_counter_print_json();
+    TRACE_END(TRACE_ID_DIAG_TIMER, len);
+}
+
+// Timer callback: publish the last CPU, stack and heap sample on /telemetry
+void telemetry_timer_callback(rcl_timer_t *timer, int64_t last_call_time)
+{
+    if (timer == NULL)
+    {
+        return;
+    }
+
+    TRACE_BEGIN(TRACE_ID_TELEM_TIMER, 0);
+    telemetry_msg.data.size = telemetry_format(telemetry_buffer, sizeof(telemetry_buffer));
+    if (telemetry_msg.data.size > 0)
+    {
+        publish_counted(&telemetry_publisher, &telemetry_msg);
+    }
+    TRACE_END(TRACE_ID_TELEM_TIMER, telemetry_msg.data.size);
+}
+
+// Timer callback: publish the probe statistics of the window that just ended
+void probe_timer_callback(rcl_timer_t *timer, int64_t last_call_time)
+{
+    if (timer == NULL)
+    {
+        return;
+    }
+
+    TRACE_BEGIN(TRACE_ID_PROBE_TIMER, 0);
+    icmp_probe_stats_t stats[PROBE_TARGETS_MAX];
+    uint32_t window_ms;
+    int count = icmp_probe_take_window(stats, PROBE_TARGETS_MAX, &window_ms);
+
+    int64_t epoch_ns = time_sync_to_epoch_ns(esp_timer_get_time());
+    probe_stats_msg.stamp.sec = (int32_t)(epoch_ns / 1000000000);
+    probe_stats_msg.stamp.nanosec = (uint32_t)(epoch_ns % 1000000000);
+    probe_stats_msg.window_ms = window_ms;
+    for (int i = 0; i < count; i++)
+    {
+        esp32_interfaces__msg__ProbeStats *target = &probe_stats_targets[i];
+        memcpy(target->address, &stats[i].address, sizeof(target->address)); // Network order
+        target->sent = stats[i].sent;
+        target->received = stats[i].received;
+        target->rtt_min_us = stats[i].rtt_min_us;
+        target->rtt_avg_us = stats[i].rtt_avg_us;
+        target->rtt_max_us = stats[i].rtt_max_us;
+        target->jitter_us = stats[i].jitter_us;
+    }
+    probe_stats_msg.targets.size = count;
+
+    // Nothing to report before probing has started
+    if (count > 0)
+    {
+        publish_counted(&probe_stats_publisher, &probe_stats_msg);
+    }
+    TRACE_END(TRACE_ID_PROBE_TIMER, count);
 }
 
 // ============================================================================
-// micro-ROS Task
+// micro-ROS Entities
 // ============================================================================
 
-void microros_task(void *arg)
+// Return false from the enclosing function if an rcl call fails
+#define RCCHECK(fn)                                                        \
+    {                                                                      \
+        rcl_ret_t temp_rc = fn;                                            \
+        if (temp_rc != RCL_RET_OK)                                         \
+        {                                                                  \
+            ESP_LOGE(TAG, "%s failed: %d (line %d)", #fn, (int)temp_rc, __LINE__); \
+            return false;                                                  \
+        }                                                                  \
+    }
+
+// Create a subscription with reliable or best-effort QoS
+static rcl_ret_t init_subscription(rcl_subscription_t *subscription,
+                                   const rosidl_message_type_support_t *type_support,
+                                   const char *topic, bool best_effort)
 {
-    // Configure micro-ROS transport to WiFi
-    rmw_uros_set_custom_transport(
-        true,
-        (void *)AGENT_IP,
-        (void *)AGENT_PORT,
-        (void *)4,
-        (void *)2);
-
-    // Initialize allocator
-    rcl_allocator_t allocator = rcl_get_default_allocator();
-    rclc_support_t support;
-
-    // Wait for agent to be available
-    ESP_LOGI(TAG, "Waiting for micro-ROS agent...");
-    while (rmw_uros_ping_agent(1000, 10) != RCL_RET_OK)
+    if (best_effort)
     {
-        ESP_LOGI(TAG, "Waiting for agent...");
-        vTaskDelay(1000 / portTICK_PERIOD_MS);
+        return rclc_subscription_init_best_effort(subscription, &node, type_support, topic);
     }
-    ESP_LOGI(TAG, "Connected to micro-ROS agent!");
+    return rclc_subscription_init_default(subscription, &node, type_support, topic);
+}
 
-    // Create init options
-    rclc_support_init(&support, 0, NULL, &allocator);
+// Create a publisher with reliable or best-effort QoS
+static rcl_ret_t init_publisher(rcl_publisher_t *publisher,
+                                const rosidl_message_type_support_t *type_support,
+                                const char *topic, bool best_effort)
+{
+    if (best_effort)
+    {
+        return rclc_publisher_init_best_effort(publisher, &node, type_support, topic);
+    }
+    return rclc_publisher_init_default(publisher, &node, type_support, topic);
+}
+
+// Create support, node, topics, timers and executor
+static bool create_entities(void)
+{
+    // Open the session with the agent found by agent_finder_find()
+    RCCHECK(rclc_support_init_with_options(&support, 0, NULL, &init_options, &allocator));
+
+    // Synchronize with the agent clock before the first transition is stamped
+    time_sync_update(TIME_SYNC_TIMEOUT_MS);
+
+    // Timer period errors are measured from the first callback after connecting
+    last_status_callback = 0;
 
     // Create node
-    rcl_node_t node;
-    rclc_node_init_default(&node, "esp32_led_controller", "", &support);
+    RCCHECK(rclc_node_init_default(&node, "esp32_led_controller", "", &support));
     ESP_LOGI(TAG, "micro-ROS node created");
 
     // Create subscribers
-    rclc_subscription_init_default(
+    RCCHECK(init_subscription(
         &led_control_subscriber,
-        &node,
         ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, Bool),
-        "/led_control");
+        "/led_control",
+        QOS_CONTROL_BEST_EFFORT));
 
-    rclc_subscription_init_default(
+    RCCHECK(init_subscription(
         &led_command_subscriber,
-        &node,
         ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, String),
-        "/led_command");
+        "/led_command",
+        QOS_COMMAND_BEST_EFFORT));
 
-    rclc_subscription_init_default(
+    RCCHECK(init_subscription(
         &blink_subscriber,
-        &node,
         ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, Int32),
-        "/led_blink");
+        "/led_blink",
+        QOS_BLINK_BEST_EFFORT));
+
+    RCCHECK(init_subscription(
+        &led_batch_subscriber,
+        ROSIDL_GET_MSG_TYPE_SUPPORT(esp32_interfaces, msg, LedOpBatch),
+        "/led_batch",
+        QOS_BATCH_BEST_EFFORT));
 
-    // Create publisher
-    rclc_publisher_init_default(
+    // Create publishers
+    RCCHECK(init_publisher(
         &led_status_publisher,
-        &node,
         ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, Bool),
-        "/led_status");
+        "/led_status",
+        QOS_STATUS_BEST_EFFORT));
+
+    RCCHECK(init_publisher(
+        &led_state_publisher,
+        ROSIDL_GET_MSG_TYPE_SUPPORT(esp32_interfaces, msg, LedState),
+        "/led_state",
+        QOS_STATE_BEST_EFFORT));
+
+    // Always reliable: the text is larger than one frame and must be fragmented
+    RCCHECK(rclc_publisher_init_default(
+        &diagnostics_publisher,
+        &node,
+        ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, String),
+        "/led_diagnostics"));
+
+    // Reliable for the same reason
+    RCCHECK(rclc_publisher_init_default(
+        &telemetry_publisher,
+        &node,
+        ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, String),
+        "/telemetry"));
+
+    RCCHECK(init_publisher(
+        &probe_stats_publisher,
+        ROSIDL_GET_MSG_TYPE_SUPPORT(esp32_interfaces, msg, ProbeStatsBatch),
+        "/probe_stats",
+        QOS_PROBE_BEST_EFFORT));
 
     ESP_LOGI(TAG, "Publishers and subscribers created");
 
-    // Initialize message memory
-    led_command_msg.data.data = (char *)malloc(64 * sizeof(char));
-    led_command_msg.data.size = 64;
-    led_command_msg.data.capacity = 64;
+    // Create status timer (publishes /led_status)
+    RCCHECK(rclc_timer_init_default(
+        &led_status_timer,
+        &support,
+        RCL_MS_TO_NS(STATUS_PERIOD_MS),
+        led_status_timer_callback));
+
+    // Create diagnostics timer (publishes /led_diagnostics)
+    RCCHECK(rclc_timer_init_default(
+        &diagnostics_timer,
+        &support,
+        RCL_MS_TO_NS(DIAG_PERIOD_MS),
+        diagnostics_timer_callback));
+
+    // Create telemetry timer (publishes /telemetry at the sampling period)
+    RCCHECK(rclc_timer_init_default(
+        &telemetry_timer,
+        &support,
+        RCL_MS_TO_NS(CONFIG_TELEMETRY_PERIOD_MS),
+        telemetry_timer_callback));
+
+    // Create time sync timer (keeps the agent clock offset fresh)
+    RCCHECK(rclc_timer_init_default(
+        &time_sync_timer,
+        &support,
+        RCL_MS_TO_NS(TIME_SYNC_PERIOD_MS),
+        time_sync_timer_callback));
+
+    // Create probe timer (publishes /probe_stats once per window)
+    RCCHECK(rclc_timer_init_default(
+        &probe_timer,
+        &support,
+        RCL_MS_TO_NS(PROBE_WINDOW_MS),
+        probe_timer_callback));
 
     // Create executor
-    rclc_executor_t executor;
-    rclc_executor_init(&executor, &support.context, 3, &allocator);
-    rclc_executor_add_subscription(&executor, &led_control_subscriber, &led_control_msg,
-                                   &led_control_callback, ON_NEW_DATA);
-    rclc_executor_add_subscription(&executor, &led_command_subscriber, &led_command_msg,
-                                   &led_command_callback, ON_NEW_DATA);
-    rclc_executor_add_subscription(&executor, &blink_subscriber, &led_blink_subscriber,
-                                   &led_blink_callback, ON_NEW_DATA);
+    executor = rclc_executor_get_zero_initialized_executor();
+    RCCHECK(rclc_executor_init(&executor, &support.context, 9, &allocator));
+    RCCHECK(rclc_executor_add_subscription(&executor, &led_control_subscriber, &led_control_msg,
+                                           &led_control_callback, ON_NEW_DATA));
+    RCCHECK(rclc_executor_add_subscription(&executor, &led_command_subscriber, &led_command_msg,
+                                           &led_command_callback, ON_NEW_DATA));
+    RCCHECK(rclc_executor_add_subscription(&executor, &blink_subscriber, &led_blink_subscriber,
+                                           &led_blink_callback, ON_NEW_DATA));
+    RCCHECK(rclc_executor_add_subscription(&executor, &led_batch_subscriber, &led_batch_msg,
+                                           &led_batch_callback, ON_NEW_DATA));
+    RCCHECK(rclc_executor_add_timer(&executor, &led_status_timer));
+    RCCHECK(rclc_executor_add_timer(&executor, &diagnostics_timer));
+    RCCHECK(rclc_executor_add_timer(&executor, &time_sync_timer));
+    RCCHECK(rclc_executor_add_timer(&executor, &telemetry_timer));
+    RCCHECK(rclc_executor_add_timer(&executor, &probe_timer));
+    RCCHECK(rclc_executor_set_trigger(&executor, dispatch_trigger, NULL));
+
+    // Build the wait set now; otherwise the first spin_some() allocates it
+    // after the allocator has entered steady state
+    RCCHECK(rclc_executor_prepare(&executor));
 
     ESP_LOGI(TAG, "Executor initialized. Ready to receive commands!");
+    return true;
+}
 
-    // Publish initial status
-    led_status_msg.data = led_state;
-    rcl_publish(&led_status_publisher, &led_status_msg, NULL);
+// Destroy everything create_entities() made (also after a partial creation)
+static void destroy_entities(void)
+{
+    // The agent may be gone: do not wait for it to confirm each deletion
+    rmw_context_t *rmw_context = rcl_context_get_rmw_context(&support.context);
+    if (rmw_context != NULL)
+    {
+        (void)rmw_uros_set_context_entity_destroy_session_timeout(rmw_context, 0);
+    }
 
-    // Spin executor
-    while (1)
+    (void)rclc_executor_fini(&executor);
+    (void)rcl_timer_fini(&led_status_timer);
+    (void)rcl_timer_fini(&diagnostics_timer);
+    (void)rcl_timer_fini(&time_sync_timer);
+    (void)rcl_timer_fini(&telemetry_timer);
+    (void)rcl_timer_fini(&probe_timer);
+    (void)rcl_subscription_fini(&led_control_subscriber, &node);
+    (void)rcl_subscription_fini(&led_command_subscriber, &node);
+    (void)rcl_subscription_fini(&blink_subscriber, &node);
+    (void)rcl_subscription_fini(&led_batch_subscriber, &node);
+    (void)rcl_publisher_fini(&led_status_publisher, &node);
+    (void)rcl_publisher_fini(&diagnostics_publisher, &node);
+    (void)rcl_publisher_fini(&led_state_publisher, &node);
+    (void)rcl_publisher_fini(&telemetry_publisher, &node);
+    (void)rcl_publisher_fini(&probe_stats_publisher, &node);
+    (void)rcl_node_fini(&node);
+    (void)rclc_support_fini(&support);
+}
+
+// ============================================================================
+// micro-ROS Task
+// ============================================================================
+
+// Start the ICMP probes (configured targets, or the Wi-Fi gateway)
+static void start_probes(void)
+{
+    uint32_t addresses[PROBE_TARGETS_MAX];
+    int count = icmp_probe_parse_targets(CONFIG_MICROROS_LED_PROBE_TARGETS, addresses, PROBE_TARGETS_MAX);
+
+    if (count == 0)
+    {
+        esp_netif_ip_info_t ip_info;
+        esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+        if (netif == NULL || esp_netif_get_ip_info(netif, &ip_info) != ESP_OK || ip_info.gw.addr == 0)
+        {
+            ESP_LOGW(TAG, "No probe targets and no gateway, /probe_stats disabled");
+            return;
+        }
+        addresses[count++] = ip_info.gw.addr;
+    }
+
+    if (icmp_probe_start(addresses, count, PROBE_INTERVAL_MS) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to start ICMP probes");
+    }
+}
+
+void microros_task(void *arg)
+{
+    agent_state_t state = AGENT_WAITING;
+    int64_t last_ping_ms = 0;
+    int ping_failures = 0;
+    int backoff_ms = AGENT_BACKOFF_MIN_MS;
+
+    // Initialize allocator (static pools, installed as the rcutils default)
+    allocator = uros_allocator_init();
+
+    // Init options live for the whole task; only the agent address changes
+    init_options = rcl_get_zero_initialized_init_options();
+    if (rcl_init_options_init(&init_options, allocator) != RCL_RET_OK)
     {
-        rclc_executor_spin_some(&executor, RCL_MS_TO_NS(100));
-        vTaskDelay(10 / portTICK_PERIOD_MS);
+        ESP_LOGE(TAG, "Failed to create micro-ROS init options");
+        vTaskDelete(NULL);
+        return;
     }
+    rmw_init_options_t *rmw_options = rcl_init_options_get_rmw_init_options(&init_options);
+
+    // Initialize message memory (kept across reconnections)
+    led_command_msg.data.data = led_command_buffer;
+    led_command_msg.data.size = 0;
+    led_command_msg.data.capacity = LED_COMMAND_MAX;
+    diagnostics_msg.data.data = diagnostics_buffer;
+    diagnostics_msg.data.size = 0;
+    diagnostics_msg.data.capacity = DIAG_TEXT_MAX;
+    telemetry_msg.data.data = telemetry_buffer;
+    telemetry_msg.data.size = 0;
+    telemetry_msg.data.capacity = TELEMETRY_TEXT_MAX;
+    led_batch_msg.ops.data = led_batch_ops;
+    led_batch_msg.ops.size = 0;
+    led_batch_msg.ops.capacity = LED_BATCH_MAX;
+    probe_stats_msg.targets.data = probe_stats_targets;
+    probe_stats_msg.targets.size = 0;
+    probe_stats_msg.targets.capacity = PROBE_STATS_MAX;
+    boot_mark(BOOT_UROS_PREPARED);
+
+    // Everything above ran while Wi-Fi was associating; now the network is needed
+    wifi_link_wait_up(portMAX_DELAY);
+    boot_mark(BOOT_WIFI_CONNECTED);
+
+    // Probing runs whether or not an agent is connected; /probe_stats
+    // reports the windows that end while one is
+    start_probes();
 
-    // Cleanup (will never reach here)
-    rcl_subscription_fini(&led_control_subscriber, &node);
-    rcl_subscription_fini(&led_command_subscriber, &node);
-    rcl_subscription_fini(&blink_subscriber, &node);
-    rcl_publisher_fini(&led_status_publisher, &node);
-    rcl_node_fini(&node);
-    rclc_support_fini(&support);
-    free(led_command_msg.data.data);
+    ESP_LOGI(TAG, "Waiting for micro-ROS agent...");
+
+    // Connection state machine
+    while (1)
+    {
+        int64_t now_ms = esp_timer_get_time() / 1000;
 
-    vTaskDelete(NULL);
+        switch (state)
+        {
+        case AGENT_WAITING:
+            // Short probes; back off exponentially while nothing answers
+            if (agent_finder_find(rmw_options, &agent_address))
+            {
+                boot_mark(BOOT_AGENT_FOUND);
+                backoff_ms = AGENT_BACKOFF_MIN_MS;
+                state = AGENT_AVAILABLE;
+            }
+            else
+            {
+                ESP_LOGD(TAG, "No agent found, retrying in %d ms", backoff_ms);
+                vTaskDelay(backoff_ms / portTICK_PERIOD_MS);
+                backoff_ms = backoff_ms * 2 > AGENT_BACKOFF_MAX_MS ? AGENT_BACKOFF_MAX_MS : backoff_ms * 2;
+            }
+            break;
+
+        case AGENT_AVAILABLE:
+            uros_allocator_set_steady(false);
+            if (create_entities())
+            {
+                // From here on the allocator counts every allocation; there should be none
+                uros_allocator_set_steady(true);
+                boot_mark(BOOT_ENTITIES_READY);
+                agent_connected();
+                last_ping_ms = now_ms;
+                ping_failures = 0;
+                state = AGENT_CONNECTED;
+            }
+            else
+            {
+                destroy_entities();
+                state = AGENT_WAITING;
+            }
+            break;
+
+        case AGENT_CONNECTED:
+            // Liveness check; a few misses in a row are needed to declare loss
+            if (now_ms - last_ping_ms >= AGENT_PING_PERIOD_MS)
+            {
+                last_ping_ms = now_ms;
+                if (rmw_uros_ping_agent(AGENT_PROBE_TIMEOUT_MS, 1) == RMW_RET_OK)
+                {
+                    ping_failures = 0;
+                }
+                else if (++ping_failures >= AGENT_PING_MISSES)
+                {
+                    state = AGENT_DISCONNECTED;
+                    break;
+                }
+            }
+
+            // spin_some() blocks in rmw_wait() on the XRCE session until the
+            // transport delivers data (or the timeout expires) and dispatches
+            // immediately, so no extra sleep is needed
+            TRACE_BEGIN(TRACE_ID_SPIN, 0);
+            rclc_executor_spin_some(&executor, RCL_MS_TO_NS(EXECUTOR_WAIT_MS));
+            TRACE_END(TRACE_ID_SPIN, 0);
+            break;
+
+        case AGENT_DISCONNECTED:
+            agent_lost();
+            uros_allocator_set_steady(false);
+            destroy_entities();
+            state = AGENT_WAITING;
+            break;
+        }
+    }
 }
 
 // ============================================================================
@@ -411,6 +1064,8 @@ void microros_task(void *arg)
 
 void app_main(void)
 {
+    boot_mark(BOOT_APP_MAIN);
+
     // Initialize NVS (required for WiFi)
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND)
@@ -419,6 +1074,7 @@ void app_main(void)
         ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK(ret);
+    boot_mark(BOOT_NVS_READY);
 
     // Print startup banner
     printf("\n\n");
@@ -432,21 +1088,44 @@ void app_main(void)
     printf("Compiled: %s %s\n", __DATE__, __TIME__);
     printf("========================================\n\n");
 
-    // Initialize LED
-    led_init();
-
-    // Initialize WiFi
+    // Start the task that prints deferred log messages (LED worker)
+    ESP_ERROR_CHECK(dlog_start());
+
+    // Initialize LED and start the LED worker task
+    led_worker_init();
+
+    // Start sampling CPU load, stacks and heap (published on /telemetry)
+    ESP_ERROR_CHECK(telemetry_start());
+
+    // Name the trace events for the dump
+    trace_name(TRACE_ID_SPIN, "spin_some");
+    trace_name(TRACE_ID_LED_CONTROL, "led_control_cb");
+    trace_name(TRACE_ID_LED_COMMAND, "led_command_cb");
+    trace_name(TRACE_ID_LED_BLINK, "led_blink_cb");
+    trace_name(TRACE_ID_LED_BATCH, "led_batch_cb");
+    trace_name(TRACE_ID_STATUS_TIMER, "status_timer");
+    trace_name(TRACE_ID_DIAG_TIMER, "diagnostics_timer");
+    trace_name(TRACE_ID_SYNC_TIMER, "time_sync_timer");
+    trace_name(TRACE_ID_TELEM_TIMER, "telemetry_timer");
+    trace_name(TRACE_ID_PROBE_TIMER, "probe_timer");
+    trace_name(TRACE_ID_LED_SUBMIT, "led_submit");
+    trace_name(TRACE_ID_LED_SET, "led_set");
+
+    // Start WiFi; association continues in the background
     ESP_LOGI(TAG, "Initializing WiFi...");
-    wifi_init_sta();
+    ESP_ERROR_CHECK(wifi_link_start(WIFI_SSID, WIFI_PASS));
+    boot_mark(BOOT_WIFI_STARTED);
 
-    // Create micro-ROS task
+    // Create micro-ROS task right away: it prepares micro-ROS memory while
+    // WiFi associates and waits for the connection only before the agent search
     ESP_LOGI(TAG, "Starting micro-ROS task...");
-    xTaskCreate(microros_task,
-                "microros_task",
-                8192,
-                NULL,
-                5,
-                NULL);
+    RTOS_TASK_CREATE_PINNED(microros_task,
+                            "microros_task",
+                            CONFIG_MICROROS_LED_UROS_TASK_STACK,
+                            NULL,
+                            CONFIG_MICROROS_LED_UROS_TASK_PRIORITY,
+                            NULL,
+                            UROS_TASK_CORE);
 
     ESP_LOGI(TAG, "System initialized successfully!");
 }
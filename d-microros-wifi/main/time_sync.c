@@ -0,0 +1,65 @@
+// Include the time sync interface
+#include "time_sync.h"
+
+// Include ESP32 high resolution timer and logging
+#include "esp_timer.h"
+#include "esp_log.h"
+
+// Include micro-ROS utilities (session time sync)
+#include <rmw_microros/rmw_microros.h>
+
+// Log tag
+static const char *TAG = "TIME_SYNC";
+
+// Drift is only estimated from syncs at least this far apart
+#define MIN_DRIFT_INTERVAL_US (10 * 1000 * 1000)
+
+static time_sync_stats_t stats;
+static int64_t last_sync_local_us; // esp_timer time of the last successful sync
+
+bool time_sync_update(int timeout_ms)
+{
+    if (rmw_uros_sync_session(timeout_ms) != RMW_RET_OK || !rmw_uros_epoch_synchronized())
+    {
+        stats.failures++;
+        ESP_LOGW(TAG, "Time sync with agent failed (%lu failures)", (unsigned long)stats.failures);
+        return false;
+    }
+
+    int64_t epoch_ns = rmw_uros_epoch_nanos();
+    int64_t local_us = esp_timer_get_time();
+    int64_t offset_ns = epoch_ns - local_us * 1000;
+
+    // Drift: offset change (ns) per second of local time, scaled to ppb
+    int64_t elapsed_us = local_us - last_sync_local_us;
+    if (stats.synchronized && elapsed_us >= MIN_DRIFT_INTERVAL_US)
+    {
+        stats.drift_ppb = (int32_t)((offset_ns - stats.offset_ns) * 1000000 / elapsed_us);
+    }
+
+    stats.offset_ns = offset_ns;
+    stats.synchronized = true;
+    stats.syncs++;
+    last_sync_local_us = local_us;
+
+    ESP_LOGD(TAG, "Synced: offset %lld ns, drift %ld ppb",
+             (long long)stats.offset_ns, (long)stats.drift_ppb);
+    return true;
+}
+
+int64_t time_sync_to_epoch_ns(int64_t local_us)
+{
+    if (!stats.synchronized)
+    {
+        return 0;
+    }
+
+    // Offset at the last sync, corrected for the drift since then
+    int64_t since_sync_us = local_us - last_sync_local_us;
+    return local_us * 1000 + stats.offset_ns + since_sync_us * stats.drift_ppb / 1000000;
+}
+
+void time_sync_get_stats(time_sync_stats_t *out)
+{
+    *out = stats;
+}
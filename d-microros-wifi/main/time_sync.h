@@ -0,0 +1,33 @@
+// Agent time synchronization
+//
+// rmw_uros_sync_session() gives the agent's epoch time. The offset between
+// that epoch and esp_timer is kept here and refreshed periodically; the
+// change of the offset between two syncs gives the drift of the local
+// clock. Local timestamps (e.g. of GPIO writes) are converted to agent time
+// with the last offset plus the drift accumulated since that sync.
+
+#pragma once
+
+// Include standard integer and boolean types
+#include <stdbool.h>
+#include <stdint.h>
+
+// Synchronization metrics
+typedef struct
+{
+    bool synchronized;   // At least one sync succeeded
+    int64_t offset_ns;   // Agent epoch minus local time at the last sync
+    int32_t drift_ppb;   // Local clock drift against the agent (parts per billion)
+    uint32_t syncs;      // Successful syncs
+    uint32_t failures;   // Failed sync attempts
+} time_sync_stats_t;
+
+// Synchronize with the agent (blocks up to timeout_ms); returns true on success
+bool time_sync_update(int timeout_ms);
+
+// Convert a local esp_timer time (us) to agent epoch nanoseconds
+// Returns 0 before the first successful sync.
+int64_t time_sync_to_epoch_ns(int64_t local_us);
+
+// Copy the synchronization metrics
+void time_sync_get_stats(time_sync_stats_t *stats);
@@ -0,0 +1,24 @@
+// Trace event IDs
+//
+// Events recorded with TRACE_BEGIN/END/INSTANT (trace_ring.h) by the
+// executor, its callbacks and the LED worker. Names for the host tool are
+// registered in app_main; "TRACE" on /led_command sends the dump to
+// CONFIG_MICROROS_LED_TRACE_UDP_PORT on the agent host.
+
+#pragma once
+
+typedef enum
+{
+    TRACE_ID_SPIN = 1,      // rclc_executor_spin_some(), including the wait
+    TRACE_ID_LED_CONTROL,   // /led_control callback
+    TRACE_ID_LED_COMMAND,   // /led_command callback
+    TRACE_ID_LED_BLINK,     // /led_blink callback
+    TRACE_ID_LED_BATCH,     // /led_batch callback, arg = operations
+    TRACE_ID_STATUS_TIMER,  // /led_status timer
+    TRACE_ID_DIAG_TIMER,    // /led_diagnostics timer
+    TRACE_ID_SYNC_TIMER,    // Time sync timer
+    TRACE_ID_TELEM_TIMER,   // /telemetry timer
+    TRACE_ID_PROBE_TIMER,   // /probe_stats timer, arg = targets
+    TRACE_ID_LED_SUBMIT,    // Operation queued for the worker, arg = op code
+    TRACE_ID_LED_SET,       // Worker GPIO write, arg = level
+} trace_id_t;
@@ -0,0 +1,268 @@
+// Include the allocator interface
+#include "uros_allocator.h"
+
+// Include standard libraries
+#include <stdlib.h>
+#include <string.h>
+
+// Include ESP32 FreeRTOS headers for critical sections
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Include ESP32 logging
+#include "esp_log.h"
+
+// Log tag
+static const char *TAG = "UROS_ALLOC";
+
+// Pool table: block size in bytes, number of blocks
+// Sized for what create_entities() allocates: support context, node, four
+// subscriptions, five publishers, five timers and an executor with nine
+// handles plus its wait set. The counts are the per-pool peaks of the replay
+// in host_test/test_uros_allocator.c with a quarter to spare; the 512-byte
+// blocks take rcl structures that outgrow 256 bytes in other releases.
+// Entering steady state logs the peaks on the board: re-derive the counts
+// from them when entities change, and raise one if exhaustion is reported.
+#define UROS_POOL_TABLE(X) \
+    X(32, 48)              \
+    X(64, 24)              \
+    X(128, 16)             \
+    X(256, 16)             \
+    X(512, 10)             \
+    X(1024, 2)             \
+    X(2048, 1)
+
+#define POOL_ENTRY(size, count) {size, count, NULL, NULL, 0, 0},
+#define POOL_BYTES(size, count) +(size) * (count)
+
+// One pool of equally sized blocks
+typedef struct
+{
+    uint16_t block_size; // Bytes per block (multiple of 8)
+    uint16_t count;      // Number of blocks
+    uint8_t *base;       // First block inside the arena
+    void *free_list;     // Free blocks, linked through their first word
+    uint16_t in_use;     // Blocks handed out
+    uint16_t peak;       // Largest in_use seen
+} pool_t;
+
+static pool_t pools[] = {UROS_POOL_TABLE(POOL_ENTRY)};
+#define POOL_COUNT (sizeof(pools) / sizeof(pools[0]))
+
+// Backing storage for all pools
+static uint8_t arena[0 UROS_POOL_TABLE(POOL_BYTES)] __attribute__((aligned(8)));
+
+// Statistics and lock
+static uros_allocator_stats_t stats;
+static int steady = 0;
+static portMUX_TYPE pool_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// ============================================================================
+// Pool Operations
+// ============================================================================
+
+// Find the pool a block belongs to, or NULL if it is not from the arena
+static pool_t *pool_of(void *pointer)
+{
+    uint8_t *p = (uint8_t *)pointer;
+    for (size_t i = 0; i < POOL_COUNT; i++)
+    {
+        if (p >= pools[i].base && p < pools[i].base + pools[i].block_size * pools[i].count)
+        {
+            return &pools[i];
+        }
+    }
+    return NULL;
+}
+
+// Log pool usage (when a request cannot be served and on entering steady state)
+static void log_pools(esp_log_level_t level)
+{
+    for (size_t i = 0; i < POOL_COUNT; i++)
+    {
+        ESP_LOG_LEVEL(level, TAG, "  %4u-byte blocks: %u/%u in use, peak %u",
+                      pools[i].block_size, pools[i].in_use, pools[i].count, pools[i].peak);
+    }
+}
+
+static void *pool_allocate(size_t size, void *state)
+{
+    void *block = NULL;
+    int warn_steady = 0;
+
+    taskENTER_CRITICAL(&pool_lock);
+    for (size_t i = 0; i < POOL_COUNT && block == NULL; i++)
+    {
+        pool_t *pool = &pools[i];
+        if (size > pool->block_size || pool->free_list == NULL)
+        {
+            continue; // Too small or empty, try the next size up
+        }
+
+        block = pool->free_list;
+        pool->free_list = *(void **)block;
+        if (++pool->in_use > pool->peak)
+        {
+            pool->peak = pool->in_use;
+        }
+
+        stats.bytes_in_use += pool->block_size;
+        if (stats.bytes_in_use > stats.bytes_peak)
+        {
+            stats.bytes_peak = stats.bytes_in_use;
+        }
+        stats.allocations++;
+        if (steady)
+        {
+            warn_steady = (stats.steady_allocations++ == 0);
+        }
+    }
+    taskEXIT_CRITICAL(&pool_lock);
+
+    // Fail fast: an exhausted pool is a sizing bug, not a runtime condition
+    if (block == NULL)
+    {
+        ESP_LOGE(TAG, "Out of pool memory for %u bytes", (unsigned)size);
+        log_pools(ESP_LOG_ERROR);
+        abort();
+    }
+
+    if (warn_steady)
+    {
+        ESP_LOGW(TAG, "Allocation of %u bytes in steady state", (unsigned)size);
+    }
+    return block;
+}
+
+static void pool_deallocate(void *pointer, void *state)
+{
+    pool_t *pool = pool_of(pointer);
+    if (pool == NULL)
+    {
+        return; // NULL or not ours
+    }
+
+    taskENTER_CRITICAL(&pool_lock);
+    *(void **)pointer = pool->free_list;
+    pool->free_list = pointer;
+    pool->in_use--;
+    stats.bytes_in_use -= pool->block_size;
+    taskEXIT_CRITICAL(&pool_lock);
+}
+
+static void *pool_reallocate(void *pointer, size_t size, void *state)
+{
+    if (pointer == NULL)
+    {
+        return pool_allocate(size, state);
+    }
+
+    pool_t *pool = pool_of(pointer);
+    if (pool == NULL)
+    {
+        ESP_LOGE(TAG, "Reallocate of a block not from the pools");
+        return NULL;
+    }
+    if (size <= pool->block_size)
+    {
+        return pointer; // Still fits in the same block
+    }
+
+    void *block = pool_allocate(size, state);
+    memcpy(block, pointer, pool->block_size);
+    pool_deallocate(pointer, state);
+    return block;
+}
+
+static void *pool_zero_allocate(size_t count, size_t size, void *state)
+{
+    if (size != 0 && count > SIZE_MAX / size)
+    {
+        return NULL;
+    }
+
+    void *block = pool_allocate(count * size, state);
+    memset(block, 0, count * size);
+    return block;
+}
+
+// ============================================================================
+// Public Interface
+// ============================================================================
+
+rcutils_allocator_t uros_allocator_init(void)
+{
+    // Carve the arena into pools and thread each pool's free list
+    uint8_t *next = arena;
+    for (size_t i = 0; i < POOL_COUNT; i++)
+    {
+        pool_t *pool = &pools[i];
+        pool->base = next;
+        pool->free_list = NULL;
+        pool->in_use = 0;
+        pool->peak = 0;
+        for (int b = pool->count - 1; b >= 0; b--)
+        {
+            void *block = pool->base + b * pool->block_size;
+            *(void **)block = pool->free_list;
+            pool->free_list = block;
+        }
+        next += pool->block_size * pool->count;
+    }
+    memset(&stats, 0, sizeof(stats));
+    stats.bytes_total = sizeof(arena);
+
+    rcutils_allocator_t allocator = rcutils_get_zero_initialized_allocator();
+    allocator.allocate = pool_allocate;
+    allocator.deallocate = pool_deallocate;
+    allocator.reallocate = pool_reallocate;
+    allocator.zero_allocate = pool_zero_allocate;
+    allocator.state = NULL;
+
+    // Make it the default so allocations inside rcl/rclc use the pools too
+    if (!rcutils_set_default_allocator(&allocator))
+    {
+        ESP_LOGE(TAG, "Failed to install pool allocator");
+        abort();
+    }
+
+    ESP_LOGI(TAG, "Pool allocator ready, %u bytes", (unsigned)sizeof(arena));
+    return allocator;
+}
+
+void uros_allocator_set_steady(bool is_steady)
+{
+    taskENTER_CRITICAL(&pool_lock);
+    steady = is_steady;
+    taskEXIT_CRITICAL(&pool_lock);
+
+    if (is_steady)
+    {
+        ESP_LOGI(TAG, "Steady state: %u of %u bytes in use, peak %u",
+                 (unsigned)stats.bytes_in_use, (unsigned)stats.bytes_total, (unsigned)stats.bytes_peak);
+        log_pools(ESP_LOG_INFO);
+    }
+}
+
+void uros_allocator_get_stats(uros_allocator_stats_t *out)
+{
+    taskENTER_CRITICAL(&pool_lock);
+    *out = stats;
+    taskEXIT_CRITICAL(&pool_lock);
+}
+
+bool uros_allocator_get_pool(size_t index, uros_pool_stats_t *pool)
+{
+    if (index >= POOL_COUNT)
+    {
+        return false;
+    }
+
+    taskENTER_CRITICAL(&pool_lock);
+    pool->block_size = pools[index].block_size;
+    pool->count = pools[index].count;
+    pool->in_use = pools[index].in_use;
+    pool->peak = pools[index].peak;
+    taskEXIT_CRITICAL(&pool_lock);
+    return true;
+}
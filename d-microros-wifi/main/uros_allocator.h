@@ -0,0 +1,54 @@
+// Static pool allocator for micro-ROS
+//
+// All rcl/rclc/rmw allocations are served from fixed-size block pools in
+// static memory instead of the system heap. Each request takes the smallest
+// block that fits. Running out of blocks is a configuration error, so the
+// allocator logs the request and the pool usage and aborts instead of
+// letting rcl fail somewhere later.
+//
+// While the node is up, uros_allocator_set_steady(true) makes the allocator
+// count allocations; in steady state that counter is expected to stay at zero.
+// Entering steady state logs the peak of every pool, which is what the pool
+// table in uros_allocator.c is sized from.
+
+#pragma once
+
+// Include standard integer, size and boolean types
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Include the rcutils allocator type used by rcl
+#include <rcutils/allocator.h>
+
+// Allocator statistics
+typedef struct
+{
+    uint32_t bytes_in_use;       // Block bytes currently handed out
+    uint32_t bytes_peak;         // Largest bytes_in_use seen
+    uint32_t bytes_total;        // Size of all pools together
+    uint32_t allocations;        // Successful allocations since boot
+    uint32_t steady_allocations; // Allocations made while in steady state
+} uros_allocator_stats_t;
+
+// Usage of one block pool
+typedef struct
+{
+    uint16_t block_size; // Bytes per block
+    uint16_t count;      // Blocks in the pool
+    uint16_t in_use;     // Blocks handed out
+    uint16_t peak;       // Largest in_use seen
+} uros_pool_stats_t;
+
+// Install the pool allocator as the rcutils default and return it
+rcutils_allocator_t uros_allocator_init(void);
+
+// Enter or leave steady state (entity setup and teardown are not steady)
+void uros_allocator_set_steady(bool is_steady);
+
+// Copy the allocator statistics
+void uros_allocator_get_stats(uros_allocator_stats_t *stats);
+
+// Copy the usage of pool index (smallest blocks first)
+// Returns false when index is past the last pool.
+bool uros_allocator_get_pool(size_t index, uros_pool_stats_t *pool);
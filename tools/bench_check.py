@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""Check benchmark results against per-target thresholds.
+
+Reads the BENCH {json} lines printed by the Unity benchmark suite in bench/
+(Linux target, QEMU or a board) and by c-serial-connect's host bench_console,
+and compares each result's ops_per_s with the minimum in a thresholds file:
+
+    {"esp32": {"gpio_toggle": {"min_ops_per_s": 1500000}, ...},
+     "linux": {...}, "host": {...}}
+
+Results are looked up under their "target" field, or under --section (use
+"qemu" for a QEMU run, whose cycle counts are not the board's). Fails when
+a result is below its minimum, a benchmark listed for the section did not
+report, or the Unity summary shows failures:
+
+    build/bench.elf | tee bench.log
+    tools/bench_check.py bench.log --thresholds bench/bench_thresholds.json
+
+--update writes the measured rates times --margin back as the new minimums
+(after a run on the reference machine; review the diff).
+"""
+
+import argparse
+import json
+import re
+import sys
+
+UNITY_SUMMARY = re.compile(r"(\d+) Tests (\d+) Failures (\d+) Ignored")
+
+
+def read_log(path):
+    """Return the BENCH records and the Unity failure count (None if no summary)."""
+    records = []
+    failures = None
+    stream = sys.stdin if path == "-" else open(path, errors="replace")
+    with stream:
+        for line in stream:
+            position = line.find("BENCH {")
+            if position >= 0:
+                try:
+                    records.append(json.loads(line[position + len("BENCH "):]))
+                except ValueError:
+                    print(f"{path}: bad BENCH line: {line.strip()}", file=sys.stderr)
+                continue
+            match = UNITY_SUMMARY.search(line)
+            if match:
+                failures = (failures or 0) + int(match.group(2))
+    return records, failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("logs", nargs="+", help="log files with BENCH lines ('-' for stdin)")
+    parser.add_argument("--thresholds", required=True, help="thresholds JSON file")
+    parser.add_argument("--section", help="thresholds section to use instead of each result's target")
+    parser.add_argument("--update", action="store_true", help="store measured rates times --margin as minimums")
+    parser.add_argument("--margin", type=float, default=0.75, help="fraction of the measured rate kept by --update")
+    args = parser.parse_args()
+
+    with open(args.thresholds) as f:
+        thresholds = json.load(f)
+
+    results = {}
+    unity_failures = 0
+    for path in args.logs:
+        records, failures = read_log(path)
+        unity_failures += failures or 0
+        for record in records:
+            section = args.section or record.get("target", "host")
+            results.setdefault(section, {})[record["name"]] = record
+
+    if not results:
+        print("no BENCH lines found", file=sys.stderr)
+        return 1
+
+    if args.update:
+        for section, records in results.items():
+            limits = thresholds.setdefault(section, {})
+            for name, record in records.items():
+                limits[name] = {"min_ops_per_s": int(record["ops_per_s"] * args.margin)}
+        with open(args.thresholds, "w") as f:
+            json.dump(thresholds, f, indent=2)
+            f.write("\n")
+        print(f"updated {args.thresholds}")
+        return 0
+
+    failed = 0
+    for section, records in sorted(results.items()):
+        limits = thresholds.get(section)
+        if limits is None:
+            print(f"{section}: no thresholds, not checked")
+            continue
+        for name, limit in sorted(limits.items()):
+            minimum = limit["min_ops_per_s"]
+            record = records.get(name)
+            if record is None:
+                print(f"FAIL {section}/{name}: did not report")
+                failed += 1
+            elif record["ops_per_s"] < minimum:
+                print(f"FAIL {section}/{name}: {record['ops_per_s']:.0f} ops/s < {minimum}")
+                failed += 1
+            else:
+                print(f"ok   {section}/{name}: {record['ops_per_s']:.0f} ops/s >= {minimum}")
+
+    if unity_failures:
+        print(f"FAIL {unity_failures} Unity test(s) failed")
+        failed += 1
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
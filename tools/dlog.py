@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+"""Deferred log (components/dlog) format table extraction and decoding.
+
+extract: read the DLOG* call site descriptors from a firmware ELF and
+write them as JSON. dlog_extract_table() in a project's CMakeLists.txt runs
+this after every build, producing build/dlog_table.json.
+
+    tools/dlog.py extract build/ping_example.elf -o build/dlog_table.json
+
+decode: format the "DLOG <hex words>" lines printed with
+CONFIG_DLOG_OUTPUT_BINARY; other lines pass through unchanged.
+
+    idf.py monitor | tools/dlog.py decode build/dlog_table.json
+    tools/dlog.py decode build/dlog_table.json serial.log --elf build/ping_example.elf
+
+String arguments are printed as addresses unless --elf is given.
+"""
+
+import argparse
+import json
+import re
+import struct
+import sys
+
+DESCRIPTOR = struct.Struct("<IIHBB")  # format, tag address, line, level, nargs
+DESCRIPTOR_SYMBOL = "_dlog_format"
+LEVELS = "NEWIDV"
+SPEC = re.compile(r"%%|%[-+ #0]*\d*(?:\.\d+)?[hlLqjzt]*[diouxXcsfFeEgGp]")
+
+SHT_PROGBITS = 1
+SHT_SYMTAB = 2
+SHF_ALLOC = 2
+
+
+class Elf:
+    """Just enough of a 32-bit little-endian ELF reader for the descriptors."""
+
+    def __init__(self, path):
+        with open(path, "rb") as stream:
+            self.data = stream.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1 or self.data[5] != 1:
+            raise ValueError(f"{path}: not a 32-bit little-endian ELF")
+        shoff, = struct.unpack_from("<I", self.data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2E)
+        self.sections = [struct.unpack_from("<IIIIIIIIII", self.data, shoff + i * shentsize)
+                         for i in range(shnum)]
+
+    def symbols(self):
+        for section in self.sections:
+            if section[1] != SHT_SYMTAB:
+                continue
+            strtab = self.sections[section[6]]
+            for offset in range(section[4], section[4] + section[5], 16):
+                name, value, size, _, _, _ = struct.unpack_from("<IIIBBH", self.data, offset)
+                yield self.cstring_at(strtab[4] + name), value, size
+
+    def cstring_at(self, offset):
+        end = self.data.index(b"\0", offset)
+        return self.data[offset:end].decode("utf-8", "replace")
+
+    def offset_of(self, address):
+        for _, kind, flags, addr, offset, size, *_ in self.sections:
+            if kind == SHT_PROGBITS and flags & SHF_ALLOC and addr <= address < addr + size:
+                return offset + address - addr
+        return None
+
+    def read(self, address, layout):
+        offset = self.offset_of(address)
+        return None if offset is None else layout.unpack_from(self.data, offset)
+
+    def string(self, address):
+        offset = self.offset_of(address)
+        return None if offset is None else self.cstring_at(offset)
+
+
+def extract(options):
+    elf = Elf(options.elf)
+    formats = {}
+    for name, address, size in elf.symbols():
+        # Function-scope statics are named "_dlog_format" or "_dlog_format.<n>"
+        if name.split(".")[0] != DESCRIPTOR_SYMBOL or size != DESCRIPTOR.size:
+            continue
+        format_address, tag_address, line, level, nargs = elf.read(address, DESCRIPTOR)
+        tag_pointer = elf.read(tag_address, struct.Struct("<I"))
+        formats[f"0x{address:08x}"] = {
+            "format": elf.string(format_address),
+            "tag": elf.string(tag_pointer[0]) if tag_pointer else None,
+            "line": line,
+            "level": LEVELS[level] if level < len(LEVELS) else "?",
+            "nargs": nargs,
+        }
+
+    table = {"elf": options.elf, "formats": formats}
+    with open(options.output, "w") if options.output else sys.stdout as output:
+        json.dump(table, output, indent=1, sort_keys=True)
+        output.write("\n")
+    print(f"{len(formats)} deferred log formats", file=sys.stderr)
+
+
+def format_record(entry, args, elf):
+    values = iter(args)
+
+    def convert(match):
+        spec = match.group(0)
+        if spec == "%%":
+            return "%"
+        value = next(values, None)
+        if value is None:
+            return spec
+        conversion = re.sub(r"[hlLqjzt]", "", spec)
+        letter = conversion[-1]
+        if letter in "di":
+            return conversion % (value - (1 << 32) if value & 0x80000000 else value)
+        if letter in "fFeEgG":
+            return conversion % struct.unpack("<f", struct.pack("<I", value))[0]
+        if letter == "s":
+            text = elf.string(value) if elf else None
+            return conversion % (text if text is not None else f"<0x{value:08x}>")
+        if letter == "p":
+            return f"0x{value:08x}"
+        if letter == "c":
+            return chr(value & 0xFF)
+        return conversion.replace("u", "d") % value
+
+    return SPEC.sub(convert, entry["format"])
+
+
+def decode(options):
+    with open(options.table) as stream:
+        formats = json.load(stream)["formats"]
+    elf = Elf(options.elf) if options.elf else None
+
+    for path in options.input or ["-"]:
+        stream = sys.stdin if path == "-" else open(path, errors="replace")
+        with stream:
+            for text in stream:
+                start = text.find("DLOG ")
+                if start < 0:
+                    sys.stdout.write(text)
+                    continue
+                try:
+                    words = [int(word, 16) for word in text[start + 5:].split()]
+                    entry = formats[f"0x{words[1]:08x}"]
+                except (ValueError, IndexError, KeyError):
+                    sys.stdout.write(text)  # Not a record or from another build
+                    continue
+                message = format_record(entry, words[2:2 + entry["nargs"]], elf)
+                print(f"{entry['level']} ({words[0]}) {entry['tag']}: {message}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    extract_parser = commands.add_parser("extract", help="write the format table of an ELF")
+    extract_parser.add_argument("elf")
+    extract_parser.add_argument("-o", "--output", help="JSON file (default: stdout)")
+    extract_parser.set_defaults(run=extract)
+
+    decode_parser = commands.add_parser("decode", help="format DLOG lines of a log")
+    decode_parser.add_argument("table", help="dlog_table.json from the build")
+    decode_parser.add_argument("input", nargs="*", help="log files (default: stdin)")
+    decode_parser.add_argument("--elf", help="ELF to resolve string arguments")
+    decode_parser.set_defaults(run=decode)
+
+    options = parser.parse_args()
+    options.run(options)
+
+
+if __name__ == "__main__":
+    main()
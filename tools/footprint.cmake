@@ -0,0 +1,41 @@
+# Footprint report target: idf.py footprint
+# Include after project() and call footprint_target(); the budget is
+# footprint_budget.json next to the project's CMakeLists.txt, or
+# footprint_budget.static.json with CONFIG_RTOS_ALLOC_STATIC (task stacks
+# and control blocks are static RAM there) if the project has one.
+# idf.py footprint-baseline writes the profile's file from the current
+# build plus 15% headroom, with entries for main and the shared components.
+set(FOOTPRINT_TOOL ${CMAKE_CURRENT_LIST_DIR}/footprint.py)
+set(FOOTPRINT_SHARED_DIR ${CMAKE_CURRENT_LIST_DIR}/../components)
+
+function(footprint_target)
+    idf_build_get_property(build_dir BUILD_DIR)
+    idf_build_get_property(python PYTHON)
+    set(budget ${CMAKE_SOURCE_DIR}/footprint_budget.json)
+    set(baseline ${budget})
+    if(CONFIG_RTOS_ALLOC_STATIC)
+        set(baseline ${CMAKE_SOURCE_DIR}/footprint_budget.static.json)
+        if(EXISTS ${baseline})
+            set(budget ${baseline})
+        endif()
+    endif()
+
+    add_custom_target(footprint
+        COMMAND ${python} ${FOOTPRINT_TOOL} ${build_dir}/${CMAKE_PROJECT_NAME}.map
+                --budget ${budget}
+                --json ${build_dir}/footprint.json
+        DEPENDS ${CMAKE_PROJECT_NAME}.elf
+        COMMENT "Static RAM, IRAM and flash per component"
+        USES_TERMINAL
+        VERBATIM)
+
+    file(GLOB shared RELATIVE ${FOOTPRINT_SHARED_DIR} ${FOOTPRINT_SHARED_DIR}/*)
+    add_custom_target(footprint-baseline
+        COMMAND ${python} ${FOOTPRINT_TOOL} ${build_dir}/${CMAKE_PROJECT_NAME}.map
+                --baseline ${baseline}
+                --components main ${shared}
+        DEPENDS ${CMAKE_PROJECT_NAME}.elf
+        COMMENT "Footprint budget from this build plus headroom"
+        USES_TERMINAL
+        VERBATIM)
+endfunction()
@@ -0,0 +1,189 @@
+#!/usr/bin/env python3
+"""Per-component static RAM, IRAM and flash footprint from a linker map.
+
+Reads the GNU ld map file ESP-IDF writes next to the ELF and sums the input
+sections of each component (archive) by memory region:
+
+    dram   .dram0.*   static data and bss (internal data RAM)
+    iram   .iram0.*   code and data placed in instruction RAM
+    flash  .flash.*   code and read-only data run from flash
+
+Initialized .dram0.data and IRAM contents are also stored in flash; they are
+only counted under their RAM region. With --budget the report fails (exit
+status 1) when the total or a component exceeds its budget:
+
+    {"total": {"dram": 120000, "iram": 131072, "flash": 1048576},
+     "components": {"main": {"dram": 40000}}}
+
+The footprint target (tools/footprint.cmake) runs this after the build:
+
+    idf.py footprint
+
+--baseline rewrites the budget from the build instead: each total and each
+component given with --components gets its measured size plus --headroom
+percent, rounded up to 256 bytes (idf.py footprint-baseline).
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+REGIONS = ("dram", "iram", "flash")
+OUTPUT_SECTION = re.compile(r"^(\S+)")
+INPUT_SECTION = re.compile(r"^ (\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+(.+))?$")
+INPUT_NAME = re.compile(r"^ (\S+)$")
+INPUT_CONTINUATION = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.+)$")
+
+
+def region_of(output_section):
+    # Dummy and noload sections only reserve address space
+    if "dummy" in output_section or "noload" in output_section:
+        return None
+    if output_section.startswith(".dram0") or output_section == ".noinit":
+        return "dram"
+    if output_section.startswith(".iram0"):
+        return "iram"
+    if output_section.startswith(".flash"):
+        return "flash"
+    return None
+
+
+def component_of(path):
+    """libmain.a(x.c.obj) -> main, .../libgcc.a(y.o) -> libgcc, x.obj -> x.obj"""
+    archive = os.path.basename(path.split("(")[0].strip())
+    if archive.endswith(".a"):
+        name = archive[:-2]
+        # ESP-IDF component archives are esp-idf/<name>/lib<name>.a
+        return name[3:] if name.startswith("lib") and "esp-idf" in path else name
+    return archive or "(fill)"
+
+
+def parse_map(stream):
+    sizes = {}
+    in_memory_map = False
+    output_section = None
+    pending_name = None
+
+    for line in stream:
+        line = line.rstrip("\n")
+        if not in_memory_map:
+            in_memory_map = line.startswith("Linker script and memory map")
+            continue
+
+        if line and not line[0].isspace():
+            output_section = OUTPUT_SECTION.match(line).group(1)
+            pending_name = None
+            continue
+
+        match = INPUT_SECTION.match(line)
+        if match:
+            name, _, size, path = match.groups()
+            pending_name = None
+        else:
+            match = INPUT_NAME.match(line)
+            if match:
+                pending_name = match.group(1)
+                continue
+            match = INPUT_CONTINUATION.match(line)
+            if not match or pending_name is None:
+                continue
+            name, (_, size, path) = pending_name, match.groups()
+            pending_name = None
+
+        region = region_of(output_section or "")
+        size = int(size, 16)
+        if region is None or size == 0 or name.startswith("*(") or name == "LOAD":
+            continue
+        component = "(fill)" if name == "*fill*" or not path else component_of(path)
+        totals = sizes.setdefault(component, dict.fromkeys(REGIONS, 0))
+        totals[region] += size
+
+    if not in_memory_map:
+        raise ValueError("no memory map found (is this a GNU ld map file?)")
+    return sizes
+
+
+def check_budget(sizes, total, budget):
+    failures = []
+    for region, limit in budget.get("total", {}).items():
+        if total[region] > limit:
+            failures.append(f"total {region} {total[region]} > {limit}")
+    for component, limits in budget.get("components", {}).items():
+        used = sizes.get(component, dict.fromkeys(REGIONS, 0))
+        for region, limit in limits.items():
+            if used[region] > limit:
+                failures.append(f"{component} {region} {used[region]} > {limit}")
+    return failures
+
+
+def round_up(size, headroom):
+    return -(-int(size * (100 + headroom) / 100) // 256) * 256
+
+
+def write_baseline(path, sizes, total, components, headroom, map_path):
+    def limits(used):
+        return json.dumps({region: round_up(used[region], headroom) for region in REGIONS})
+
+    # One line per entry, like the hand-written budget files
+    lines = [f' "source": "measured from {os.path.basename(map_path)} plus {headroom}% headroom",',
+             f' "total": {limits(total)},',
+             ' "components": {']
+    entries = [f'  "{component}": {limits(sizes[component])}' for component in components if component in sizes]
+    lines.append(",\n".join(entries))
+    lines.append(" }")
+    with open(path, "w") as output:
+        output.write("{\n" + "\n".join(line for line in lines if line) + "\n}\n")
+    print(f"Wrote {path}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("map", help="linker map file (build/<project>.map)")
+    parser.add_argument("--budget", help="JSON budget file; exceeding it fails")
+    parser.add_argument("--json", help="also write the report as JSON")
+    parser.add_argument("--top", type=int, default=20, help="components listed (default 20)")
+    parser.add_argument("--baseline", help="write this budget file from the build instead of checking")
+    parser.add_argument("--headroom", type=int, default=15, help="percent added by --baseline (default 15)")
+    parser.add_argument("--components", nargs="*", default=["main"],
+                        help="components given their own budget by --baseline (default main)")
+    options = parser.parse_args()
+
+    with open(options.map, errors="replace") as stream:
+        sizes = parse_map(stream)
+    total = {region: sum(used[region] for used in sizes.values()) for region in REGIONS}
+
+    ranked = sorted(sizes.items(), key=lambda item: -sum(item[1].values()))
+    print(f"{'component':<28}{'dram':>10}{'iram':>10}{'flash':>10}")
+    for component, used in ranked[:options.top]:
+        print(f"{component:<28}" + "".join(f"{used[region]:>10}" for region in REGIONS))
+    if len(ranked) > options.top:
+        print(f"... {len(ranked) - options.top} more")
+    print(f"{'total':<28}" + "".join(f"{total[region]:>10}" for region in REGIONS))
+
+    if options.json:
+        with open(options.json, "w") as output:
+            json.dump({"total": total, "components": sizes}, output, indent=1, sort_keys=True)
+            output.write("\n")
+
+    if options.baseline:
+        write_baseline(options.baseline, sizes, total, options.components, options.headroom, options.map)
+        return
+
+    if options.budget:
+        with open(options.budget) as stream:
+            budget = json.load(stream)
+        if budget.get("source", "").startswith("estimate"):
+            print(f"Note: {options.budget} is an estimate, not a measured build; "
+                  "run idf.py footprint-baseline on a reference build", file=sys.stderr)
+        failures = check_budget(sizes, total, budget)
+        for failure in failures:
+            print(f"OVER BUDGET: {failure}", file=sys.stderr)
+        if failures:
+            sys.exit(1)
+        print(f"Within budget ({options.budget})")
+
+
+if __name__ == "__main__":
+    main()
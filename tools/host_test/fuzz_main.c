@@ -0,0 +1,79 @@
+// Corpus runner for fuzz targets built without libFuzzer
+//
+// Runs LLVMFuzzerTestOneInput() once for every file named on the command
+// line; a directory argument runs every regular file in it. Lets ctest
+// replay the seed corpus and past crashes with any compiler.
+
+// Include standard library, input/output and directory access
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+// Run one file; returns 0 on success
+static int run_file(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        perror(path);
+        return 1;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t *data = malloc(size > 0 ? size : 1);
+    size_t len = data != NULL ? fread(data, 1, size, file) : 0;
+    fclose(file);
+    if (data == NULL)
+    {
+        return 1;
+    }
+
+    LLVMFuzzerTestOneInput(data, len);
+    free(data);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int failed = 0;
+    int runs = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        struct stat st;
+        if (stat(argv[i], &st) == 0 && S_ISDIR(st.st_mode))
+        {
+            DIR *dir = opendir(argv[i]);
+            struct dirent *entry;
+            while (dir != NULL && (entry = readdir(dir)) != NULL)
+            {
+                char path[1024];
+                snprintf(path, sizeof(path), "%s/%s", argv[i], entry->d_name);
+                if (stat(path, &st) == 0 && S_ISREG(st.st_mode))
+                {
+                    failed |= run_file(path);
+                    runs++;
+                }
+            }
+            if (dir != NULL)
+            {
+                closedir(dir);
+            }
+        }
+        else
+        {
+            failed |= run_file(argv[i]);
+            runs++;
+        }
+    }
+
+    fprintf(stderr, "Executed %d inputs\n", runs);
+    return failed;
+}
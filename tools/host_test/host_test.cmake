@@ -0,0 +1,41 @@
+# Host test support: ESP-IDF stand-ins for plain CMake test projects
+#
+# A project's host_test/CMakeLists.txt includes this file and links its
+# executables against host_mocks. The project provides its own sdkconfig.h
+# (in the host_test directory) with the CONFIG_* values the sources need.
+#
+#   cmake -S c-serial-connect/host_test -B build/host && cmake --build build/host
+#   ctest --test-dir build/host --output-on-failure
+#
+# See include/host_mock.h for what the stand-ins simulate.
+
+include_guard(GLOBAL)
+
+set(HOST_TEST_DIR ${CMAKE_CURRENT_LIST_DIR})
+set(HOST_COMPONENTS_DIR ${HOST_TEST_DIR}/../../components)
+
+find_package(Threads REQUIRED)
+
+add_library(host_mocks STATIC
+    ${HOST_TEST_DIR}/mock_rtos.c
+    ${HOST_TEST_DIR}/mock_esp.c
+    ${HOST_TEST_DIR}/mock_driver.c)
+target_include_directories(host_mocks PUBLIC ${HOST_TEST_DIR}/include)
+target_link_libraries(host_mocks PUBLIC Threads::Threads)
+
+# Build a fuzz target with libFuzzer (Clang) instead of the corpus runner
+option(HOST_TEST_LIBFUZZER "Link fuzz targets with -fsanitize=fuzzer" OFF)
+
+# host_fuzz_target(<name> <sources...>)
+# The sources define LLVMFuzzerTestOneInput(). Without HOST_TEST_LIBFUZZER
+# the target gets fuzz_main.c, which runs every file given on the command
+# line (or every file in the directories given) through it once.
+function(host_fuzz_target name)
+    add_executable(${name} ${ARGN})
+    if(HOST_TEST_LIBFUZZER)
+        target_compile_options(${name} PRIVATE -fsanitize=fuzzer,address,undefined)
+        target_link_options(${name} PRIVATE -fsanitize=fuzzer,address,undefined)
+    else()
+        target_sources(${name} PRIVATE ${HOST_TEST_DIR}/fuzz_main.c)
+    endif()
+endfunction()
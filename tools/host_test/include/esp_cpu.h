@@ -0,0 +1,12 @@
+// Host stand-in for esp_cpu.h: the "cycle counter" counts nanoseconds
+#pragma once
+
+// Include standard integer types
+#include <stdint.h>
+
+uint32_t esp_cpu_get_cycle_count(void);
+
+static inline int esp_cpu_get_core_id(void)
+{
+    return 0;
+}
@@ -0,0 +1,36 @@
+// Host stand-in for FreeRTOS.h (tasks are pthreads, 100 Hz tick)
+#pragma once
+
+// Include standard integer and boolean types
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint8_t StackType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ 100
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define portNUM_PROCESSORS 1
+#define tskNO_AFFINITY 0x7fffffff
+
+// Critical sections share one recursive lock
+typedef struct
+{
+    int unused;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+
+void host_critical_enter(void);
+void host_critical_exit(void);
+#define taskENTER_CRITICAL(mux) ((void)(mux), host_critical_enter())
+#define taskEXIT_CRITICAL(mux) ((void)(mux), host_critical_exit())
+#define portENTER_CRITICAL(mux) taskENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL(mux) taskEXIT_CRITICAL(mux)
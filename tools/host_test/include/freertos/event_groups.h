@@ -0,0 +1,11 @@
+// Host stand-in for FreeRTOS event_groups.h (types only)
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_event_group *EventGroupHandle_t;
+typedef uint32_t EventBits_t;
+typedef struct
+{
+    int unused;
+} StaticEventGroup_t;
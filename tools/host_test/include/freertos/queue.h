@@ -0,0 +1,10 @@
+// Host stand-in for FreeRTOS queue.h (types only)
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_queue *QueueHandle_t;
+typedef struct
+{
+    int unused;
+} StaticQueue_t;
@@ -0,0 +1,14 @@
+// Host stand-in for FreeRTOS semphr.h (mutexes only)
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_mutex *SemaphoreHandle_t;
+typedef struct
+{
+    int unused;
+} StaticSemaphore_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t timeout);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex);
@@ -0,0 +1,50 @@
+// Host test doubles for the ESP-IDF APIs used by the projects
+//
+// The headers in this directory stand in for the ESP-IDF ones, so project
+// sources compile unchanged on a Linux/macOS host with any C compiler:
+//
+//   FreeRTOS   tasks are pthreads; mutexes, critical sections and task
+//              notifications are real. vTaskDelay() and one-shot esp_timer
+//              waits advance a virtual clock instead of sleeping, so a
+//              replayed BLINK or macro runs in microseconds of real time.
+//   esp_timer  esp_timer_get_time() is the monotonic clock plus the virtual
+//              advance. A one-shot timer fires when a task blocks in
+//              ulTaskNotifyTake() (one waiting task at a time).
+//   GPIO       levels and writes are recorded per pin.
+//   UART       reads come from a byte stream set by the test; when it is
+//              used up the exhausted hook runs (or reads time out).
+//   NVS        an in-memory key/blob store.
+//
+// Functions below let a test drive and inspect them.
+
+#pragma once
+
+// Include standard integer and size types
+#include <stddef.h>
+#include <stdint.h>
+
+// Virtual clock: microseconds added to the monotonic clock
+void host_mock_advance_us(int64_t us);
+
+// UART0 input: the next reads return these bytes
+void host_mock_uart_set_input(const uint8_t *data, size_t len);
+
+// Bytes of the current UART input not read yet
+size_t host_mock_uart_remaining(void);
+
+// At esp_timer time deadline_us the rest of the UART input is replaced by
+// one Ctrl-C, which stops a long macro RUN (0 = no deadline)
+void host_mock_uart_set_deadline(int64_t deadline_us);
+
+// Called when a read finds the UART input used up; a test typically
+// longjmp()s out of the code under test here. NULL: reads time out (and
+// sleep for real, so idle console loops do not spin).
+void host_mock_uart_set_exhausted_hook(void (*hook)(void));
+
+// GPIO level last written and number of writes, per pin
+int host_mock_gpio_level(int pin);
+uint32_t host_mock_gpio_writes(int pin);
+void host_mock_gpio_reset(void);
+
+// Erase all NVS contents
+void host_mock_nvs_reset(void);
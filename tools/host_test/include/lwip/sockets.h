@@ -0,0 +1,29 @@
+// Host stand-in for lwip/sockets.h: the BSD sockets of the host
+// (a program using it should ignore SIGPIPE, which lwIP never raises)
+#pragma once
+
+// Include the host socket API
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// lwIP's default TCP send buffer (TCP_SND_BUF, 4 * MSS); the host's is
+// megabytes, which would hide a client that stops reading
+#define HOST_LWIP_SND_BUF 5744
+
+static inline int host_lwip_accept(int sock, struct sockaddr *addr, socklen_t *addr_len)
+{
+    int client = accept(sock, addr, addr_len);
+    if (client >= 0)
+    {
+        int size = HOST_LWIP_SND_BUF;
+        setsockopt(client, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    }
+    return client;
+}
+#define accept host_lwip_accept
@@ -0,0 +1,8 @@
+// Host stand-in for nvs_flash.h
+#pragma once
+
+// Include the NVS API
+#include "nvs.h"
+
+esp_err_t nvs_flash_init(void);
+esp_err_t nvs_flash_erase(void);
@@ -0,0 +1,304 @@
+// GPIO, UART and NVS stand-ins
+
+// Include the mocked APIs and the mock controls
+#include "driver/gpio.h"
+#include "driver/uart.h"
+#include "nvs_flash.h"
+#include "esp_timer.h"
+#include "host_mock.h"
+
+// Include standard library and string functions
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define HOST_GPIO_COUNT 64
+#define HOST_NVS_ENTRIES 64
+#define HOST_NVS_KEY_MAX 16   // Key and namespace length including '\0', as on the chip
+#define HOST_NVS_BLOB_MAX 4000 // Largest blob in one entry
+#define HOST_NVS_NAMESPACES 8
+
+// Level and write count per pin
+static int gpio_levels[HOST_GPIO_COUNT];
+static uint32_t gpio_writes[HOST_GPIO_COUNT];
+
+// UART0 input
+static const uint8_t *uart_input;
+static size_t uart_input_len;
+static size_t uart_input_pos;
+static int64_t uart_deadline_us;
+static void (*uart_exhausted)(void);
+
+// NVS entries
+static struct
+{
+    int used;
+    nvs_handle_t ns;
+    char key[HOST_NVS_KEY_MAX];
+    size_t length;
+    uint8_t *data;
+} nvs_entries[HOST_NVS_ENTRIES];
+static char nvs_namespaces[HOST_NVS_NAMESPACES][HOST_NVS_KEY_MAX];
+
+esp_err_t gpio_reset_pin(gpio_num_t pin)
+{
+    if (pin < 0 || pin >= HOST_GPIO_COUNT)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    gpio_levels[pin] = 0;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t pin, gpio_mode_t mode)
+{
+    return pin < 0 || pin >= HOST_GPIO_COUNT ? ESP_ERR_INVALID_ARG : ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level)
+{
+    if (pin < 0 || pin >= HOST_GPIO_COUNT)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    gpio_levels[pin] = level != 0;
+    gpio_writes[pin]++;
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t pin)
+{
+    return pin < 0 || pin >= HOST_GPIO_COUNT ? 0 : gpio_levels[pin];
+}
+
+int host_mock_gpio_level(int pin)
+{
+    return gpio_get_level(pin);
+}
+
+uint32_t host_mock_gpio_writes(int pin)
+{
+    return pin < 0 || pin >= HOST_GPIO_COUNT ? 0 : gpio_writes[pin];
+}
+
+void host_mock_gpio_reset(void)
+{
+    memset(gpio_levels, 0, sizeof(gpio_levels));
+    memset(gpio_writes, 0, sizeof(gpio_writes));
+}
+
+void host_mock_uart_set_input(const uint8_t *data, size_t len)
+{
+    uart_input = data;
+    uart_input_len = len;
+    uart_input_pos = 0;
+}
+
+size_t host_mock_uart_remaining(void)
+{
+    return uart_input_len - uart_input_pos;
+}
+
+void host_mock_uart_set_deadline(int64_t deadline_us)
+{
+    uart_deadline_us = deadline_us;
+}
+
+void host_mock_uart_set_exhausted_hook(void (*hook)(void))
+{
+    uart_exhausted = hook;
+}
+
+// Past the deadline only a Ctrl-C is left to read
+static void uart_check_deadline(void)
+{
+    static const uint8_t interrupt = 0x03;
+
+    if (uart_deadline_us != 0 && esp_timer_get_time() >= uart_deadline_us)
+    {
+        uart_deadline_us = 0;
+        host_mock_uart_set_input(&interrupt, 1);
+    }
+}
+
+esp_err_t uart_driver_install(uart_port_t port, int rx_size, int tx_size, int queue_size,
+                              void *queue, int intr_flags)
+{
+    return ESP_OK;
+}
+
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t *config)
+{
+    return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t port, int tx, int rx, int rts, int cts)
+{
+    return ESP_OK;
+}
+
+esp_err_t uart_get_buffered_data_len(uart_port_t port, size_t *size)
+{
+    uart_check_deadline();
+    *size = host_mock_uart_remaining();
+    return ESP_OK;
+}
+
+int uart_read_bytes(uart_port_t port, void *buf, uint32_t length, TickType_t ticks_to_wait)
+{
+    uart_check_deadline();
+
+    size_t available = host_mock_uart_remaining();
+    if (available == 0)
+    {
+        if (uart_exhausted != NULL)
+        {
+            uart_exhausted();
+        }
+        usleep((ticks_to_wait > 0 ? ticks_to_wait : 1) * portTICK_PERIOD_MS * 1000);
+        return 0;
+    }
+
+    size_t len = length < available ? length : available;
+    memcpy(buf, uart_input + uart_input_pos, len);
+    uart_input_pos += len;
+    return (int)len;
+}
+
+int uart_write_bytes(uart_port_t port, const void *src, size_t size)
+{
+    return (int)size; // Output is written through stdout by the callers
+}
+
+esp_err_t nvs_flash_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    host_mock_nvs_reset();
+    return ESP_OK;
+}
+
+void host_mock_nvs_reset(void)
+{
+    for (int i = 0; i < HOST_NVS_ENTRIES; i++)
+    {
+        free(nvs_entries[i].data);
+    }
+    memset(nvs_entries, 0, sizeof(nvs_entries));
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *handle)
+{
+    if (strlen(name) >= HOST_NVS_KEY_MAX)
+    {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    for (int i = 0; i < HOST_NVS_NAMESPACES; i++)
+    {
+        if (nvs_namespaces[i][0] == '\0')
+        {
+            strcpy(nvs_namespaces[i], name);
+        }
+        if (strcmp(nvs_namespaces[i], name) == 0)
+        {
+            *handle = i + 1;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+}
+
+// Entry holding key in namespace handle, or -1
+static int nvs_find(nvs_handle_t handle, const char *key)
+{
+    for (int i = 0; i < HOST_NVS_ENTRIES; i++)
+    {
+        if (nvs_entries[i].used && nvs_entries[i].ns == handle && strcmp(nvs_entries[i].key, key) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    if (strlen(key) >= HOST_NVS_KEY_MAX || length > HOST_NVS_BLOB_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int index = nvs_find(handle, key);
+    for (int i = 0; index < 0 && i < HOST_NVS_ENTRIES; i++)
+    {
+        if (!nvs_entries[i].used)
+        {
+            index = i;
+        }
+    }
+    if (index < 0)
+    {
+        return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+    }
+
+    uint8_t *data = malloc(length > 0 ? length : 1);
+    if (data == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(data, value, length);
+    free(nvs_entries[index].data);
+    nvs_entries[index].used = 1;
+    nvs_entries[index].ns = handle;
+    strcpy(nvs_entries[index].key, key);
+    nvs_entries[index].length = length;
+    nvs_entries[index].data = data;
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *value, size_t *length)
+{
+    int index = nvs_find(handle, key);
+
+    if (index < 0)
+    {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (value == NULL)
+    {
+        *length = nvs_entries[index].length; // Size query
+        return ESP_OK;
+    }
+    if (*length < nvs_entries[index].length)
+    {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(value, nvs_entries[index].data, nvs_entries[index].length);
+    *length = nvs_entries[index].length;
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    int index = nvs_find(handle, key);
+
+    if (index < 0)
+    {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    free(nvs_entries[index].data);
+    memset(&nvs_entries[index], 0, sizeof(nvs_entries[index]));
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    return ESP_OK;
+}
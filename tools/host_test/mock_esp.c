@@ -0,0 +1,76 @@
+// esp_err and esp_log stand-ins
+
+// Include the mocked APIs
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+// Include standard input/output and variable arguments
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code)
+    {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:
+        return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:
+        return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:
+        return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:
+        return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_NVS_NOT_FOUND:
+        return "ESP_ERR_NVS_NOT_FOUND";
+    case ESP_ERR_NVS_NOT_ENOUGH_SPACE:
+        return "ESP_ERR_NVS_NOT_ENOUGH_SPACE";
+    case ESP_ERR_NVS_INVALID_LENGTH:
+        return "ESP_ERR_NVS_INVALID_LENGTH";
+    default:
+        return "UNKNOWN ERROR";
+    }
+}
+
+// Logs go to stderr only when HOST_LOG is set, so transcripts stay clean
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    static const char letters[] = "NEWIDV";
+    static int enabled = -1;
+    va_list args;
+
+    if (enabled < 0)
+    {
+        enabled = getenv("HOST_LOG") != NULL;
+    }
+    if (!enabled)
+    {
+        return;
+    }
+
+    fprintf(stderr, "%c (%u) %s: ", letters[level], (unsigned)esp_log_timestamp(), tag);
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
@@ -0,0 +1,391 @@
+// FreeRTOS and esp_timer stand-ins: pthread tasks on a virtual clock
+
+// Include the mocked APIs and the mock controls
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "host_mock.h"
+
+// Include POSIX threads, clocks and scheduling
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+
+// One task (pthread) and its notification value
+struct host_task
+{
+    pthread_t thread;
+    TaskFunction_t fn;
+    void *arg;
+    const char *name;
+    pthread_mutex_t lock;
+    pthread_cond_t notified;
+    uint32_t notify_count;
+    struct host_task *next;
+};
+
+// One-shot timer
+struct esp_timer
+{
+    esp_timer_cb_t callback;
+    void *arg;
+    int armed;
+    int64_t deadline_us;
+    struct esp_timer *next;
+};
+
+// Mutex
+struct host_mutex
+{
+    pthread_mutex_t lock;
+    struct host_mutex *next;
+};
+
+// Task running on this thread (created on first use for the main thread)
+static __thread struct host_task *current_task;
+
+// Tasks and mutexes that ever existed (never freed: an app creates them once,
+// and a test that restarts app_main() should not look like it leaks them)
+static struct host_task *tasks;
+static struct host_mutex *mutexes;
+static UBaseType_t task_count;
+
+// Microseconds added to the monotonic clock by blocking calls
+static int64_t virtual_offset_us;
+
+// Timers, protected by the critical section lock
+static struct esp_timer *timers;
+
+// Lock behind taskENTER_CRITICAL()
+static pthread_mutex_t critical_lock;
+static pthread_once_t critical_once = PTHREAD_ONCE_INIT;
+
+static int64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void critical_init(void)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&critical_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+void host_critical_enter(void)
+{
+    pthread_once(&critical_once, critical_init);
+    pthread_mutex_lock(&critical_lock);
+}
+
+void host_critical_exit(void)
+{
+    pthread_mutex_unlock(&critical_lock);
+}
+
+void host_mock_advance_us(int64_t us)
+{
+    __atomic_fetch_add(&virtual_offset_us, us, __ATOMIC_RELAXED);
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return monotonic_ns() / 1000 + __atomic_load_n(&virtual_offset_us, __ATOMIC_RELAXED);
+}
+
+uint32_t esp_cpu_get_cycle_count(void)
+{
+    return (uint32_t)monotonic_ns();
+}
+
+// Earliest armed timer, or NULL
+static struct esp_timer *next_timer(void)
+{
+    struct esp_timer *first = NULL;
+
+    host_critical_enter();
+    for (struct esp_timer *timer = timers; timer != NULL; timer = timer->next)
+    {
+        if (timer->armed && (first == NULL || timer->deadline_us < first->deadline_us))
+        {
+            first = timer;
+        }
+    }
+    host_critical_exit();
+    return first;
+}
+
+// Fire a timer, first moving the clock up to its deadline if needed
+static void fire_timer(struct esp_timer *timer)
+{
+    int64_t early = timer->deadline_us - esp_timer_get_time();
+
+    if (early > 0)
+    {
+        host_mock_advance_us(early);
+    }
+    timer->armed = 0;
+    timer->callback(timer->arg);
+}
+
+// Fire every timer that is due
+static void fire_due_timers(void)
+{
+    struct esp_timer *timer;
+
+    while ((timer = next_timer()) != NULL && timer->deadline_us <= esp_timer_get_time())
+    {
+        fire_timer(timer);
+    }
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out)
+{
+    struct esp_timer *timer = calloc(1, sizeof(*timer));
+
+    if (timer == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    timer->callback = args->callback;
+    timer->arg = args->arg;
+
+    host_critical_enter();
+    timer->next = timers;
+    timers = timer;
+    host_critical_exit();
+
+    *out = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    if (timer->armed)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->deadline_us = esp_timer_get_time() + (int64_t)timeout_us;
+    timer->armed = 1;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (!timer->armed)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->armed = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    host_critical_enter();
+    for (struct esp_timer **link = &timers; *link != NULL; link = &(*link)->next)
+    {
+        if (*link == timer)
+        {
+            *link = timer->next;
+            break;
+        }
+    }
+    host_critical_exit();
+    free(timer);
+    return ESP_OK;
+}
+
+static struct host_task *task_new(const char *name)
+{
+    struct host_task *task = calloc(1, sizeof(*task));
+
+    if (task != NULL)
+    {
+        task->name = name;
+        pthread_mutex_init(&task->lock, NULL);
+        pthread_cond_init(&task->notified, NULL);
+
+        host_critical_enter();
+        task->next = tasks;
+        tasks = task;
+        task_count++;
+        host_critical_exit();
+    }
+    return task;
+}
+
+static void *task_entry(void *arg)
+{
+    current_task = arg;
+    current_task->fn(current_task->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_bytes,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *handle, BaseType_t core)
+{
+    struct host_task *task = task_new(name);
+
+    if (task == NULL)
+    {
+        return pdFAIL;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    if (handle != NULL)
+    {
+        *handle = task;
+    }
+    if (pthread_create(&task->thread, NULL, task_entry, task) != 0)
+    {
+        return pdFAIL;
+    }
+    pthread_detach(task->thread);
+    return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    if (current_task == NULL)
+    {
+        current_task = task_new("main");
+        current_task->thread = pthread_self();
+    }
+    return current_task;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    // Only self-deletion is supported
+    if (task == NULL || task == current_task)
+    {
+        pthread_exit(NULL);
+    }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    host_mock_advance_us((int64_t)ticks * portTICK_PERIOD_MS * 1000);
+    fire_due_timers();
+    sched_yield();
+}
+
+void vTaskDelayUntil(TickType_t *previous_wake, TickType_t period)
+{
+    TickType_t now = xTaskGetTickCount();
+
+    *previous_wake += period;
+    if ((int32_t)(*previous_wake - now) > 0)
+    {
+        vTaskDelay(*previous_wake - now);
+    }
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(esp_timer_get_time() / (portTICK_PERIOD_MS * 1000));
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    return 0; // Host threads have large stacks; nothing meaningful to report
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void)
+{
+    host_critical_enter();
+    UBaseType_t count = task_count;
+    host_critical_exit();
+    return count;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->lock);
+    task->notify_count++;
+    pthread_cond_signal(&task->notified);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t timeout)
+{
+    struct host_task *task = xTaskGetCurrentTaskHandle();
+    int64_t until_ns = monotonic_ns() + (int64_t)timeout * portTICK_PERIOD_MS * 1000000LL;
+
+    // A pending one-shot timer fires at once, on the virtual clock
+    struct esp_timer *timer;
+    while (task->notify_count == 0 && (timer = next_timer()) != NULL)
+    {
+        fire_timer(timer);
+    }
+
+    pthread_mutex_lock(&task->lock);
+    while (task->notify_count == 0 && timeout != 0)
+    {
+        if (timeout == portMAX_DELAY)
+        {
+            pthread_cond_wait(&task->notified, &task->lock);
+            continue;
+        }
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        int64_t wait_ns = until_ns - monotonic_ns();
+        if (wait_ns <= 0)
+        {
+            break;
+        }
+        wait_ns += ts.tv_nsec;
+        ts.tv_sec += wait_ns / 1000000000LL;
+        ts.tv_nsec = wait_ns % 1000000000LL;
+        pthread_cond_timedwait(&task->notified, &task->lock, &ts);
+    }
+    uint32_t value = task->notify_count;
+    if (value > 0)
+    {
+        task->notify_count = clear_on_exit ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&task->lock);
+    return value;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    struct host_mutex *mutex = calloc(1, sizeof(*mutex));
+
+    if (mutex != NULL)
+    {
+        pthread_mutex_init(&mutex->lock, NULL);
+
+        host_critical_enter();
+        mutex->next = mutexes;
+        mutexes = mutex;
+        host_critical_exit();
+    }
+    return mutex;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t timeout)
+{
+    // Only "don't wait" and "wait forever" are distinguished
+    if (timeout == 0)
+    {
+        return pthread_mutex_trylock(&mutex->lock) == 0 ? pdTRUE : pdFALSE;
+    }
+    pthread_mutex_lock(&mutex->lock);
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex)
+{
+    pthread_mutex_unlock(&mutex->lock);
+    return pdTRUE;
+}
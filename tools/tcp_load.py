@@ -0,0 +1,234 @@
+#!/usr/bin/env python3
+"""Load test for the c-serial-connect TCP command server.
+
+Opens N connections at once, switches each to tagged mode and keeps a
+window of pipelined "<seq> <command>" lines in flight on every connection,
+checking that each gets its ACK/NACK. Prints one line per client count:
+
+    LOAD {"clients":8,"cmds":16000,"seconds":0.41,"cmds_per_s":39024,
+          "p50_ms":0.19,"p99_ms":0.88,"nacks":0,"dropped":0}
+
+--blink N turns one of the clients into one that sends "BLINK N" one at
+a time for as long as the others run (so it needs at least 2 clients). Commands execute one after another on the board,
+so every blink holds up the other clients; their p99 shows by how much.
+The line then also counts the blink replies ("blink_acks", "blink_nacks":
+a blink longer than the board's TCP command limit is rejected).
+
+Run it against a board (port 3333 by default) or against the host
+stand-in, which --spawn starts and stops:
+
+    tools/tcp_load.py 192.168.1.50 --clients 1,8,32
+    tools/tcp_load.py --spawn build/host/tcp_standin 127.0.0.1
+    tools/tcp_load.py 192.168.1.50 --clients 8 --blink 5
+
+The board needs "Maximum simultaneous clients" at least the largest count.
+Exits with 1 if a reply is missing or a rate is below --min-rate.
+"""
+
+import argparse
+import json
+import socket
+import subprocess
+import sys
+import threading
+import time
+
+COMMANDS = ["ON", "OFF", "TOGGLE", "STATUS"]
+
+
+class Client(threading.Thread):
+    def __init__(self, host, port, commands, window, start):
+        super().__init__(daemon=True)
+        self.sock = socket.create_connection((host, port), timeout=10)
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.commands = commands
+        self.window = window
+        self.start_event = start
+        self.latencies = []
+        self.nacks = 0
+        self.dropped = 0
+        self.error = None
+        self.buffer = b""
+
+    def read_line(self):
+        while b"\n" not in self.buffer:
+            data = self.sock.recv(4096)
+            if not data:
+                raise ConnectionError("connection closed")
+            self.buffer += data
+        line, self.buffer = self.buffer.split(b"\n", 1)
+        return line.decode(errors="replace").strip()
+
+    def enter_tagged_mode(self):
+        self.sock.sendall(b"TAGGED ON\n")
+        while self.read_line() != "Tagged mode ON":
+            pass
+
+    def run(self):
+        try:
+            self.enter_tagged_mode()
+            self.start_event.wait()
+
+            sent = {}
+            next_seq = 1
+            while len(self.latencies) + self.nacks < self.commands:
+                burst = []
+                while next_seq <= self.commands and len(sent) < self.window:
+                    command = COMMANDS[next_seq % len(COMMANDS)]
+                    burst.append(f"{next_seq} {command}\n")
+                    sent[next_seq] = time.perf_counter()
+                    next_seq += 1
+                if burst:
+                    self.sock.sendall("".join(burst).encode())
+
+                fields = self.read_line().split()
+                if not fields:
+                    continue
+                if fields[0].startswith("["):
+                    self.dropped += 1  # "[N reply bytes dropped]"
+                    continue
+                if len(fields) < 2 or fields[0] not in ("ACK", "NACK") or not fields[1].isdigit():
+                    raise ValueError(f"unexpected reply {' '.join(fields)!r}")
+                started = sent.pop(int(fields[1]), None)
+                if started is None:
+                    raise ValueError(f"reply for unknown sequence {fields[1]}")
+                if fields[0] == "ACK":
+                    self.latencies.append(time.perf_counter() - started)
+                else:
+                    self.nacks += 1
+        except (OSError, ValueError) as error:
+            self.error = error
+        finally:
+            self.sock.close()
+
+
+class Blinker(Client):
+    """Sends BLINK <times> and waits for its reply, at least once and until stop is set."""
+
+    def __init__(self, host, port, times, start, stop):
+        super().__init__(host, port, 0, 1, start)
+        self.times = times
+        self.stop = stop
+        self.acks = 0
+        self.sock.settimeout(60)  # BLINK 20 takes 8 s on the board
+
+    def run(self):
+        try:
+            self.enter_tagged_mode()
+            self.start_event.wait()
+            seq = 1
+            while seq == 1 or not self.stop.is_set():  # At least one blink
+                self.sock.sendall(f"{seq} BLINK {self.times}\n".encode())
+                fields = self.read_line().split()
+                if len(fields) < 2 or fields[0] not in ("ACK", "NACK") or fields[1] != str(seq):
+                    raise ValueError(f"unexpected blink reply {' '.join(fields)!r}")
+                if fields[0] == "ACK":
+                    self.acks += 1
+                else:
+                    self.nacks += 1
+                seq += 1
+        except (OSError, ValueError) as error:
+            self.error = error
+        finally:
+            self.sock.close()
+
+
+def percentile(values, fraction):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(fraction * len(values)))]
+
+
+def run_case(options, clients):
+    start = threading.Event()
+    stop = threading.Event()
+    threads = [Client(options.host, options.port, options.commands, options.window, start)
+               for _ in range(clients - 1 if options.blink else clients)]
+    blinker = None
+    if options.blink:
+        blinker = Blinker(options.host, options.port, options.blink, start, stop)
+        blinker.start()
+    for thread in threads:
+        thread.start()
+    time.sleep(0.2)  # Let every connection switch to tagged mode
+
+    began = time.perf_counter()
+    start.set()
+    for thread in threads:
+        thread.join()
+    seconds = time.perf_counter() - began
+    stop.set()
+    if blinker is not None:
+        blinker.join()
+
+    latencies = [value for thread in threads for value in thread.latencies]
+    nacks = sum(thread.nacks for thread in threads)
+    result = {
+        "clients": clients,
+        "cmds": len(latencies) + nacks,
+        "seconds": round(seconds, 3),
+        "cmds_per_s": round((len(latencies) + nacks) / seconds) if seconds > 0 else 0,
+        "p50_ms": round(percentile(latencies, 0.50) * 1000, 3),
+        "p99_ms": round(percentile(latencies, 0.99) * 1000, 3),
+        "nacks": nacks,
+        "dropped": sum(thread.dropped for thread in threads),
+    }
+    if blinker is not None:
+        result["blink_acks"] = blinker.acks
+        result["blink_nacks"] = blinker.nacks
+        threads.append(blinker)
+    errors = [str(thread.error) for thread in threads if thread.error is not None]
+    return result, errors
+
+
+def wait_for_server(host, port, timeout):
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        try:
+            socket.create_connection((host, port), timeout=1).close()
+            return True
+        except OSError:
+            time.sleep(0.05)
+    return False
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("host", help="board or stand-in address")
+    parser.add_argument("--port", type=int, default=3333)
+    parser.add_argument("--clients", default="1,8,32", help="comma-separated client counts")
+    parser.add_argument("--commands", type=int, default=5000, help="commands per client")
+    parser.add_argument("--window", type=int, default=8, help="commands in flight per client")
+    parser.add_argument("--min-rate", type=float, default=0, help="fail below this many cmds/s")
+    parser.add_argument("--blink", type=int, default=0, help="add a client that keeps sending BLINK N")
+    parser.add_argument("--spawn", help="start this stand-in binary first and stop it at the end")
+    options = parser.parse_args()
+    if options.blink and "1" in options.clients.split(","):
+        parser.error("--blink needs at least 2 clients per case")
+
+    process = None
+    if options.spawn:
+        process = subprocess.Popen([options.spawn], stdout=subprocess.DEVNULL)
+    try:
+        if not wait_for_server(options.host, options.port, 10):
+            print(f"No server on {options.host}:{options.port}", file=sys.stderr)
+            return 1
+
+        failed = False
+        for clients in (int(count) for count in options.clients.split(",")):
+            result, errors = run_case(options, clients)
+            print("LOAD " + json.dumps(result, separators=(",", ":")), flush=True)
+            for error in errors:
+                print(f"  client error: {error}", file=sys.stderr)
+            if errors or result["cmds_per_s"] < options.min_rate:
+                failed = True
+        return 1 if failed else 0
+    finally:
+        if process is not None:
+            process.terminate()
+            process.wait()
+
+
+if __name__ == "__main__":
+    sys.exit(main())
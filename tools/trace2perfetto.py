@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+"""Convert a trace_ring dump to Chrome/Perfetto trace JSON.
+
+The firmware writes the dump as "TRACE ..." lines (see
+components/trace_ring/include/trace_ring.h) on the serial port or as UDP
+datagrams. Lines may carry a serial monitor prefix; everything else in the
+input is ignored, and several dumps in one input are merged.
+
+    idf.py monitor | tee serial.log             # or: nc -ul 9999 > serial.log
+    tools/trace2perfetto.py serial.log -o trace.json
+
+Open trace.json in https://ui.perfetto.dev or chrome://tracing. Each core is
+one track; timestamps are esp_timer microseconds since boot.
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+EVENT = struct.Struct("<IHHI")  # cycles, id | kind, unused, arg
+KIND_BEGIN = 0x4000
+KIND_END = 0x8000
+ID_MASK = 0x3FFF
+WRAP = 1 << 32
+
+
+def signed_delta(later, earlier):
+    """Cycles from earlier to later, modulo 2^32, as a signed number."""
+    delta = (later - earlier) % WRAP
+    return delta - WRAP if delta >= WRAP // 2 else delta
+
+
+class Converter:
+    def __init__(self):
+        self.names = {}
+        self.events = []
+        self.cores = set()
+        self.cpu_mhz = 240
+        self.sync = {}     # core -> (cycles, us) of the current dump
+        self.pending = {}  # core -> events of the current dump, oldest first
+
+    def line(self, text):
+        start = text.find("TRACE ")
+        if start < 0:
+            return
+        fields = text[start:].split()
+        if len(fields) < 2:
+            return
+        kind, args = fields[1], fields[2:]
+        try:
+            if kind == "BEGIN":
+                self.cpu_mhz = int(args[0]) or self.cpu_mhz
+                self.sync.clear()
+                self.pending.clear()
+            elif kind == "NAME":
+                self.names[int(args[0])] = " ".join(args[1:])
+            elif kind == "SYNC":
+                self.sync[int(args[0])] = (int(args[1]), int(args[2]))
+            elif kind == "EV":
+                core = int(args[0])
+                raw = bytes.fromhex(args[1]) if len(args) > 1 else b""
+                self.pending.setdefault(core, []).extend(
+                    EVENT.unpack_from(raw, offset)
+                    for offset in range(0, len(raw) - EVENT.size + 1, EVENT.size))
+            elif kind == "END":
+                self.flush()
+        except (IndexError, ValueError) as error:
+            print(f"skipping malformed line: {text.strip()} ({error})", file=sys.stderr)
+
+    def flush(self):
+        for core, events in self.pending.items():
+            if core not in self.sync or not events:
+                continue
+            sync_cycles, sync_us = self.sync[core]
+
+            # Walk back from the SYNC point so counter wraps do not matter
+            # as long as consecutive events are less than one wrap apart
+            position = -signed_delta(sync_cycles, events[-1][0])
+            offsets = [0] * len(events)
+            offsets[-1] = position
+            for i in range(len(events) - 2, -1, -1):
+                position -= signed_delta(events[i + 1][0], events[i][0])
+                offsets[i] = position
+
+            self.cores.add(core)
+            for (cycles, ident, _, arg), offset in zip(events, offsets):
+                event_id = ident & ID_MASK
+                record = {
+                    "name": self.names.get(event_id, f"event_{event_id}"),
+                    "ts": sync_us + offset / self.cpu_mhz,
+                    "pid": 0,
+                    "tid": core,
+                    "args": {"arg": arg},
+                }
+                if ident & KIND_BEGIN:
+                    record["ph"] = "B"
+                elif ident & KIND_END:
+                    record["ph"] = "E"
+                else:
+                    record["ph"] = "i"
+                    record["s"] = "t"
+                self.events.append(record)
+        self.pending.clear()
+
+    def trace(self):
+        metadata = [{"name": "thread_name", "ph": "M", "pid": 0, "tid": core,
+                     "args": {"name": f"core {core}"}} for core in sorted(self.cores)]
+        events = sorted(self.events, key=lambda event: (event["tid"], event["ts"]))
+        return {"traceEvents": metadata + events, "displayTimeUnit": "ns"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", nargs="*", help="dump files (default: stdin)")
+    parser.add_argument("-o", "--output", help="JSON file (default: stdout)")
+    options = parser.parse_args()
+
+    converter = Converter()
+    for path in options.input or ["-"]:
+        stream = sys.stdin if path == "-" else open(path, errors="replace")
+        with stream:
+            for text in stream:
+                converter.line(text)
+    converter.flush()  # A dump cut short still yields its complete lines
+
+    trace = converter.trace()
+    if options.output:
+        with open(options.output, "w") as output:
+            json.dump(trace, output)
+    else:
+        json.dump(trace, sys.stdout)
+        sys.stdout.write("\n")
+    print(f"{len(converter.events)} events on {len(converter.cores)} core(s)", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,238 @@
+#!/usr/bin/env python3
+"""Round-trip latency of the d-microros-wifi LED node at increasing rates.
+
+Runs as a ROS 2 node on the machine that hosts the micro-ROS agent. For each
+rate it publishes alternating on/off commands on /led_control for a fixed
+time and matches them with the transitions the board reports on /led_state:
+
+    rtt  command published -> /led_state transition received here
+    gpio command published -> GPIO write, from the /led_state stamp (the
+         board's clock is synchronized to the agent, which runs on this
+         machine, so both ends use the same clock)
+
+/led_state goes out from the status timer, so rtt includes up to one
+status period (*Maximum /led_status publish rate*, 20 Hz by default).
+Prints one line per rate:
+
+    RTT {"rate_hz":10,"sent":100,"received":100,"lost":0,"delivery":1.0,
+         "rtt_mean_ms":33.4,"rtt_p50_ms":31.2,"rtt_p99_ms":58.0,
+         "gpio_mean_ms":6.8,"gpio_p50_ms":6.1,"gpio_p99_ms":14.9}
+
+A command that produced no transition before the next one with the same
+state was answered counts as lost. Needs a sourced ROS 2 environment with
+esp32_interfaces built (see d-microros-wifi/README.md) and the board
+connected to the agent:
+
+    ros2 run micro_ros_agent micro_ros_agent udp4 --port 8888 &
+    tools/uros_latency.py --rates 1,5,10,20,50 --duration 10
+
+--loss repeats every rate with netem dropping that percentage of the
+packets the agent host sends on --interface (needs tc and CAP_NET_ADMIN;
+the qdisc is removed at exit). --qos only labels the output with the
+firmware's QoS setting; tools/uros_qos_bench.py builds and flashes each
+setting in turn:
+
+    sudo -E tools/uros_latency.py --interface wlan0 --loss 0,10,20 --qos reliable
+
+Exits with 1 if a rate received nothing or a p99 is above --max-p99-ms
+(checked without injected loss only).
+"""
+
+import argparse
+import json
+import math
+import subprocess
+import sys
+import threading
+import time
+
+
+def percentile(values, fraction):
+    """Nearest-rank percentile of a list (None if empty)."""
+    if not values:
+        return None
+    ordered = sorted(values)
+    return ordered[max(0, math.ceil(fraction * len(ordered)) - 1)]
+
+
+def mean(values):
+    """Arithmetic mean of a list (None if empty)."""
+    return sum(values) / len(values) if values else None
+
+
+def ms(value):
+    return None if value is None else round(value, 2)
+
+
+def set_loss(interface, percent):
+    """Drop percent of the packets leaving interface (0 removes the qdisc)."""
+    if percent > 0:
+        command = ["tc", "qdisc", "replace", "dev", interface, "root", "netem", "loss", f"{percent:g}%"]
+    else:
+        command = ["tc", "qdisc", "del", "dev", interface, "root", "netem"]
+    result = subprocess.run(command, capture_output=True, text=True)
+    if result.returncode != 0 and percent > 0:
+        sys.exit(f"{' '.join(command)}: {result.stderr.strip()}")
+
+
+class Matcher:
+    """Pairs sent commands with reported transitions, oldest first."""
+
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.outstanding = []  # (sent_ns, state)
+        self.rtt_ms = []
+        self.gpio_ms = []
+        self.sent = 0
+        self.received = 0
+        self.lost = 0
+
+    def command(self, state, sent_ns):
+        with self.lock:
+            self.outstanding.append((sent_ns, state))
+            self.sent += 1
+
+    def transition(self, state, stamp_ns, received_ns):
+        with self.lock:
+            # Commands before the first one with this state were not applied
+            while self.outstanding and self.outstanding[0][1] != state:
+                self.outstanding.pop(0)
+                self.lost += 1
+            if not self.outstanding:
+                return  # A transition nobody asked for (another publisher, a BLINK)
+            sent_ns, _ = self.outstanding.pop(0)
+            self.received += 1
+            self.rtt_ms.append((received_ns - sent_ns) / 1e6)
+            if stamp_ns > 0:
+                self.gpio_ms.append((stamp_ns - sent_ns) / 1e6)
+
+    def finish(self):
+        with self.lock:
+            self.lost += len(self.outstanding)
+            self.outstanding.clear()
+
+    def result(self, rate):
+        return {
+            "rate_hz": int(rate) if float(rate).is_integer() else rate,
+            "sent": self.sent,
+            "received": self.received,
+            "lost": self.lost,
+            "delivery": round(self.received / self.sent, 3) if self.sent else 0.0,
+            "rtt_mean_ms": ms(mean(self.rtt_ms)),
+            "rtt_p50_ms": ms(percentile(self.rtt_ms, 0.50)),
+            "rtt_p99_ms": ms(percentile(self.rtt_ms, 0.99)),
+            "gpio_mean_ms": ms(mean(self.gpio_ms)),
+            "gpio_p50_ms": ms(percentile(self.gpio_ms, 0.50)),
+            "gpio_p99_ms": ms(percentile(self.gpio_ms, 0.99)),
+        }
+
+
+class LatencyClient:
+    def __init__(self, rclpy, node, matcher_factory):
+        # Imported here so --help works without a ROS 2 environment
+        from rclpy.qos import QoSProfile, ReliabilityPolicy
+        from std_msgs.msg import Bool
+        from esp32_interfaces.msg import LedState
+
+        self.rclpy = rclpy
+        self.node = node
+        self.Bool = Bool
+        self.matcher_factory = matcher_factory
+        self.matcher = matcher_factory()
+
+        # A reliable writer matches reliable and best-effort readers on the
+        # board; a best-effort reader matches either kind of writer
+        self.publisher = node.create_publisher(
+            Bool, "/led_control", QoSProfile(depth=100, reliability=ReliabilityPolicy.RELIABLE))
+        node.create_subscription(
+            LedState, "/led_state", self.on_state,
+            QoSProfile(depth=100, reliability=ReliabilityPolicy.BEST_EFFORT))
+
+    def on_state(self, msg):
+        received_ns = time.time_ns()
+        stamp_ns = msg.stamp.sec * 1_000_000_000 + msg.stamp.nanosec
+        self.matcher.transition(bool(msg.state), stamp_ns, received_ns)
+
+    def spin_for(self, seconds):
+        end = time.monotonic() + seconds
+        while time.monotonic() < end:
+            self.rclpy.spin_once(self.node, timeout_sec=max(0.0, min(0.005, end - time.monotonic())))
+
+    def run(self, rate, duration, settle):
+        # Start from a known state: the first command turns the LED on
+        msg = self.Bool()
+        msg.data = False
+        self.publisher.publish(msg)
+        self.spin_for(settle)
+
+        self.matcher = self.matcher_factory()
+        period = 1.0 / rate
+        count = max(1, int(rate * duration))
+        state = False
+        next_send = time.monotonic()
+        for _ in range(count):
+            self.spin_for(max(0.0, next_send - time.monotonic()))
+            state = not state
+            msg = self.Bool()
+            msg.data = state
+            self.matcher.command(state, time.time_ns())
+            self.publisher.publish(msg)
+            next_send += period
+        self.spin_for(settle)  # Late transitions still count
+        self.matcher.finish()
+        return self.matcher.result(rate)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--rates", default="1,5,10,20,50", help="command rates in Hz, comma separated")
+    parser.add_argument("--duration", type=float, default=10.0, help="seconds per rate")
+    parser.add_argument("--settle", type=float, default=1.0, help="seconds to wait for late transitions")
+    parser.add_argument("--discovery", type=float, default=3.0, help="seconds to wait for the board's topics")
+    parser.add_argument("--max-p99-ms", type=float, help="fail if a round-trip p99 is above this")
+    parser.add_argument("--loss", default="0", help="injected loss in percent, comma separated")
+    parser.add_argument("--interface", help="interface towards the board, for --loss")
+    parser.add_argument("--qos", default="", help="label for the firmware's QoS setting")
+    args = parser.parse_args()
+
+    losses = [float(x) for x in args.loss.split(",")]
+    if any(losses) and not args.interface:
+        parser.error("--loss needs --interface")
+
+    try:
+        import rclpy
+    except ImportError:
+        sys.exit("rclpy not found: source the ROS 2 environment first")
+
+    rclpy.init()
+    node = rclpy.create_node("uros_latency")
+    client = LatencyClient(rclpy, node, Matcher)
+    client.spin_for(args.discovery)
+
+    failed = False
+    try:
+        for loss in losses:
+            if args.interface:
+                set_loss(args.interface, loss)
+            for rate in [float(r) for r in args.rates.split(",")]:
+                result = client.run(rate, args.duration, args.settle)
+                if args.qos:
+                    result["qos"] = args.qos
+                result["loss_pct"] = int(loss) if loss.is_integer() else loss
+                print("RTT " + json.dumps(result), flush=True)
+                if result["received"] == 0:
+                    print(f"no transitions received at {rate:g} Hz, {loss:g}% loss", file=sys.stderr)
+                    failed = True
+                elif loss == 0 and args.max_p99_ms is not None and result["rtt_p99_ms"] > args.max_p99_ms:
+                    print(f"p99 {result['rtt_p99_ms']} ms above {args.max_p99_ms} ms at {rate:g} Hz", file=sys.stderr)
+                    failed = True
+    finally:
+        if args.interface:
+            set_loss(args.interface, 0)
+        node.destroy_node()
+        rclpy.shutdown()
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""Compare reliable and best-effort QoS of the d-microros-wifi LED node.
+
+For each QoS setting the script builds d-microros-wifi with that setting
+for /led_control and /led_state (*micro-ROS LED -> Topic QoS*), flashes it,
+waits for the board to reach the agent and runs tools/uros_latency.py at
+every --loss level. Each setting gets its own build directory and
+sdkconfig, so the project's own build and sdkconfig are left alone. Ends
+with one row per setting, loss and rate:
+
+    qos           loss  rate  delivery  rtt mean  rtt p50  rtt p99  gpio p50  gpio p99
+    reliable       10%    20     1.000      63.7     41.0    212.4      12.1     188.3
+    best_effort    10%    20     0.902      33.1     30.8     57.9       5.9      15.2
+
+Run it on the agent host with ESP-IDF exported, a sourced ROS 2
+environment, the agent running and the rights to change the qdisc of
+--interface (netem drops packets the agent host sends to the board):
+
+    sudo -E tools/uros_qos_bench.py --port /dev/ttyUSB0 --interface wlan0
+
+Exits with 1 if a build, a flash or a latency run fails.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import time
+
+TOOLS_DIR = os.path.dirname(os.path.abspath(__file__))
+PROJECT_DIR = os.path.join(TOOLS_DIR, "..", "d-microros-wifi")
+
+# sdkconfig lines per setting, on top of the project's sdkconfig.defaults
+QOS_SETTINGS = {
+    "reliable": [
+        "# CONFIG_MICROROS_LED_CONTROL_BEST_EFFORT is not set",
+        "# CONFIG_MICROROS_LED_STATE_BEST_EFFORT is not set",
+    ],
+    "best_effort": [
+        "CONFIG_MICROROS_LED_CONTROL_BEST_EFFORT=y",
+        "CONFIG_MICROROS_LED_STATE_BEST_EFFORT=y",
+    ],
+}
+
+
+def build_and_flash(qos, port):
+    build_dir = os.path.join(PROJECT_DIR, "build", f"qos-{qos}")
+    os.makedirs(build_dir, exist_ok=True)
+    overlay = os.path.join(build_dir, "sdkconfig.qos")
+    with open(overlay, "w") as out:
+        out.write("\n".join(QOS_SETTINGS[qos]) + "\n")
+
+    command = ["idf.py", "-C", PROJECT_DIR, "-B", build_dir,
+               "-D", f"SDKCONFIG={os.path.join(build_dir, 'sdkconfig')}",
+               "-D", f"SDKCONFIG_DEFAULTS={os.path.join(PROJECT_DIR, 'sdkconfig.defaults')};{overlay}",
+               "-p", port, "build", "flash"]
+    print(" ".join(command), file=sys.stderr, flush=True)
+    return subprocess.run(command).returncode == 0
+
+
+def run_latency(qos, args):
+    command = [sys.executable, os.path.join(TOOLS_DIR, "uros_latency.py"),
+               "--rates", args.rates, "--duration", str(args.duration),
+               "--loss", args.loss, "--interface", args.interface, "--qos", qos]
+    result = subprocess.run(command, stdout=subprocess.PIPE, text=True)
+    rows = []
+    for line in result.stdout.splitlines():
+        print(line, flush=True)
+        if line.startswith("RTT {"):
+            rows.append(json.loads(line[4:]))
+    return result.returncode == 0, rows
+
+
+def cell(value, width):
+    return f"{'-' if value is None else value:>{width}}"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--port", required=True, help="serial port of the board")
+    parser.add_argument("--interface", required=True, help="interface of the agent host towards the board")
+    parser.add_argument("--qos", default="reliable,best_effort", help="settings to compare, comma separated")
+    parser.add_argument("--loss", default="0,5,10,20", help="injected loss in percent, comma separated")
+    parser.add_argument("--rates", default="10,20,50", help="command rates in Hz, comma separated")
+    parser.add_argument("--duration", type=float, default=10.0, help="seconds per rate and loss level")
+    parser.add_argument("--boot", type=float, default=15.0, help="seconds from flashing to the agent session")
+    args = parser.parse_args()
+
+    rows = []
+    failed = False
+    for qos in args.qos.split(","):
+        if qos not in QOS_SETTINGS:
+            parser.error(f"unknown QoS setting {qos} (use {', '.join(QOS_SETTINGS)})")
+        if not build_and_flash(qos, args.port):
+            sys.exit(f"{qos}: build or flash failed")
+        time.sleep(args.boot)
+        ok, qos_rows = run_latency(qos, args)
+        failed |= not ok
+        rows += qos_rows
+
+    print(f"\n{'qos':<12} {'loss':>5} {'rate':>5} {'delivery':>9} {'rtt mean':>9} {'rtt p50':>8} {'rtt p99':>8} "
+          f"{'gpio p50':>9} {'gpio p99':>9}")
+    for row in rows:
+        print(f"{row['qos']:<12} {str(row['loss_pct']) + '%':>5} {cell(row['rate_hz'], 5)} "
+              f"{row['delivery']:>9.3f} {cell(row['rtt_mean_ms'], 9)} {cell(row['rtt_p50_ms'], 8)} "
+              f"{cell(row['rtt_p99_ms'], 8)} "
+              f"{cell(row['gpio_p50_ms'], 9)} {cell(row['gpio_p99_ms'], 9)}")
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()